@@ -0,0 +1,161 @@
+#ifndef MODERN_ODBC_ASYNC_LOGGER_H
+#define MODERN_ODBC_ASYNC_LOGGER_H
+
+/**
+ * @file async_logger.h
+ * @brief A line logger whose callers never wait for I/O.
+ *
+ * log() pushes the line into a bounded lock-free queue and returns; a
+ * background thread hands queued lines to the sink (std::cerr, a file, or any
+ * callable). If the writer falls behind and the queue fills up, new lines are
+ * dropped and counted rather than blocking the caller, so the logger can be
+ * used on request paths.
+ */
+
+#include "mpmc_queue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace odbc {
+
+/**
+ * @class AsyncLogger
+ * @brief Writes lines to a sink on a background thread.
+ *
+ * The destructor writes every line that is still queued, then joins the writer.
+ */
+class AsyncLogger {
+public:
+    /// Receives one line at a time, without the trailing newline, on the writer thread.
+    using Sink = std::move_only_function<void(std::string_view)>;
+
+    explicit AsyncLogger(Sink sink = stderr_sink(), std::size_t capacity = 4096);
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    /**
+     * @brief Queues a line without blocking.
+     * @return false if the queue was full and the line was dropped.
+     */
+    bool log(std::string line) noexcept;
+
+    /**
+     * @brief Waits until every line queued before the call has been written.
+     */
+    void flush();
+
+    /**
+     * @brief Number of lines dropped because the queue was full or the sink threw.
+     */
+    [[nodiscard]] std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] static Sink stderr_sink();
+
+    /**
+     * @brief A sink appending lines to a file.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    [[nodiscard]] static Sink file_sink(const std::filesystem::path& path);
+
+private:
+    Sink m_sink;
+    MpmcQueue<std::string> m_queue;
+    std::atomic<std::uint32_t> m_work_signal{0};
+    std::atomic<std::uint64_t> m_queued{0};
+    std::atomic<std::uint64_t> m_written{0};   // lines written or dropped by the writer
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<bool> m_stopping{false};
+    std::jthread m_writer;   // last: started after every other member
+
+    void writer_loop();
+};
+
+
+// --- Implementation ---
+
+inline AsyncLogger::AsyncLogger(Sink sink, std::size_t capacity)
+    : m_sink(std::move(sink)), m_queue(capacity), m_writer([this] { writer_loop(); }) {}
+
+inline AsyncLogger::~AsyncLogger() {
+    m_stopping.store(true, std::memory_order_release);
+    m_work_signal.fetch_add(1, std::memory_order_release);
+    m_work_signal.notify_one();
+    m_writer.join();
+}
+
+inline bool AsyncLogger::log(std::string line) noexcept {
+    if (!m_queue.try_push(std::move(line))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+    m_work_signal.fetch_add(1, std::memory_order_release);
+    m_work_signal.notify_one();
+    return true;
+}
+
+inline void AsyncLogger::flush() {
+    const std::uint64_t target = m_queued.load(std::memory_order_acquire);
+    for (std::uint64_t written = m_written.load(std::memory_order_acquire); written < target;
+         written = m_written.load(std::memory_order_acquire)) {
+        m_written.wait(written, std::memory_order_acquire);
+    }
+}
+
+inline void AsyncLogger::writer_loop() {
+    for (;;) {
+        // Read the signal before draining: a line queued after the drain changes it, so wait() returns.
+        const std::uint32_t observed = m_work_signal.load(std::memory_order_acquire);
+        bool wrote = false;
+        while (auto line = m_queue.try_pop()) {
+            try {
+                m_sink(*line);
+            } catch (...) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_written.fetch_add(1, std::memory_order_release);
+            wrote = true;
+        }
+        if (wrote) {
+            m_written.notify_all();
+            continue;
+        }
+        if (m_stopping.load(std::memory_order_acquire)) {
+            return;
+        }
+        m_work_signal.wait(observed, std::memory_order_acquire);
+    }
+}
+
+inline AsyncLogger::Sink AsyncLogger::stderr_sink() {
+    return [](std::string_view line) {
+        std::cerr << line << '\n';
+    };
+}
+
+inline AsyncLogger::Sink AsyncLogger::file_sink(const std::filesystem::path& path) {
+    auto out = std::make_unique<std::ofstream>(path, std::ios::app);
+    if (!*out) {
+        throw std::runtime_error("AsyncLogger: cannot open log file '" + path.string() + "'.");
+    }
+    return [out = std::move(out)](std::string_view line) {
+        *out << line << '\n';
+        out->flush();
+    };
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_ASYNC_LOGGER_H
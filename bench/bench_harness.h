@@ -0,0 +1,162 @@
+// Minimal benchmark harness for the bench/ programs.
+//
+// A benchmark is a body that runs a given number of operations. The harness
+// runs it for a few warm-up repetitions (not recorded), then for a fixed number
+// of timed repetitions, and summarizes the time per operation over the
+// repetitions: min, median, mean, p95, max and standard deviation. Results can
+// be printed as a table and written as JSON for comparison between runs.
+
+#ifndef MODERN_ODBC_BENCH_HARNESS_H
+#define MODERN_ODBC_BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+struct Options {
+    std::size_t warmup = 2;
+    std::size_t repetitions = 10;
+    std::string filter;   // run only benchmarks whose name contains this
+};
+
+struct Summary {
+    double min_ns = 0;
+    double median_ns = 0;
+    double mean_ns = 0;
+    double p95_ns = 0;
+    double max_ns = 0;
+    double stddev_ns = 0;
+
+    static Summary of(std::vector<double> samples) {
+        Summary s;
+        if (samples.empty()) return s;
+        std::ranges::sort(samples);
+        auto at = [&](double q) {
+            // Linear interpolation between the closest ranks.
+            const double rank = q * static_cast<double>(samples.size() - 1);
+            const auto lower = static_cast<std::size_t>(rank);
+            const auto upper = std::min(lower + 1, samples.size() - 1);
+            return samples[lower] + (samples[upper] - samples[lower]) * (rank - static_cast<double>(lower));
+        };
+        s.min_ns = samples.front();
+        s.max_ns = samples.back();
+        s.median_ns = at(0.5);
+        s.p95_ns = at(0.95);
+        s.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+        double squares = 0;
+        for (double v : samples) squares += (v - s.mean_ns) * (v - s.mean_ns);
+        s.stddev_ns = samples.size() > 1 ? std::sqrt(squares / static_cast<double>(samples.size() - 1)) : 0.0;
+        return s;
+    }
+};
+
+struct Result {
+    std::string name;
+    std::size_t operations = 0;   // per repetition
+    std::size_t repetitions = 0;
+    std::size_t items_per_operation = 1;   // rows, bytes... reported as items/s
+    std::string items_unit;
+    Summary ns_per_operation;
+};
+
+class Suite {
+public:
+    // The body runs `operations` operations; it may throw to fail the benchmark.
+    using Body = std::function<void(std::size_t operations)>;
+
+    explicit Suite(Options options) : m_options(std::move(options)) {}
+
+    void add(std::string name, std::size_t operations, Body body, std::size_t items_per_operation = 1, std::string items_unit = {}) {
+        m_benchmarks.push_back({std::move(name), operations, std::move(body), items_per_operation, std::move(items_unit)});
+    }
+
+    // Runs every selected benchmark in registration order; a failing one is reported and skipped.
+    const std::vector<Result>& run() {
+        for (auto& b : m_benchmarks) {
+            if (!m_options.filter.empty() && b.name.find(m_options.filter) == std::string::npos) continue;
+            try {
+                for (std::size_t i = 0; i < m_options.warmup; ++i) b.body(b.operations);
+                std::vector<double> samples;
+                for (std::size_t i = 0; i < m_options.repetitions; ++i) {
+                    const auto start = std::chrono::steady_clock::now();
+                    b.body(b.operations);
+                    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+                    samples.push_back(elapsed.count() / static_cast<double>(b.operations));
+                }
+                m_results.push_back({b.name, b.operations, m_options.repetitions, b.items_per_operation, b.items_unit,
+                                     Summary::of(std::move(samples))});
+                print(m_results.back());
+            } catch (const std::exception& e) {
+                std::cerr << std::format("{:<32} FAILED: {}\n", b.name, e.what());
+            }
+        }
+        return m_results;
+    }
+
+    static void print_header() {
+        std::cout << std::format("{:<32} {:>12} {:>12} {:>12} {:>12} {:>8} {:>16}\n",
+                                 "benchmark", "median", "mean", "p95", "min", "cv%", "throughput");
+    }
+
+    void write_json(const std::string& path, std::string_view context) const {
+        std::ofstream out(path);
+        if (!out) throw std::runtime_error("Cannot open '" + path + "' for writing.");
+        out << std::format("{{\n  \"context\": {},\n  \"warmup\": {},\n  \"repetitions\": {},\n  \"results\": [",
+                           context, m_options.warmup, m_options.repetitions);
+        for (std::size_t i = 0; i < m_results.size(); ++i) {
+            const Result& r = m_results[i];
+            const Summary& s = r.ns_per_operation;
+            out << std::format("{}\n    {{\"name\": \"{}\", \"operations\": {}, \"repetitions\": {}, \"items_per_operation\": {}, "
+                               "\"items_unit\": \"{}\", \"ns_per_operation\": {{\"min\": {:.1f}, \"median\": {:.1f}, "
+                               "\"mean\": {:.1f}, \"p95\": {:.1f}, \"max\": {:.1f}, \"stddev\": {:.1f}}}}}",
+                               i == 0 ? "" : ",", r.name, r.operations, r.repetitions, r.items_per_operation, r.items_unit,
+                               s.min_ns, s.median_ns, s.mean_ns, s.p95_ns, s.max_ns, s.stddev_ns);
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    struct Benchmark {
+        std::string name;
+        std::size_t operations;
+        Body body;
+        std::size_t items_per_operation;
+        std::string items_unit;
+    };
+
+    Options m_options;
+    std::vector<Benchmark> m_benchmarks;
+    std::vector<Result> m_results;
+
+    static std::string duration(double ns) {
+        if (ns < 1e3) return std::format("{:.1f} ns", ns);
+        if (ns < 1e6) return std::format("{:.2f} us", ns / 1e3);
+        return std::format("{:.2f} ms", ns / 1e6);
+    }
+
+    static void print(const Result& r) {
+        const Summary& s = r.ns_per_operation;
+        const double per_second = s.median_ns > 0 ? 1e9 * static_cast<double>(r.items_per_operation) / s.median_ns : 0.0;
+        const std::string unit = r.items_unit.empty() ? "ops" : r.items_unit;
+        std::cout << std::format("{:<32} {:>12} {:>12} {:>12} {:>12} {:>8.1f} {:>12.0f} {}/s\n", r.name, duration(s.median_ns),
+                                 duration(s.mean_ns), duration(s.p95_ns), duration(s.min_ns),
+                                 s.mean_ns > 0 ? 100.0 * s.stddev_ns / s.mean_ns : 0.0, per_second, unit);
+    }
+};
+
+} // namespace bench
+
+#endif // MODERN_ODBC_BENCH_HARNESS_H
@@ -0,0 +1,116 @@
+// Benchmark harness for the instrumentation policies.
+//
+// Runs the same execute / fetch-all / get_data loop on one thread with straight
+// ODBC calls, BasicStatement<NullInstrumentation>, BasicStatement<TraceInstrumentation>
+// with tracing off and on, and BasicStatement<StandardInstrumentation> (latency
+// metrics). The null policy should be indistinguishable from the raw loop, and
+// tracing off should cost no more than noise.
+//
+// Usage: instrumentation_bench [iterations]
+// The connection string is taken from the ODBC_BENCH_CONNECTION environment variable,
+// the query (first column must be an integer) from ODBC_BENCH_QUERY (default "SELECT 1").
+
+#include "odbc_wrapper.h"
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct RunResult {
+    double seconds = 0;
+    long long checksum = 0;   // keeps the reads from being optimized away
+};
+
+RunResult run_raw(const odbc::Environment& env, const std::string& connection_string, const std::string& query, std::size_t iterations) {
+    odbc::BasicConnection<odbc::NullInstrumentation> conn(env);
+    if (!conn.driver_connect(connection_string)) throw std::runtime_error("raw: connect failed");
+    SQLHSTMT stmt = nullptr;
+    if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, conn.get(), &stmt))) throw std::runtime_error("raw: SQLAllocHandle failed");
+
+    std::string text = query;
+    RunResult result;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        if (!SQL_SUCCEEDED(SQLExecDirect(stmt, reinterpret_cast<SQLCHAR*>(text.data()), static_cast<SQLINTEGER>(text.size())))) {
+            SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+            throw std::runtime_error("raw: SQLExecDirect failed");
+        }
+        while (SQL_SUCCEEDED(SQLFetch(stmt))) {
+            long long value = 0;
+            SQLLEN indicator = 0;
+            if (SQL_SUCCEEDED(SQLGetData(stmt, 1, SQL_C_SBIGINT, &value, sizeof(value), &indicator)) && indicator != SQL_NULL_DATA) {
+                result.checksum += value;
+            }
+        }
+        SQLFreeStmt(stmt, SQL_CLOSE);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    return result;
+}
+
+template <typename Instrumentation>
+RunResult run_wrapped(const odbc::Environment& env, const std::string& connection_string, const std::string& query, std::size_t iterations) {
+    odbc::BasicConnection<Instrumentation> conn(env);
+    if (!conn.driver_connect(connection_string)) throw std::runtime_error("wrapped: connect failed");
+    odbc::BasicStatement<Instrumentation> stmt(conn);
+    stmt.set_metrics_label("bench");
+
+    RunResult result;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        if (!stmt.execute_direct(query)) throw std::runtime_error("wrapped: execute_direct failed");
+        while (stmt.fetch().value_or(false)) {
+            result.checksum += stmt.template get_data<long long>(1).value_or(std::nullopt).value_or(0);
+        }
+        (void)stmt.close_cursor();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* env_conn = std::getenv("ODBC_BENCH_CONNECTION");
+    if (env_conn == nullptr) {
+        std::cerr << "Set ODBC_BENCH_CONNECTION to an ODBC connection string.\n";
+        return 1;
+    }
+    const std::string connection_string = env_conn;
+    const char* env_query = std::getenv("ODBC_BENCH_QUERY");
+    const std::string query = env_query != nullptr ? env_query : "SELECT 1";
+    const std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    try {
+        odbc::Environment env;
+        // Warm up the driver and the server's plan cache.
+        (void)run_raw(env, connection_string, query, iterations / 10 + 1);
+
+        const RunResult raw = run_raw(env, connection_string, query, iterations);
+        const RunResult null = run_wrapped<odbc::NullInstrumentation>(env, connection_string, query, iterations);
+        odbc::set_tracing(false);
+        const RunResult off = run_wrapped<odbc::TraceInstrumentation>(env, connection_string, query, iterations);
+        odbc::set_tracing(true);
+        const RunResult on = run_wrapped<odbc::TraceInstrumentation>(env, connection_string, query, iterations);
+        odbc::set_tracing(false);
+        const RunResult metrics = run_wrapped<odbc::StandardInstrumentation>(env, connection_string, query, iterations);
+
+        std::cout << std::format("query: {}  iterations: {}\n", query, iterations);
+        const std::pair<const char*, const RunResult*> results[] = {
+            {"raw ODBC", &raw}, {"null policy", &null}, {"trace, off", &off}, {"trace, on", &on}, {"metrics", &metrics}};
+        for (const auto& [name, r] : results) {
+            std::cout << std::format("{:<12} {:>10.0f} ns/iteration  {:+6.2f}% vs raw  (checksum {})\n", name,
+                                     r->seconds * 1e9 / static_cast<double>(iterations),
+                                     100.0 * (r->seconds - raw.seconds) / raw.seconds, r->checksum);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
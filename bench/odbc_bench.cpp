@@ -0,0 +1,257 @@
+// Benchmark suite for the wrapper's hot paths, built and run by `make bench`.
+//
+// Covers a prepared single-row lookup, get_data() per C type over a 1000-row
+// scan, string fetch across size distributions, connect latency, the pool hit
+// paths (thread-local statement, sharded lease) and bulk insert with parameter
+// arrays against row-by-row inserts. Every benchmark is warmed up, then
+// repeated; the table shows the spread per operation and --json writes the
+// full summaries for comparison between runs.
+//
+// It creates its own tables (bench_rows, bench_strings, bench_insert), so any
+// scratch database works. The default is a local SQLite file through
+// unixODBC's "SQLite3" driver (libsqliteodbc), which needs no server.
+//
+// Usage: odbc_bench [--json FILE] [--filter TEXT] [--warmup N] [--repetitions N]
+// The connection string is taken from the ODBC_BENCH_CONNECTION environment
+// variable. `make bench` sets it from the BENCH_CONNECTION make variable, e.g.
+//   make bench BENCH_CONNECTION="Driver=...;Server=..."
+//   ODBC_BENCH_CONNECTION="Driver=...;Server=..." ./odbc_bench
+
+#include "bench_harness.h"
+#include "bulk.h"
+#include "sharded_connection_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view default_connection = "Driver=SQLite3;Database=odbc_bench.db";
+constexpr std::size_t scan_rows = 1000;
+constexpr std::size_t insert_rows = 1000;
+
+template <typename T>
+T check(std::expected<T, odbc::OdbcError> result, std::string_view what) {
+    if (!result) throw std::runtime_error(std::format("{}: {}", what, result.error().to_string()));
+    if constexpr (std::is_void_v<T>) return;
+    else return std::move(*result);
+}
+
+struct StringClass {
+    std::string_view name;
+    std::size_t min_length;
+    std::size_t max_length;
+    bool heavy_tail;   // mostly short, occasionally long
+};
+
+constexpr StringClass string_classes[] = {
+    {"small", 8, 32, false},
+    {"medium", 200, 300, false},
+    {"large", 4000, 8000, false},
+    {"mixed", 8, 8000, true},
+};
+
+// Creates the benchmark tables and returns the total string bytes per size class.
+std::vector<std::size_t> create_schema(odbc::Connection& conn) {
+    odbc::Statement stmt(conn);
+    for (std::string_view table : {"bench_rows", "bench_strings", "bench_insert"}) {
+        check(stmt.execute_direct(std::format("DROP TABLE IF EXISTS {}", table)), "drop table");
+    }
+    check(stmt.execute_direct("CREATE TABLE bench_rows (id INTEGER PRIMARY KEY, i BIGINT, d DOUBLE PRECISION, s VARCHAR(64))"), "create bench_rows");
+    check(stmt.execute_direct("CREATE TABLE bench_strings (id INTEGER PRIMARY KEY, size_class VARCHAR(16), s VARCHAR(8000))"), "create bench_strings");
+    check(stmt.execute_direct("CREATE TABLE bench_insert (id BIGINT, d DOUBLE PRECISION, s VARCHAR(64))"), "create bench_insert");
+
+    std::mt19937_64 random(42);   // fixed seed: the same data on every run
+    check(conn.set_autocommit(false), "autocommit off");
+
+    odbc::ParameterArray rows(4);
+    for (std::size_t id = 1; id <= scan_rows; ++id) {
+        rows.add_row({static_cast<long long>(id), static_cast<long long>(random() % 1000000),
+                      static_cast<double>(random() % 100000) / 100.0, std::format("row-{:08}", id)});
+    }
+    check(stmt.prepare("INSERT INTO bench_rows (id, i, d, s) VALUES (?, ?, ?, ?)"), "prepare bench_rows insert");
+    check(odbc::execute_array(stmt, rows), "load bench_rows");
+
+    std::vector<std::size_t> bytes;
+    odbc::ParameterArray strings(3);
+    long long id = 0;
+    for (const StringClass& c : string_classes) {
+        std::size_t total = 0;
+        for (std::size_t n = 0; n < 200; ++n) {
+            std::size_t length = c.min_length + random() % (c.max_length - c.min_length + 1);
+            if (c.heavy_tail && random() % 20 != 0) length = c.min_length + random() % 64;
+            total += length;
+            strings.add_row({++id, std::string(c.name), std::string(length, static_cast<char>('a' + n % 26))});
+        }
+        bytes.push_back(total);
+    }
+    check(stmt.prepare("INSERT INTO bench_strings (id, size_class, s) VALUES (?, ?, ?)"), "prepare bench_strings insert");
+    check(odbc::execute_array(stmt, strings, 100), "load bench_strings");
+
+    check(conn.commit(), "commit");
+    check(conn.set_autocommit(true), "autocommit on");
+    return bytes;
+}
+
+// Reads every row of a scan through get_data<T>() on one column.
+template <typename T>
+void scan_column(odbc::Statement& stmt, SQLUSMALLINT column, std::size_t operations) {
+    for (std::size_t op = 0; op < operations; ++op) {
+        check(stmt.execute_direct("SELECT i, d, s FROM bench_rows"), "scan");
+        std::size_t rows = 0;
+        while (check(stmt.fetch(), "fetch")) {
+            auto value = check(stmt.get_data<T>(column), "get_data");
+            rows += value.has_value() ? 1 : 0;
+        }
+        check(stmt.close_cursor(), "close_cursor");
+        if (rows != scan_rows) throw std::runtime_error(std::format("scan read {} rows, expected {}", rows, scan_rows));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Options options;
+    std::string json_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--json" && has_value) json_path = argv[++i];
+        else if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--warmup" && has_value) options.warmup = std::stoul(argv[++i]);
+        else if (arg == "--repetitions" && has_value) options.repetitions = std::max<std::size_t>(1, std::stoul(argv[++i]));
+        else {
+            std::cerr << "Usage: odbc_bench [--json FILE] [--filter TEXT] [--warmup N] [--repetitions N]\n";
+            return 1;
+        }
+    }
+    const char* env_conn = std::getenv("ODBC_BENCH_CONNECTION");
+    const std::string connection_string = env_conn != nullptr ? env_conn : std::string(default_connection);
+
+    try {
+        odbc::Environment env;
+        odbc::Connection conn(env);
+        check(conn.driver_connect(connection_string), "connect");
+        const std::string dbms = conn.dbms_name().value_or("unknown");
+        const std::vector<std::size_t> string_bytes = create_schema(conn);
+
+        // Statements live across repetitions: the suite measures the per-operation cost, not setup.
+        odbc::Statement lookup(conn);
+        check(lookup.prepare("SELECT i FROM bench_rows WHERE id = ?"), "prepare lookup");
+        odbc::Statement scan(conn);
+        odbc::Statement strings(conn);
+        check(strings.prepare("SELECT s FROM bench_strings WHERE size_class = ?"), "prepare strings");
+
+        odbc::Connection writer(env);
+        check(writer.driver_connect(connection_string), "connect writer");
+        check(writer.set_autocommit(false), "writer autocommit off");
+        odbc::Statement insert(writer);
+        check(insert.prepare("INSERT INTO bench_insert (id, d, s) VALUES (?, ?, ?)"), "prepare insert");
+        odbc::ParameterArray insert_batch(3);
+        for (std::size_t r = 0; r < insert_rows; ++r) {
+            insert_batch.add_row({static_cast<long long>(r), static_cast<double>(r) / 4.0, std::format("insert-{:06}", r)});
+        }
+
+        ShardingOptions sharding;
+        sharding.mode = ShardingMode::single;
+        sharding.max_connections_per_shard = 1;
+        ShardedConnectionPool pool("BENCH_SHARDED", connection_string, sharding);
+
+        bench::Suite suite(options);
+
+        suite.add("single_row_fetch", 5000, [&](std::size_t operations) {
+            long long checksum = 0;
+            for (std::size_t op = 0; op < operations; ++op) {
+                lookup.bind_parameter(1, static_cast<long long>(op % scan_rows + 1));
+                check(lookup.execute(), "execute lookup");
+                if (!check(lookup.fetch(), "fetch lookup")) throw std::runtime_error("lookup returned no row");
+                checksum += check(lookup.get_data<long long>(1), "get_data").value_or(0);
+                check(lookup.close_cursor(), "close_cursor");
+            }
+            if (checksum == 0) throw std::runtime_error("lookup read only zeros");
+        });
+
+        suite.add("get_data_int64", 20, [&](std::size_t n) { scan_column<long long>(scan, 1, n); }, scan_rows, "rows");
+        suite.add("get_data_double", 20, [&](std::size_t n) { scan_column<double>(scan, 2, n); }, scan_rows, "rows");
+        suite.add("get_data_string", 20, [&](std::size_t n) { scan_column<std::string>(scan, 3, n); }, scan_rows, "rows");
+
+        for (std::size_t c = 0; c < std::size(string_classes); ++c) {
+            const std::string size_class(string_classes[c].name);
+            const std::size_t expected_bytes = string_bytes[c];
+            suite.add("string_fetch_" + size_class, 20, [&, size_class, expected_bytes](std::size_t operations) {
+                for (std::size_t op = 0; op < operations; ++op) {
+                    strings.bind_parameter(1, size_class);
+                    check(strings.execute(), "execute strings");
+                    std::size_t bytes = 0;
+                    while (check(strings.fetch(), "fetch strings")) {
+                        bytes += check(strings.get_data<std::string>(1), "get_data").value_or("").size();
+                    }
+                    check(strings.close_cursor(), "close_cursor");
+                    if (bytes != expected_bytes) throw std::runtime_error(std::format("read {} bytes, expected {}", bytes, expected_bytes));
+                }
+            }, expected_bytes, "bytes");
+        }
+
+        suite.add("connect", 20, [&](std::size_t operations) {
+            for (std::size_t op = 0; op < operations; ++op) {
+                odbc::Connection fresh(env);
+                check(fresh.driver_connect(connection_string), "connect");
+            }
+        });
+
+        suite.add("pool_hit_thread_local", 10000, [&](std::size_t operations) {
+            for (std::size_t op = 0; op < operations; ++op) {
+                auto stmt = getThreadLocalStatement("BENCH_THREAD_LOCAL", connection_string);
+                (void)stmt.get();
+            }
+        });
+
+        suite.add("pool_hit_sharded", 10000, [&](std::size_t operations) {
+            for (std::size_t op = 0; op < operations; ++op) {
+                auto lease = pool.acquire();
+                (void)lease.get();
+            }
+        });
+
+        suite.add("bulk_insert_array", 5, [&](std::size_t operations) {
+            for (std::size_t op = 0; op < operations; ++op) {
+                check(odbc::execute_array(insert, insert_batch), "execute_array");
+                check(writer.commit(), "commit");
+            }
+        }, insert_rows, "rows");
+
+        suite.add("bulk_insert_rowwise", 5, [&](std::size_t operations) {
+            for (std::size_t op = 0; op < operations; ++op) {
+                for (std::size_t r = 0; r < insert_batch.rows(); ++r) {
+                    for (std::size_t c = 0; c < insert_batch.columns(); ++c) {
+                        insert.bind_parameter(static_cast<SQLUSMALLINT>(c + 1), insert_batch.at(r, c));
+                    }
+                    check(insert.execute(), "execute insert");
+                }
+                check(writer.commit(), "commit");
+            }
+        }, insert_rows, "rows");
+
+        std::cout << std::format("dbms: {}  warmup: {}  repetitions: {}\n", dbms, options.warmup, options.repetitions);
+        bench::Suite::print_header();
+        suite.run();
+        if (!json_path.empty()) {
+            suite.write_json(json_path, std::format("{{\"dbms\": \"{}\"}}", dbms));
+            std::cout << std::format("Results written to {}\n", json_path);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Benchmark harness for ShardedConnectionPool.
+//
+// Runs one pinned worker thread per CPU (or per --threads), each doing
+// checkout / "SELECT 1" / fetch / release in a loop, once per sharding mode,
+// and reports throughput and the fraction of checkouts served by a remote shard.
+//
+// Usage: sharded_pool_bench [threads] [iterations]
+// The connection string is taken from the ODBC_BENCH_CONNECTION environment variable.
+
+#include "sharded_connection_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace {
+
+void pin_current_thread(unsigned cpu) {
+#ifdef _WIN32
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (cpu % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+struct RunResult {
+    double seconds = 0;
+    std::size_t operations = 0;
+    std::size_t remote_checkouts = 0;
+};
+
+RunResult run(ShardingMode mode, const std::string& connection_string, unsigned threads, std::size_t iterations) {
+    ShardingOptions options;
+    options.mode = mode;
+    options.max_connections_per_shard = threads;
+    ShardedConnectionPool pool("BENCH", connection_string, options);
+
+    std::atomic<std::size_t> remote{0};
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::jthread> workers;
+
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            pin_current_thread(t % std::max(1u, std::thread::hardware_concurrency()));
+            // Warm up: open this thread's connection on its own node before timing starts.
+            {
+                auto lease = pool.acquire();
+                odbc::Statement stmt(*lease);
+                (void)stmt.execute_direct("SELECT 1");
+            }
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            std::size_t local_remote = 0;
+            for (std::size_t i = 0; i < iterations; ++i) {
+                auto lease = pool.acquire();
+                if (lease.shard() != pool.local_shard()) ++local_remote;
+                odbc::Statement stmt(*lease);
+                if (stmt.execute_direct("SELECT 1")) {
+                    while (stmt.fetch().value_or(false)) {}
+                }
+            }
+            remote.fetch_add(local_remote);
+        });
+    }
+
+    while (ready.load() < threads) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    workers.clear();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {elapsed, threads * iterations, remote.load()};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* env_conn = std::getenv("ODBC_BENCH_CONNECTION");
+    if (env_conn == nullptr) {
+        std::cerr << "Set ODBC_BENCH_CONNECTION to an ODBC connection string.\n";
+        return 1;
+    }
+    const std::string connection_string = env_conn;
+    const unsigned threads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t iterations = argc > 2 ? std::stoul(argv[2]) : 10000;
+
+    const auto& topology = odbc::detail::CpuTopology::instance();
+    std::cout << std::format("CPUs: {}, NUMA nodes: {}, threads: {}, iterations/thread: {}\n",
+                             topology.cpu_to_node.size(), topology.node_count, threads, iterations);
+
+    const std::pair<ShardingMode, const char*> modes[] = {
+        {ShardingMode::single, "single"},
+        {ShardingMode::per_numa_node, "per_numa_node"},
+        {ShardingMode::per_cpu, "per_cpu"},
+    };
+    for (const auto& [mode, name] : modes) {
+        try {
+            RunResult r = run(mode, connection_string, threads, iterations);
+            std::cout << std::format("{:<14} {:>12.0f} ops/s  remote checkouts: {:.2f}%\n", name,
+                                     static_cast<double>(r.operations) / r.seconds,
+                                     100.0 * static_cast<double>(r.remote_checkouts) / static_cast<double>(r.operations));
+        } catch (const std::exception& e) {
+            std::cerr << std::format("{}: {}\n", name, e.what());
+            return 1;
+        }
+    }
+    return 0;
+}
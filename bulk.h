@@ -0,0 +1,476 @@
+#ifndef MODERN_ODBC_BULK_H
+#define MODERN_ODBC_BULK_H
+
+/**
+ * @file bulk.h
+ * @brief Block (array) fetching with column-wise bound buffers.
+ *
+ * SQLFetch plus one SQLGetData call per cell costs a driver round trip per
+ * cell. A BlockCursor binds one array per column and fetches up to block_rows
+ * rows per SQLFetch call (SQL_ATTR_ROW_ARRAY_SIZE), so a block is read with a
+ * single call and then accessed directly from memory.
+ *
+ * The same applies to writes: execute_array() binds a ParameterArray column-wise
+ * and executes a prepared INSERT (or UPDATE) for many rows of parameters with
+ * one SQLExecute call (SQL_ATTR_PARAMSET_SIZE).
+ */
+
+#include "odbc_wrapper.h"
+#include "result_set.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @class BlockCursor
+ * @brief Reads the result of an executed statement in blocks of rows.
+ *
+ * While the cursor is alive it owns the statement's column bindings and row
+ * array attributes; the destructor unbinds them and restores single-row
+ * fetching, so the statement can be reused afterwards.
+ */
+class BlockCursor {
+public:
+    /**
+     * @brief Binds buffers for every result column of an executed statement.
+     *
+     * @param stmt A statement on which a query has been executed; it must outlive the cursor.
+     * @param block_rows Rows fetched per call.
+     * @param max_text_length Longest text value kept per cell; longer values are truncated.
+     */
+    [[nodiscard]] static std::expected<BlockCursor, OdbcError> open(Statement& stmt, std::size_t block_rows = 256,
+                                                                     std::size_t max_text_length = 4096);
+
+    ~BlockCursor();
+    BlockCursor(const BlockCursor&) = delete;
+    BlockCursor& operator=(const BlockCursor&) = delete;
+    BlockCursor(BlockCursor&& other) noexcept;
+    BlockCursor& operator=(BlockCursor&&) = delete;
+
+    /**
+     * @brief Fetches the next block.
+     * @return The number of rows in the block; 0 once the result is exhausted.
+     */
+    [[nodiscard]] std::expected<std::size_t, OdbcError> fetch_block();
+
+    /**
+     * @brief Number of rows in the current block.
+     */
+    [[nodiscard]] std::size_t rows() const noexcept { return static_cast<std::size_t>(*m_rows_fetched); }
+    [[nodiscard]] std::size_t block_rows() const noexcept { return m_block_rows; }
+    [[nodiscard]] std::size_t column_count() const noexcept { return m_columns.size(); }
+    [[nodiscard]] std::string_view column_name(std::size_t column) const { return m_columns[column].name; }
+    [[nodiscard]] ResultSet::ColumnKind column_kind(std::size_t column) const { return m_columns[column].kind; }
+
+    /**
+     * @brief Finds a column by exact name.
+     */
+    [[nodiscard]] std::optional<std::size_t> find_column(std::string_view name) const;
+
+    [[nodiscard]] bool is_null(std::size_t row, std::size_t column) const {
+        return m_columns[column].indicators[row] == SQL_NULL_DATA;
+    }
+
+    /**
+     * @brief Whether a text cell was longer than max_text_length and has been cut off.
+     */
+    [[nodiscard]] bool is_truncated(std::size_t row, std::size_t column) const;
+
+    /**
+     * @brief Reads one cell of the current block, with the same conversions as ResultSet::get.
+     * A std::string_view stays valid until the next fetch_block().
+     */
+    template <typename T>
+    [[nodiscard]] std::optional<T> get(std::size_t row, std::size_t column) const;
+
+    /**
+     * @brief Adds the cursor's columns to a builder.
+     */
+    void add_columns_to(ResultSetBuilder& builder) const;
+
+    /**
+     * @brief Appends one row of the current block to a builder with matching columns.
+     */
+    void append_row_to(ResultSetBuilder& builder, std::size_t row) const;
+
+private:
+    struct Column {
+        std::string name;
+        ResultSet::ColumnKind kind;
+        SQLSMALLINT sql_type;
+        std::size_t width;                // bytes per value
+        std::vector<std::byte> values;    // block_rows * width
+        std::vector<SQLLEN> indicators;
+    };
+
+    BlockCursor() = default;
+
+    Statement* m_stmt = nullptr;
+    std::size_t m_block_rows = 0;
+    std::vector<Column> m_columns;
+    std::unique_ptr<SQLULEN> m_rows_fetched = std::make_unique<SQLULEN>(0);   // bound by address
+    std::vector<SQLUSMALLINT> m_row_status;
+
+    std::string_view text(std::size_t row, std::size_t column) const {
+        const Column& col = m_columns[column];
+        const char* data = reinterpret_cast<const char*>(col.values.data() + row * col.width);
+        const SQLLEN length = col.indicators[row];
+        if (length == SQL_NO_TOTAL) return {data, std::strlen(data)};
+        return {data, std::min(static_cast<std::size_t>(length), col.width - 1)};
+    }
+
+    template <typename U>
+    U number(std::size_t row, std::size_t column) const {
+        U value;
+        std::memcpy(&value, m_columns[column].values.data() + row * sizeof(U), sizeof(U));
+        return value;
+    }
+};
+
+
+// --- Implementation ---
+
+inline std::expected<BlockCursor, OdbcError> BlockCursor::open(Statement& stmt, std::size_t block_rows, std::size_t max_text_length) {
+    auto column_count = stmt.num_result_cols();
+    if (!column_count) {
+        return std::unexpected(column_count.error());
+    }
+
+    BlockCursor cursor;
+    cursor.m_block_rows = std::max<std::size_t>(1, block_rows);
+    cursor.m_row_status.resize(cursor.m_block_rows);
+    for (SQLUSMALLINT c = 1; c <= static_cast<SQLUSMALLINT>(*column_count); ++c) {
+        auto description = stmt.describe_column(c);
+        if (!description) {
+            return std::unexpected(description.error());
+        }
+        Column column;
+        column.kind = column_kind_for(description->data_type);
+        column.sql_type = description->data_type;
+        column.name = std::move(description->name);
+        if (column.kind == ResultSet::ColumnKind::text) {
+            const std::size_t size = description->column_size > 0 ? static_cast<std::size_t>(description->column_size) : max_text_length;
+            column.width = std::min(size, max_text_length) + 1;
+        } else {
+            column.width = 8;
+        }
+        column.values.resize(cursor.m_block_rows * column.width);
+        column.indicators.resize(cursor.m_block_rows);
+        cursor.m_columns.push_back(std::move(column));
+    }
+
+    // From here on the statement is bound, so the cursor must be fully constructed
+    // for its destructor to undo the bindings if a later step fails.
+    cursor.m_stmt = &stmt;
+    SQLHSTMT handle = stmt.get();
+    auto fail = [&](const char* message) {
+        return std::unexpected(get_diagnostic_record(handle, SQL_HANDLE_STMT).value_or(OdbcError{"HY000", 0, message}));
+    };
+    if (!SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_ROW_BIND_TYPE, reinterpret_cast<SQLPOINTER>(SQL_BIND_BY_COLUMN), 0))
+        || !SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_ROW_ARRAY_SIZE, reinterpret_cast<SQLPOINTER>(cursor.m_block_rows), 0))
+        || !SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_ROWS_FETCHED_PTR, cursor.m_rows_fetched.get(), 0))
+        || !SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_ROW_STATUS_PTR, cursor.m_row_status.data(), 0))) {
+        return fail("Unknown error enabling block fetch");
+    }
+    for (std::size_t c = 0; c < cursor.m_columns.size(); ++c) {
+        Column& column = cursor.m_columns[c];
+        SQLSMALLINT c_type = SQL_C_CHAR;
+        if (column.kind == ResultSet::ColumnKind::integer) c_type = SQL_C_SBIGINT;
+        if (column.kind == ResultSet::ColumnKind::real) c_type = SQL_C_DOUBLE;
+        if (!SQL_SUCCEEDED(SQLBindCol(handle, static_cast<SQLUSMALLINT>(c + 1), c_type, column.values.data(),
+                                      static_cast<SQLLEN>(column.width), column.indicators.data()))) {
+            return fail("Unknown error binding column");
+        }
+    }
+    return cursor;
+}
+
+inline BlockCursor::~BlockCursor() {
+    if (m_stmt != nullptr) {
+        SQLHSTMT handle = m_stmt->get();
+        SQLFreeStmt(handle, SQL_UNBIND);
+        SQLSetStmtAttr(handle, SQL_ATTR_ROW_ARRAY_SIZE, reinterpret_cast<SQLPOINTER>(1), 0);
+        SQLSetStmtAttr(handle, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+        SQLSetStmtAttr(handle, SQL_ATTR_ROW_STATUS_PTR, nullptr, 0);
+    }
+}
+
+// Bound addresses point into heap buffers, which move along with the vectors.
+inline BlockCursor::BlockCursor(BlockCursor&& other) noexcept
+    : m_stmt(std::exchange(other.m_stmt, nullptr)), m_block_rows(other.m_block_rows),
+      m_columns(std::move(other.m_columns)), m_rows_fetched(std::move(other.m_rows_fetched)),
+      m_row_status(std::move(other.m_row_status)) {}
+
+inline std::expected<std::size_t, OdbcError> BlockCursor::fetch_block() {
+    SQLHSTMT handle = m_stmt->get();
+    if (SQLRETURN ret = SQLFetch(handle); ret == SQL_NO_DATA) {
+        *m_rows_fetched = 0;
+        return 0;
+    } else if (!SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown block fetch error"}));
+    }
+    return rows();
+}
+
+inline std::optional<std::size_t> BlockCursor::find_column(std::string_view name) const {
+    for (std::size_t c = 0; c < m_columns.size(); ++c) {
+        if (m_columns[c].name == name) return c;
+    }
+    return std::nullopt;
+}
+
+inline bool BlockCursor::is_truncated(std::size_t row, std::size_t column) const {
+    const Column& col = m_columns[column];
+    const SQLLEN length = col.indicators[row];
+    return col.kind == ResultSet::ColumnKind::text
+        && (length == SQL_NO_TOTAL || (length > 0 && static_cast<std::size_t>(length) >= col.width));
+}
+
+template <typename T>
+inline std::optional<T> BlockCursor::get(std::size_t row, std::size_t column) const {
+    if (is_null(row, column)) {
+        return std::nullopt;
+    }
+    const auto kind = m_columns[column].kind;
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        if (kind != ResultSet::ColumnKind::text) return std::nullopt;
+        return text(row, column);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        switch (kind) {
+            case ResultSet::ColumnKind::integer: return std::to_string(number<long long>(row, column));
+            case ResultSet::ColumnKind::real: return std::format("{}", number<double>(row, column));
+            case ResultSet::ColumnKind::text: return std::string(text(row, column));
+        }
+        return std::nullopt;
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "BlockCursor::get supports arithmetic types, std::string and std::string_view");
+        switch (kind) {
+            case ResultSet::ColumnKind::integer: return static_cast<T>(number<long long>(row, column));
+            case ResultSet::ColumnKind::real: return static_cast<T>(number<double>(row, column));
+            case ResultSet::ColumnKind::text: {
+                std::string_view value = text(row, column);
+                T parsed{};
+                if (std::from_chars(value.data(), value.data() + value.size(), parsed).ec != std::errc{}) return std::nullopt;
+                return parsed;
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+inline void BlockCursor::add_columns_to(ResultSetBuilder& builder) const {
+    for (const auto& column : m_columns) {
+        builder.add_column(column.name, column.kind, column.sql_type);
+    }
+}
+
+inline void BlockCursor::append_row_to(ResultSetBuilder& builder, std::size_t row) const {
+    for (std::size_t c = 0; c < m_columns.size(); ++c) {
+        if (is_null(row, c)) {
+            builder.append_null(c);
+            continue;
+        }
+        switch (m_columns[c].kind) {
+            case ResultSet::ColumnKind::integer: builder.append(c, number<long long>(row, c)); break;
+            case ResultSet::ColumnKind::real: builder.append(c, number<double>(row, c)); break;
+            case ResultSet::ColumnKind::text: builder.append(c, text(row, c)); break;
+        }
+    }
+}
+
+/**
+ * @class ParameterArray
+ * @brief Rows of parameter values for one execute_array() call.
+ *
+ * Each column is bound with the widest type among its values: text if any value
+ * is a string, otherwise double if any value is a double, otherwise BIGINT. A
+ * declared column kind (set_column_kind()) is the narrowest type used, so such a
+ * column binds the same way in every batch, even one where it is all NULL.
+ */
+class ParameterArray {
+public:
+    explicit ParameterArray(std::size_t columns) : m_columns(columns) {}
+
+    /**
+     * @brief Appends a row; missing trailing values are NULL and extra values are ignored.
+     */
+    void add_row(std::span<const Parameter> row) {
+        for (std::size_t c = 0; c < m_columns; ++c) {
+            m_values.push_back(c < row.size() ? row[c] : Parameter{});
+        }
+    }
+
+    void add_row(std::initializer_list<Parameter> row) { add_row(std::span<const Parameter>(row.begin(), row.size())); }
+
+    void set_column_kind(std::size_t column, ResultSet::ColumnKind kind) {
+        m_kinds.resize(m_columns);
+        m_kinds[column] = kind;
+    }
+
+    [[nodiscard]] std::optional<ResultSet::ColumnKind> column_kind(std::size_t column) const {
+        return column < m_kinds.size() ? m_kinds[column] : std::nullopt;
+    }
+
+    [[nodiscard]] const Parameter& at(std::size_t row, std::size_t column) const { return m_values[row * m_columns + column]; }
+    [[nodiscard]] std::size_t rows() const noexcept { return m_columns == 0 ? 0 : m_values.size() / m_columns; }
+    [[nodiscard]] std::size_t columns() const noexcept { return m_columns; }
+    [[nodiscard]] bool empty() const noexcept { return m_values.empty(); }
+    void reserve(std::size_t rows) { m_values.reserve(rows * m_columns); }
+    void clear() noexcept { m_values.clear(); }
+
+private:
+    std::size_t m_columns;
+    std::vector<Parameter> m_values;   // row-major
+    std::vector<std::optional<ResultSet::ColumnKind>> m_kinds;
+};
+
+/**
+ * @brief Executes a prepared statement once per row of a ParameterArray, sending up to
+ *        rows_per_execute rows per round trip.
+ *
+ * Drivers that reject parameter arrays fall back to one execute per row.
+ *
+ * @param stmt A statement prepared with one '?' per column of rows.
+ * @param rows The parameter rows.
+ * @param rows_per_execute Maximum rows bound per SQLExecute call.
+ * @return The first error. A row the driver rejects inside an array fails the call with
+ *         its row offset in the message; rows sent in earlier round trips, and the
+ *         other rows of the failing one, stay applied.
+ */
+[[nodiscard]] inline std::expected<void, OdbcError> execute_array(Statement& stmt, const ParameterArray& rows,
+                                                                  std::size_t rows_per_execute = 1000) {
+    const std::size_t columns = rows.columns();
+    SQLHSTMT handle = stmt.get();
+    auto error = [&](const char* message) {
+        return std::unexpected(get_diagnostic_record(handle, SQL_HANDLE_STMT).value_or(OdbcError{"HY000", 0, message}));
+    };
+    stmt.clear_parameters();
+
+    // Column-wise buffers, sized for the widest value of each column.
+    struct Buffer {
+        ResultSet::ColumnKind kind = ResultSet::ColumnKind::integer;
+        std::size_t width = 8;
+        std::vector<std::byte> values;
+        std::vector<SQLLEN> indicators;
+    };
+    std::vector<Buffer> buffers(columns);
+    for (std::size_t c = 0; c < columns; ++c) {
+        const auto declared = rows.column_kind(c);
+        buffers[c].kind = declared.value_or(ResultSet::ColumnKind::integer);
+        bool all_null = true;
+        bool has_number = false;
+        for (std::size_t r = 0; r < rows.rows(); ++r) {
+            const Parameter& value = rows.at(r, c);
+            all_null = all_null && std::holds_alternative<std::monostate>(value);
+            has_number = has_number || std::holds_alternative<long long>(value) || std::holds_alternative<double>(value);
+            if (const auto* text = std::get_if<std::string>(&value)) {
+                buffers[c].kind = ResultSet::ColumnKind::text;
+                buffers[c].width = std::max(buffers[c].width, text->size() + 1);
+            } else if (std::holds_alternative<double>(value) && buffers[c].kind == ResultSet::ColumnKind::integer) {
+                buffers[c].kind = ResultSet::ColumnKind::real;
+            }
+        }
+        if (all_null && !declared) buffers[c].kind = ResultSet::ColumnKind::text;
+        if (buffers[c].kind == ResultSet::ColumnKind::text && has_number) {
+            buffers[c].width = std::max<std::size_t>(buffers[c].width, 32);   // numbers are sent as text
+        }
+    }
+
+    const std::size_t batch = std::max<std::size_t>(1, rows_per_execute);
+    SQLULEN processed = 0;
+    std::vector<SQLUSMALLINT> status(std::min(batch, rows.rows()));
+    bool arrays = SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_PARAM_BIND_TYPE, reinterpret_cast<SQLPOINTER>(SQL_PARAM_BIND_BY_COLUMN), 0))
+        && SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed, 0))
+        && SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_PARAM_STATUS_PTR, status.data(), 0));
+    auto restore = [&] {
+        SQLFreeStmt(handle, SQL_RESET_PARAMS);
+        SQLSetStmtAttr(handle, SQL_ATTR_PARAMSET_SIZE, reinterpret_cast<SQLPOINTER>(1), 0);
+        SQLSetStmtAttr(handle, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, 0);
+        SQLSetStmtAttr(handle, SQL_ATTR_PARAM_STATUS_PTR, nullptr, 0);
+    };
+
+    for (std::size_t offset = 0; offset < rows.rows(); offset += batch) {
+        const std::size_t count = std::min(batch, rows.rows() - offset);
+        if (arrays && !SQL_SUCCEEDED(SQLSetStmtAttr(handle, SQL_ATTR_PARAMSET_SIZE, reinterpret_cast<SQLPOINTER>(count), 0))) {
+            arrays = false;
+        }
+        const std::size_t bound_rows = arrays ? count : 1;
+
+        for (std::size_t first = 0; first < count; first += bound_rows) {
+            for (std::size_t c = 0; c < columns; ++c) {
+                Buffer& buffer = buffers[c];
+                buffer.values.assign(bound_rows * buffer.width, std::byte{0});
+                buffer.indicators.assign(bound_rows, 0);
+                for (std::size_t r = 0; r < bound_rows; ++r) {
+                    const Parameter& value = rows.at(offset + first + r, c);
+                    std::byte* cell = buffer.values.data() + r * buffer.width;
+                    if (std::holds_alternative<std::monostate>(value)) {
+                        buffer.indicators[r] = SQL_NULL_DATA;
+                    } else if (buffer.kind == ResultSet::ColumnKind::integer) {
+                        const long long number = std::get<long long>(value);
+                        std::memcpy(cell, &number, sizeof(number));
+                    } else if (buffer.kind == ResultSet::ColumnKind::real) {
+                        const double number = std::holds_alternative<double>(value) ? std::get<double>(value)
+                                                                                     : static_cast<double>(std::get<long long>(value));
+                        std::memcpy(cell, &number, sizeof(number));
+                    } else {
+                        const std::string text = std::holds_alternative<std::string>(value) ? std::get<std::string>(value)
+                            : std::holds_alternative<long long>(value) ? std::to_string(std::get<long long>(value))
+                                                                       : std::format("{}", std::get<double>(value));
+                        std::memcpy(cell, text.data(), text.size());
+                        buffer.indicators[r] = static_cast<SQLLEN>(text.size());
+                    }
+                }
+                SQLSMALLINT c_type = SQL_C_CHAR, sql_type = SQL_VARCHAR;
+                if (buffer.kind == ResultSet::ColumnKind::integer) { c_type = SQL_C_SBIGINT; sql_type = SQL_BIGINT; }
+                if (buffer.kind == ResultSet::ColumnKind::real) { c_type = SQL_C_DOUBLE; sql_type = SQL_DOUBLE; }
+                const SQLULEN column_size = buffer.kind == ResultSet::ColumnKind::text ? std::max<SQLULEN>(1, buffer.width - 1) : 0;
+                if (!SQL_SUCCEEDED(SQLBindParameter(handle, static_cast<SQLUSMALLINT>(c + 1), SQL_PARAM_INPUT, c_type, sql_type,
+                                                    column_size, 0, buffer.values.data(), static_cast<SQLLEN>(buffer.width),
+                                                    buffer.indicators.data()))) {
+                    auto failed = error("Unknown parameter array binding error");
+                    restore();
+                    return failed;
+                }
+            }
+            processed = 0;
+            if (SQLRETURN ret = SQLExecute(handle); !SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) {
+                auto failed = error("Unknown parameter array execution error");
+                restore();
+                return failed;
+            }
+            // A row that fails inside an array only turns the result into SQL_SUCCESS_WITH_INFO.
+            const std::size_t done = std::min<std::size_t>(processed, bound_rows);
+            for (std::size_t r = 0; r < done; ++r) {
+                if (status[r] == SQL_PARAM_ERROR || status[r] == SQL_PARAM_DIAG_UNAVAILABLE) {
+                    OdbcError failed = get_diagnostic_record(handle, SQL_HANDLE_STMT)
+                                           .value_or(OdbcError{"HY000", 0, "Unknown parameter array row error"});
+                    failed.message = std::format("Parameter row {} failed: {}", offset + first + r, failed.message);
+                    restore();
+                    return std::unexpected(std::move(failed));
+                }
+            }
+        }
+    }
+    restore();
+    return {};
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_BULK_H
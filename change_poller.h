@@ -0,0 +1,337 @@
+#ifndef MODERN_ODBC_CHANGE_POLLER_H
+#define MODERN_ODBC_CHANGE_POLLER_H
+
+/**
+ * @file change_poller.h
+ * @brief Incremental polling of new or changed rows using a watermark column.
+ *
+ * A ChangePoller repeatedly runs one prepared delta query such as
+ *   SELECT id, CAST(rv AS BIGINT) AS rv, status FROM orders WHERE rv > ? ORDER BY rv
+ * with the last seen watermark bound to its single parameter marker. The new
+ * rows are handed to a callback one fetched block at a time, after which the
+ * watermark advances to the last row's value and is optionally persisted to a
+ * file, so a restarted process continues where it stopped.
+ *
+ * The watermark column must increase monotonically (identity, rowversion cast
+ * to BIGINT, or a timestamp) and the query must order by it.
+ *
+ * The interval adapts to the change rate: it doubles (up to max_interval) after
+ * each poll that found nothing, drops back to min_interval as soon as rows
+ * arrive, and the next poll starts immediately when a poll filled a whole block.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "bulk.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace odbc {
+
+/**
+ * @struct ChangePollerOptions
+ * @brief Configuration for a ChangePoller.
+ */
+struct ChangePollerOptions {
+    std::string query;                               ///< Delta query with one '?' for the watermark, ordered by the watermark column.
+    std::string watermark_column;                    ///< Result column holding the watermark.
+    Parameter initial_watermark = 0LL;               ///< Used when no watermark file exists yet.
+    std::filesystem::path watermark_file;            ///< Where the watermark is persisted; empty disables persistence.
+    std::chrono::milliseconds min_interval{100};
+    std::chrono::milliseconds max_interval{5000};
+    std::size_t block_rows = 500;                    ///< Rows per fetch and per callback invocation.
+    bool background = true;                          ///< Poll on an internal thread; otherwise call poll_once().
+};
+
+/**
+ * @class ChangePoller
+ * @brief Streams rows newer than a persisted watermark to a callback.
+ */
+class ChangePoller {
+public:
+    /**
+     * @brief Receives one block of new rows (cursor rows 0 .. rows()-1).
+     * @return false to stop the current poll; the watermark then stays before this block.
+     */
+    using Callback = std::function<bool(const BlockCursor&)>;
+
+    /**
+     * @param alias A unique string to identify the connection (e.g., "DB_PRIMARY").
+     * @param connection_string The full ODBC connection string.
+     * @param options The delta query, watermark column and polling intervals.
+     * @param callback Invoked on the polling thread for each block of new rows.
+     */
+    ChangePoller(std::string alias, std::string connection_string, ChangePollerOptions options, Callback callback);
+
+    /**
+     * @brief Stops the polling thread after the poll in progress.
+     */
+    ~ChangePoller();
+    ChangePoller(const ChangePoller&) = delete;
+    ChangePoller& operator=(const ChangePoller&) = delete;
+
+    /**
+     * @brief Runs the delta query once and delivers its rows. Not for use while polling in the background.
+     * @return The number of rows delivered.
+     */
+    [[nodiscard]] std::expected<std::size_t, OdbcError> poll_once();
+
+    /**
+     * @brief The last watermark delivered.
+     */
+    [[nodiscard]] Parameter watermark() const {
+        std::scoped_lock lock(m_mutex);
+        return m_watermark;
+    }
+
+    /**
+     * @brief The delay before the next background poll.
+     */
+    [[nodiscard]] std::chrono::milliseconds current_interval() const {
+        std::scoped_lock lock(m_mutex);
+        return m_interval;
+    }
+
+    [[nodiscard]] std::uint64_t rows_delivered() const noexcept { return m_rows_delivered.load(std::memory_order_relaxed); }
+
+private:
+    std::string m_alias;
+    std::string m_connection_string;
+    ChangePollerOptions m_options;
+    Callback m_callback;
+
+    mutable std::mutex m_mutex;
+    Parameter m_watermark;
+    std::chrono::milliseconds m_interval;
+    std::atomic<std::uint64_t> m_rows_delivered{0};
+    std::condition_variable_any m_wakeup;
+    std::jthread m_thread;
+
+    void run(std::stop_token stop);
+    std::expected<std::size_t, OdbcError> poll(std::optional<PooledStatement>& stmt);
+    void adapt_interval(std::size_t rows);
+    void load_watermark();
+    void save_watermark(const Parameter& watermark) const;
+};
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    // Watermark file format: one type tag followed by the value, e.g. "I 42" or "S 2024-01-01 10:00:00".
+    inline std::string encode_watermark(const Parameter& watermark) {
+        return std::visit([](const auto& value) -> std::string {
+            using V = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<V, std::monostate>) return "N";
+            else if constexpr (std::is_same_v<V, long long>) return std::format("I {}", value);
+            else if constexpr (std::is_same_v<V, double>) return std::format("R {}", value);
+            else return "S " + value;
+        }, watermark);
+    }
+
+    inline std::optional<Parameter> decode_watermark(std::string_view text) {
+        if (text == "N") return Parameter{};
+        if (text.size() < 2 || text[1] != ' ') return std::nullopt;
+        const std::string_view value = text.substr(2);
+        switch (text[0]) {
+            case 'I': {
+                long long number = 0;
+                if (std::from_chars(value.data(), value.data() + value.size(), number).ec != std::errc{}) return std::nullopt;
+                return Parameter{number};
+            }
+            case 'R': {
+                double number = 0;
+                if (std::from_chars(value.data(), value.data() + value.size(), number).ec != std::errc{}) return std::nullopt;
+                return Parameter{number};
+            }
+            case 'S': return Parameter{std::string(value)};
+            default: return std::nullopt;
+        }
+    }
+
+} // namespace detail
+
+inline ChangePoller::ChangePoller(std::string alias, std::string connection_string, ChangePollerOptions options, Callback callback)
+    : m_alias(std::move(alias)), m_connection_string(std::move(connection_string)),
+      m_options(std::move(options)), m_callback(std::move(callback)), m_interval(m_options.min_interval) {
+    m_options.max_interval = std::max(m_options.max_interval, m_options.min_interval);
+    load_watermark();
+    if (m_options.background) {
+        m_thread = std::jthread([this](std::stop_token stop) { run(std::move(stop)); });
+    }
+}
+
+inline ChangePoller::~ChangePoller() {
+    if (m_thread.joinable()) {
+        m_thread.request_stop();
+        m_wakeup.notify_all();
+        m_thread.join();
+    }
+}
+
+inline void ChangePoller::load_watermark() {
+    m_watermark = m_options.initial_watermark;
+    if (m_options.watermark_file.empty()) {
+        return;
+    }
+    std::ifstream in(m_options.watermark_file);
+    std::string line;
+    if (in && std::getline(in, line)) {
+        if (auto stored = detail::decode_watermark(line)) {
+            m_watermark = std::move(*stored);
+        } else {
+            std::cerr << std::format("[ChangePoller] Ignoring unreadable watermark file '{}'.\n", m_options.watermark_file.string());
+        }
+    }
+}
+
+inline void ChangePoller::save_watermark(const Parameter& watermark) const {
+    if (m_options.watermark_file.empty()) {
+        return;
+    }
+    // Write and rename so a crash never leaves a half-written watermark.
+    std::filesystem::path temporary = m_options.watermark_file;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << detail::encode_watermark(watermark) << '\n';
+        if (!out.flush()) {
+            std::cerr << std::format("[ChangePoller] Failed to write watermark file '{}'.\n", temporary.string());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, m_options.watermark_file, ec);
+    if (ec) {
+        std::cerr << std::format("[ChangePoller] Failed to replace watermark file: {}\n", ec.message());
+    }
+}
+
+inline std::expected<std::size_t, OdbcError> ChangePoller::poll_once() {
+    // Prepared per call: a pooled statement belongs to the calling thread's pool.
+    std::optional<PooledStatement> stmt;
+    return poll(stmt);
+}
+
+inline std::expected<std::size_t, OdbcError> ChangePoller::poll(std::optional<PooledStatement>& stmt) {
+    try {
+        if (!stmt) {
+            stmt.emplace(getThreadLocalStatement(m_alias, m_connection_string));
+            if (auto prepared = (*stmt)->prepare(m_options.query); !prepared) {
+                stmt.reset();
+                return std::unexpected(prepared.error());
+            }
+        }
+        Statement& statement = stmt->get();
+
+        Parameter watermark = this->watermark();
+        statement.bind_parameter(1, watermark);
+        if (auto exec_res = statement.execute(); !exec_res) {
+            stmt.reset();
+            return std::unexpected(exec_res.error());
+        }
+
+        std::size_t delivered = 0;
+        std::optional<OdbcError> error;
+        {
+            auto cursor = BlockCursor::open(statement, m_options.block_rows);
+            if (!cursor) {
+                error = cursor.error();
+            }
+            const auto column = cursor ? cursor->find_column(m_options.watermark_column) : std::nullopt;
+            if (cursor && !column) {
+                error = OdbcError{"42S22", 0, std::format("Watermark column '{}' is not in the result.", m_options.watermark_column)};
+            }
+            while (!error) {
+                auto rows = cursor->fetch_block();
+                if (!rows) {
+                    error = rows.error();
+                    break;
+                }
+                if (*rows == 0 || !m_callback(*cursor)) {
+                    break;
+                }
+                // Rows are ordered by the watermark, so the block's last row carries the new one.
+                const std::size_t last = *rows - 1;
+                switch (cursor->column_kind(*column)) {
+                    case ResultSet::ColumnKind::integer: watermark = cursor->get<long long>(last, *column).value_or(0); break;
+                    case ResultSet::ColumnKind::real: watermark = cursor->get<double>(last, *column).value_or(0.0); break;
+                    case ResultSet::ColumnKind::text: watermark = cursor->get<std::string>(last, *column).value_or(std::string{}); break;
+                }
+                {
+                    std::scoped_lock lock(m_mutex);
+                    m_watermark = watermark;
+                }
+                delivered += *rows;
+                m_rows_delivered.fetch_add(*rows, std::memory_order_relaxed);
+            }
+        }
+        (void)statement.close_cursor();
+
+        if (delivered > 0) {
+            save_watermark(watermark);
+        }
+        if (error) {
+            return std::unexpected(*error);
+        }
+        return delivered;
+    } catch (const ConnectionPoolError& e) {
+        stmt.reset();
+        return std::unexpected(OdbcError{"08001", 0, e.what()});
+    } catch (const std::exception& e) {
+        stmt.reset();
+        return std::unexpected(OdbcError{"HY000", 0, e.what()});
+    }
+}
+
+inline void ChangePoller::adapt_interval(std::size_t rows) {
+    std::scoped_lock lock(m_mutex);
+    if (rows >= m_options.block_rows) {
+        m_interval = std::chrono::milliseconds(0);   // busy: more rows are likely waiting
+    } else if (rows > 0) {
+        m_interval = m_options.min_interval;
+    } else {
+        m_interval = std::clamp(std::max(m_interval * 2, std::chrono::milliseconds(1)), m_options.min_interval, m_options.max_interval);
+    }
+}
+
+inline void ChangePoller::run(std::stop_token stop) {
+    std::optional<PooledStatement> stmt;   // prepared once and reused while it keeps working
+    while (!stop.stop_requested()) {
+        auto delivered = poll(stmt);
+        if (!delivered) {
+            std::cerr << std::format("[ChangePoller] Poll of '{}' failed: {}\n", m_alias, delivered.error().to_string());
+        }
+        adapt_interval(delivered.value_or(0));
+
+        std::unique_lock lock(m_mutex);
+        if (m_interval.count() > 0) {
+            m_wakeup.wait_for(lock, stop, m_interval, [] { return false; });
+        }
+    }
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_CHANGE_POLLER_H
@@ -11,7 +11,13 @@
  */
 
 #include "odbc_wrapper.h"
+#include "pool_telemetry.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <stdexcept>
@@ -35,6 +41,55 @@ public:
 };
 
 
+/**
+ * @class PooledStatement
+ * @brief A statement allocated on a pooled connection, counted as active while it lives.
+ *
+ * The pool uses the count to decide whether another statement can share the
+ * connection. A statement is treated as having an open cursor for its whole
+ * lifetime, so keep it scoped to the query it runs.
+ */
+class PooledStatement {
+private:
+    odbc::Statement statement_;
+    std::size_t* active_statements_;
+    odbc::detail::PoolUsage* usage_;   // telemetry of the alias, or nullptr
+    std::chrono::steady_clock::time_point checked_out_{};
+
+public:
+    PooledStatement(odbc::Connection& connection, std::size_t& active_statements, odbc::detail::PoolUsage* usage = nullptr)
+        : statement_(connection), active_statements_(&active_statements), usage_(usage) {
+        if (++*active_statements_ == 1 && usage_ != nullptr) {
+            usage_->active.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (usage_ != nullptr) {
+            checked_out_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~PooledStatement() {
+        if (active_statements_ == nullptr) {
+            return;
+        }
+        if (--*active_statements_ == 0 && usage_ != nullptr) {
+            usage_->active.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (usage_ != nullptr) {
+            usage_->record_hold(checked_out_);
+        }
+    }
+    PooledStatement(const PooledStatement&) = delete;
+    PooledStatement& operator=(const PooledStatement&) = delete;
+    PooledStatement(PooledStatement&& other) noexcept
+        : statement_(std::move(other.statement_)), active_statements_(std::exchange(other.active_statements_, nullptr)),
+          usage_(other.usage_), checked_out_(other.checked_out_) {}
+    PooledStatement& operator=(PooledStatement&&) = delete;
+
+    [[nodiscard]] odbc::Statement& get() { return statement_; }
+    [[nodiscard]] odbc::Statement& operator*() { return statement_; }
+    [[nodiscard]] odbc::Statement* operator->() { return &statement_; }
+};
+
+
 /**
  * @class ThreadLocalConnectionPool
  * @brief Manages a pool of named ODBC connections private to a single thread.
@@ -43,9 +98,28 @@ public:
  * and stores connections on demand, reusing them for subsequent requests
  * within the same thread. It is not meant to be instantiated directly by client code;
  * rather, it should be accessed via the getThreadLocalConnection() function.
+ *
+ * Besides one primary connection per alias, the pool multiplexes statements
+ * (see getStatement()). On a connection with MARS, or with a driver that allows
+ * several concurrent activities, any number of statements share the primary
+ * connection. Otherwise a statement requested while another one is still active
+ * transparently gets a secondary connection for the same alias, which is kept
+ * for reuse by later nested queries.
  */
 class ThreadLocalConnectionPool {
 private:
+    /**
+     * @struct PooledConnectionSlot
+     * @brief A connection together with its statement multiplexing state.
+     */
+    struct PooledConnectionSlot {
+        odbc::Connection connection;
+        bool multiple_active_statements = false;
+        std::size_t active_statements = 0;
+        const odbc::detail::StatementMetrics* metrics = nullptr;   // the alias's unnamed-statement series
+        odbc::detail::PoolUsage* usage = nullptr;                  // the alias's pool telemetry
+    };
+
     /**
      * @var env_
      * @brief The single ODBC environment handle for this thread's pool.
@@ -56,10 +130,81 @@ private:
     /**
      * @var connections_
      * @brief The map storing named connections for this thread.
+     * The first slot of each alias is its primary connection; further slots are
+     * secondary connections opened for nested statements. A deque keeps references
+     * to existing slots valid when new ones are added.
      * Using std::less<> enables heterogeneous lookup, allowing find() with string_view
      * for a minor performance optimization.
      */
-    std::map<std::string, odbc::Connection, std::less<>> connections_;
+    std::map<std::string, std::deque<PooledConnectionSlot>, std::less<>> connections_;
+
+    /**
+     * @var usage_
+     * @brief Open and active connection counts per alias, reported to pool_telemetry().
+     * Kept apart from connections_ so that failed connects are counted before an alias has a slot.
+     */
+    std::map<std::string, std::shared_ptr<odbc::detail::PoolUsage>, std::less<>> usage_;
+
+    odbc::detail::PoolUsage& usageFor(std::string_view alias) {
+        if (auto it = usage_.find(alias); it != usage_.end()) {
+            return *it->second;
+        }
+        auto usage = odbc::detail::PoolTelemetryRegistry::instance().attach("thread_local", alias, odbc::detail::current_thread_name());
+        return *usage_.emplace(std::string(alias), std::move(usage)).first->second;
+    }
+
+    /**
+     * @brief Only SQL Server drivers understand SQL_COPT_SS_MARS_ENABLED.
+     */
+    static bool is_sql_server_driver(std::string_view connection_string) {
+        std::string lowered(connection_string);
+        std::ranges::transform(lowered, lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return lowered.find("sql server") != std::string::npos;
+    }
+
+    PooledConnectionSlot& openConnection(std::deque<PooledConnectionSlot>& slots, std::string_view alias, std::string_view connection_string) {
+        // Convert thread ID to string for formatting
+        std::stringstream ss;
+        ss << std::this_thread::get_id();
+        
+        // Use std::format and a single stream insertion for thread-safe logging.
+        std::cerr << std::format("[Thread {}] Creating {} connection for alias '{}'.\n",
+                                 ss.str(), slots.empty() ? "new" : "secondary", alias);
+        
+        odbc::Connection new_conn(env_);
+        if (is_sql_server_driver(connection_string)) {
+            // Best effort: a driver that does not support MARS simply keeps it off.
+            (void)new_conn.enable_mars();
+        }
+
+        odbc::detail::PoolUsage& usage = usageFor(alias);
+        const auto connect_started = std::chrono::steady_clock::now();
+        auto connect_res = new_conn.driver_connect(connection_string);
+        usage.record_connect(connect_started, connect_res.has_value());
+        if (!connect_res) {
+            // Throw the specific exception type, also using std::format.
+            throw ConnectionPoolError(std::format("Failed to establish connection for alias '{}': {}", alias, connect_res.error().to_string()));
+        }
+
+        bool multiple_active = new_conn.supports_multiple_active_statements().value_or(false);
+        return slots.emplace_back(PooledConnectionSlot{std::move(new_conn), multiple_active, 0,
+                                                       odbc::MetricsRegistry::instance().statement_metrics(alias, ""), &usage});
+    }
+
+    std::deque<PooledConnectionSlot>& slotsFor(std::string_view alias, std::string_view connection_string) {
+        // Use C++17 "if with initializer" to scope 'it' to the if/else blocks.
+        // Thanks to heterogeneous lookup, we can use a string_view to find without allocating.
+        if (auto it = connections_.find(alias); it != connections_.end()) {
+            return it->second;
+        }
+        // Connection not found, create the primary one. Open it before inserting the
+        // alias so that a failed connect leaves no empty entry behind.
+        // We create a std::string from the alias here, as this only happens once on creation.
+        std::deque<PooledConnectionSlot> slots;
+        openConnection(slots, alias, connection_string);
+        auto [inserted_it, success] = connections_.emplace(std::string(alias), std::move(slots));
+        return inserted_it->second;
+    }
 
 public:
     /**
@@ -75,38 +220,46 @@ public:
      * @throws ConnectionPoolError if a new connection is required but fails to be established.
      */
     odbc::Connection& getConnection(std::string_view alias, std::string_view connection_string) {
-        // Use C++17 "if with initializer" to scope 'it' to the if/else blocks.
-        // Thanks to heterogeneous lookup, we can use a string_view to find without allocating.
-        if (auto it = connections_.find(alias); it == connections_.end()) {
-            // Connection not found, create a new one.
-            
-            // Convert thread ID to string for formatting
-            std::stringstream ss;
-            ss << std::this_thread::get_id();
-            
-            // Use std::format and a single stream insertion for thread-safe logging.
-            std::cerr << std::format("[Thread {}] Creating new connection for alias '{}'.\n", ss.str(), alias);
-            
-            odbc::Connection new_conn(env_);
-
-            auto connect_res = new_conn.driver_connect(connection_string);
-            if (!connect_res) {
-                // Throw the specific exception type, also using std::format.
-                throw ConnectionPoolError(std::format("Failed to establish connection for alias '{}': {}", alias, connect_res.error().to_string()));
-            }
-
-            // Emplace the new connection and return a reference to it.
-            // We create a std::string from the alias here, as this only happens once on creation.
-            auto [inserted_it, success] = connections_.emplace(std::string(alias), std::move(new_conn));
-            return inserted_it->second;
-        } else {
-            // Connection found, return the existing one.
-            return it->second;
-        }
+        return slotsFor(alias, connection_string).front().connection;
+    }
+
+    /**
+     * @brief Allocates a statement on a connection for the given alias.
+     *
+     * The primary connection is used whenever it can take another active statement.
+     * Otherwise the first idle secondary connection is used, and a new one is opened
+     * only if all of them are busy. This lets a nested query run inside a fetch loop
+     * on drivers without MARS.
+     *
+     * @param alias A unique string_view to identify the connection (e.g., "DB_PRIMARY").
+     * @param connection_string The full ODBC connection string to use if a new connection is needed.
+     * @return A PooledStatement that releases its connection slot on destruction.
+     * @throws ConnectionPoolError if a new connection is required but fails to be established.
+     */
+    PooledStatement getStatement(std::string_view alias, std::string_view connection_string) {
+        const auto started = std::chrono::steady_clock::now();
+        auto& slots = slotsFor(alias, connection_string);
+        auto it = std::ranges::find_if(slots, [](const PooledConnectionSlot& slot) {
+            return slot.multiple_active_statements || slot.active_statements == 0;
+        });
+        PooledConnectionSlot& slot = (it != slots.end()) ? *it : openConnection(slots, alias, connection_string);
+        PooledStatement statement(slot.connection, slot.active_statements, slot.usage);
+        statement->set_metrics(slot.metrics);
+        slot.usage->record_checkout(started);
+        return statement;
     }
 };
 
 
+/**
+ * @brief Returns the calling thread's pool, creating it on first use.
+ */
+inline ThreadLocalConnectionPool& getThreadLocalPool() {
+    // The pool is initialized once per thread and persists for the thread's lifetime.
+    thread_local ThreadLocalConnectionPool pool;
+    return pool;
+}
+
 /**
  * @brief Provides access to a thread-local connection pool.
  *
@@ -121,9 +274,20 @@ public:
  * @throws ConnectionPoolError if a new connection is required but fails to be established.
  */
 inline odbc::Connection& getThreadLocalConnection(std::string_view alias, std::string_view connection_string) {
-    // The pool is initialized once per thread and persists for the thread's lifetime.
-    thread_local ThreadLocalConnectionPool pool;
-    return pool.getConnection(alias, connection_string);
+    return getThreadLocalPool().getConnection(alias, connection_string);
+}
+
+/**
+ * @brief Allocates a statement from the thread-local pool, sharing or adding connections as needed.
+ *
+ * @param alias A unique string_view to identify the connection (e.g., "DB_PRIMARY").
+ * @param connection_string The full ODBC connection string.
+ * @return A PooledStatement bound to one of this thread's connections for the alias.
+ * @throws ConnectionPoolError if a new connection is required but fails to be established.
+ * @see ThreadLocalConnectionPool::getStatement
+ */
+inline PooledStatement getThreadLocalStatement(std::string_view alias, std::string_view connection_string) {
+    return getThreadLocalPool().getStatement(alias, connection_string);
 }
 
 #endif // MODERN_ODBC_CONNECTION_POOL_H
@@ -0,0 +1,243 @@
+#ifndef MODERN_ODBC_DATA_LOADER_H
+#define MODERN_ODBC_DATA_LOADER_H
+
+/**
+ * @file data_loader.h
+ * @brief Request-scoped batching and memoization of keyed loads (the DataLoader pattern).
+ *
+ * Resolvers that walk a parent list and load one child per parent produce the
+ * classic N+1 query pattern. A DataLoader collects the keys requested during
+ * one resolution step through load(), then dispatch() fetches all of them with
+ * a single batched query and memoizes the values for the rest of the request.
+ *
+ * Unlike PointLookupBatcher, a DataLoader has no background thread and no time
+ * window: it belongs to one request on one thread, and batches are formed
+ * exactly at the dispatch() calls (or at the end of a DispatchScope), which
+ * makes the queries it issues deterministic.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "result_set.h"
+#include "sql_text.h"
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @class DataLoader
+ * @brief Batches and memoizes loads of Value by Key within one request. Not thread-safe.
+ *
+ * @tparam Key A hashable key type.
+ * @tparam Value The loaded value type.
+ */
+template <typename Key, typename Value>
+class DataLoader {
+public:
+    /**
+     * @brief Loads all given keys at once. Keys missing from the returned map are memoized as not found.
+     */
+    using BatchFunction = std::function<std::expected<std::unordered_map<Key, Value>, OdbcError>(const std::vector<Key>&)>;
+
+    /**
+     * @class Pending
+     * @brief A value requested through load(); get() dispatches the loader if it has not run yet.
+     */
+    class Pending {
+    public:
+        [[nodiscard]] std::expected<std::optional<Value>, OdbcError> get() const { return m_loader->get(m_key); }
+        [[nodiscard]] const Key& key() const noexcept { return m_key; }
+
+    private:
+        friend class DataLoader;
+        Pending(DataLoader& loader, Key key) : m_loader(&loader), m_key(std::move(key)) {}
+        DataLoader* m_loader;
+        Key m_key;
+    };
+
+    explicit DataLoader(BatchFunction batch) : m_batch(std::move(batch)) {}
+
+    /**
+     * @brief Flushes keys that were requested but never dispatched.
+     */
+    ~DataLoader() {
+        try {
+            (void)dispatch();
+        } catch (const std::exception&) {
+            // A destructor must not throw; the values would be discarded anyway.
+        }
+    }
+
+    DataLoader(const DataLoader&) = delete;
+    DataLoader& operator=(const DataLoader&) = delete;
+
+    /**
+     * @brief Requests a key. Memoized keys are not queued again.
+     */
+    Pending load(const Key& key) {
+        if (!m_values.contains(key) && !m_errors.contains(key) && m_queued_set.insert(key).second) {
+            m_queued.push_back(key);
+        }
+        return Pending(*this, key);
+    }
+
+    /**
+     * @brief Requests several keys; equivalent to calling load() for each.
+     */
+    std::vector<Pending> load_many(const std::vector<Key>& keys) {
+        std::vector<Pending> pending;
+        pending.reserve(keys.size());
+        for (const auto& key : keys) pending.push_back(load(key));
+        return pending;
+    }
+
+    /**
+     * @brief Runs one batch for every queued key and memoizes the outcome.
+     * @return The batch error, if any; the same error is then returned by get() for those keys.
+     */
+    std::expected<void, OdbcError> dispatch() {
+        if (m_queued.empty()) {
+            return {};
+        }
+        std::vector<Key> keys = std::exchange(m_queued, {});
+        m_queued_set.clear();
+        ++m_batches_dispatched;
+
+        auto loaded = m_batch(keys);
+        if (!loaded) {
+            for (const auto& key : keys) m_errors.insert_or_assign(key, loaded.error());
+            return std::unexpected(loaded.error());
+        }
+        for (const auto& key : keys) {
+            auto it = loaded->find(key);
+            m_values.insert_or_assign(key, it != loaded->end() ? std::optional<Value>(std::move(it->second)) : std::nullopt);
+        }
+        return {};
+    }
+
+    /**
+     * @brief Returns a loaded value, dispatching first if the key is still queued.
+     * @return The value, std::nullopt if the batch did not return the key, or the batch error.
+     */
+    [[nodiscard]] std::expected<std::optional<Value>, OdbcError> get(const Key& key) {
+        if (m_queued_set.contains(key)) {
+            (void)dispatch();
+        } else if (!m_values.contains(key) && !m_errors.contains(key)) {
+            load(key);
+            (void)dispatch();
+        }
+        if (auto it = m_errors.find(key); it != m_errors.end()) {
+            return std::unexpected(it->second);
+        }
+        return m_values.at(key);
+    }
+
+    /**
+     * @brief Seeds the memo, e.g. with a value the request already has.
+     */
+    void prime(const Key& key, Value value) {
+        m_values.insert_or_assign(key, std::optional<Value>(std::move(value)));
+    }
+
+    /**
+     * @brief Forgets a memoized key, e.g. after the request modified it.
+     */
+    void clear(const Key& key) {
+        m_values.erase(key);
+        m_errors.erase(key);
+    }
+
+    [[nodiscard]] std::size_t batches_dispatched() const noexcept { return m_batches_dispatched; }
+
+private:
+    BatchFunction m_batch;
+    std::vector<Key> m_queued;
+    std::unordered_set<Key> m_queued_set;
+    std::unordered_map<Key, std::optional<Value>> m_values;
+    std::unordered_map<Key, OdbcError> m_errors;
+    std::size_t m_batches_dispatched = 0;
+};
+
+/**
+ * @class DispatchScope
+ * @brief Marks one resolution step: every loader passed in is dispatched when the scope ends.
+ */
+template <typename... Loaders>
+class DispatchScope {
+public:
+    explicit DispatchScope(Loaders&... loaders) : m_loaders(loaders...) {}
+    ~DispatchScope() {
+        std::apply([](auto&... loader) { ((void)loader.dispatch(), ...); }, m_loaders);
+    }
+    DispatchScope(const DispatchScope&) = delete;
+    DispatchScope& operator=(const DispatchScope&) = delete;
+
+private:
+    std::tuple<Loaders&...> m_loaders;
+};
+
+/**
+ * @brief Creates a loader whose batch is an IN-list query on the thread-local pool.
+ *
+ * Each key maps to the rows whose key_column equals it (possibly several, e.g.
+ * all order lines of an order). Keys without rows are memoized as not found.
+ *
+ * @tparam Key long long, std::string, or another type convertible to odbc::Parameter
+ *         and readable with ResultSet::get<Key>.
+ * @param alias A unique string to identify the connection (e.g., "DB_PRIMARY").
+ * @param connection_string The full ODBC connection string.
+ * @param query_template A query containing in_list_placeholder.
+ * @param key_column Zero-based result column holding the key.
+ * @param max_batch Keys per query; larger dispatches are split into several queries.
+ */
+template <typename Key>
+[[nodiscard]] DataLoader<Key, ResultSet> make_query_loader(std::string alias, std::string connection_string,
+                                                           std::string query_template, std::size_t key_column = 0,
+                                                           std::size_t max_batch = 1000) {
+    return DataLoader<Key, ResultSet>([=](const std::vector<Key>& keys) -> std::expected<std::unordered_map<Key, ResultSet>, OdbcError> {
+        std::unordered_map<Key, ResultSet> values;
+        for (std::size_t offset = 0; offset < keys.size(); offset += std::max<std::size_t>(1, max_batch)) {
+            const std::size_t end = std::min(keys.size(), offset + std::max<std::size_t>(1, max_batch));
+            std::vector<Parameter> parameters(keys.begin() + static_cast<std::ptrdiff_t>(offset), keys.begin() + static_cast<std::ptrdiff_t>(end));
+
+            ResultSet rows;
+            try {
+                auto stmt = getThreadLocalStatement(alias, connection_string);
+                if (auto exec_res = stmt->execute_direct(expand_in_list(query_template, parameters.size()), std::move(parameters)); !exec_res) {
+                    return std::unexpected(exec_res.error());
+                }
+                auto materialized = materialize(*stmt);
+                if (!materialized) return std::unexpected(materialized.error());
+                rows = std::move(*materialized);
+            } catch (const std::exception& e) {
+                return std::unexpected(OdbcError{"08001", 0, e.what()});
+            }
+
+            std::unordered_map<Key, std::vector<std::size_t>> rows_by_key;
+            for (std::size_t row = 0; key_column < rows.column_count() && row < rows.row_count(); ++row) {
+                if (auto key = rows.get<Key>(row, key_column)) rows_by_key[*key].push_back(row);
+            }
+            for (auto& [key, indexes] : rows_by_key) {
+                ResultSetBuilder builder;
+                builder.add_columns_from(rows);
+                for (std::size_t row : indexes) builder.append_row(rows, row);
+                values.emplace(key, builder.build());
+            }
+        }
+        return values;
+    });
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_DATA_LOADER_H
@@ -0,0 +1,262 @@
+#ifndef MODERN_ODBC_EXECUTOR_H
+#define MODERN_ODBC_EXECUTOR_H
+
+/**
+ * @file executor.h
+ * @brief A dedicated thread pool for blocking ODBC work.
+ *
+ * ODBC calls block the calling thread for the whole network round trip. The
+ * Executor lets latency-sensitive threads (for example, web I/O threads) hand
+ * database work to a fixed set of worker threads and continue immediately,
+ * receiving the result through a std::future or a callback.
+ *
+ * Every worker opens its own connections through the thread-local connection
+ * pool, so jobs never share a connection and need no locking. Submissions go
+ * into bounded lock-free queues, one per worker; an idle worker steals from the
+ * other workers' queues before going to sleep.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "mpmc_queue.h"
+#include "result_set.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct ExecutorOptions
+ * @brief Configuration for an Executor.
+ */
+struct ExecutorOptions {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t queue_capacity = 1024;   ///< Upper bound on queued (not yet running) jobs, across all workers.
+};
+
+/**
+ * @class Executor
+ * @brief Runs database jobs on a fixed set of worker threads, each with its own connections.
+ *
+ * Jobs that take an odbc::Connection& run on the worker's thread-local connection
+ * for the given alias. The destructor runs every job that is already queued and
+ * then joins the workers.
+ */
+class Executor {
+public:
+    using Job = std::move_only_function<void()>;
+
+    explicit Executor(ExecutorOptions options = {});
+    ~Executor();
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Queues a job unless the queue is full.
+     * @return The job's future, or std::nullopt if the queue had no room.
+     */
+    template <typename F>
+    [[nodiscard]] std::optional<std::future<std::invoke_result_t<std::decay_t<F>&>>> try_submit(F&& job);
+
+    /**
+     * @brief Queues a job, waiting for room if the queue is full.
+     * @return A future for the job's result; exceptions thrown by the job are rethrown by get().
+     */
+    template <typename F>
+    [[nodiscard]] std::future<std::invoke_result_t<std::decay_t<F>&>> submit(F&& job);
+
+    /**
+     * @brief Queues a job that runs with the worker's connection for an alias.
+     *
+     * @param alias A unique string to identify the connection (e.g., "DB_PRIMARY").
+     * @param connection_string The full ODBC connection string.
+     * @param job A callable taking odbc::Connection&.
+     * @return A future for the job's result. A ConnectionPoolError is delivered through the future.
+     */
+    template <typename F>
+    [[nodiscard]] std::future<std::invoke_result_t<std::decay_t<F>&, Connection&>> submit(std::string alias, std::string connection_string, F&& job);
+
+    /**
+     * @brief Queues a job and invokes a callback with its result on the worker thread.
+     *
+     * The callback receives the job's return value (or nothing, for void jobs). If the
+     * job or the callback throws, the error (of any type) is reported on std::cerr
+     * and the worker moves on to the next job.
+     */
+    template <typename F, typename Callback>
+    void post(std::string alias, std::string connection_string, F&& job, Callback&& on_done);
+
+    /**
+     * @brief Executes a query on a worker and materializes all of its rows.
+     */
+    [[nodiscard]] std::future<std::expected<ResultSet, OdbcError>> query(std::string alias, std::string connection_string, std::string sql);
+
+    [[nodiscard]] std::size_t thread_count() const noexcept { return m_workers.size(); }
+
+    /**
+     * @brief Approximate number of jobs waiting to run.
+     */
+    [[nodiscard]] std::size_t pending() const noexcept;
+
+private:
+    std::vector<std::unique_ptr<MpmcQueue<Job>>> m_queues;
+    std::atomic<std::size_t> m_next_queue{0};
+    std::atomic<std::uint32_t> m_work_signal{0};
+    std::atomic<bool> m_stopping{false};
+    std::vector<std::jthread> m_workers;
+
+    bool try_enqueue(Job& job);
+    void enqueue(Job job);
+    std::optional<Job> next_job(std::size_t worker);
+    void worker_loop(std::size_t worker);
+};
+
+
+// --- Implementation ---
+
+inline Executor::Executor(ExecutorOptions options) {
+    const std::size_t threads = std::max<std::size_t>(1, options.threads);
+    const std::size_t per_worker = std::max<std::size_t>(2, (options.queue_capacity + threads - 1) / threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        m_queues.push_back(std::make_unique<MpmcQueue<Job>>(per_worker));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        m_workers.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+inline Executor::~Executor() {
+    m_stopping.store(true, std::memory_order_release);
+    m_work_signal.fetch_add(1, std::memory_order_release);
+    m_work_signal.notify_all();
+    m_workers.clear();
+}
+
+inline std::size_t Executor::pending() const noexcept {
+    std::size_t total = 0;
+    for (const auto& queue : m_queues) total += queue->size_approx();
+    return total;
+}
+
+inline bool Executor::try_enqueue(Job& job) {
+    // Spread submissions round-robin; fall back to any queue with room.
+    const std::size_t start = m_next_queue.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        if (m_queues[(start + i) % m_queues.size()]->try_push(job)) {
+            m_work_signal.fetch_add(1, std::memory_order_release);
+            m_work_signal.notify_one();
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void Executor::enqueue(Job job) {
+    // Back-pressure: the queue is full only under overload, so a short backoff is enough.
+    auto backoff = std::chrono::microseconds(1);
+    while (!try_enqueue(job)) {
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+    }
+}
+
+inline std::optional<Executor::Job> Executor::next_job(std::size_t worker) {
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        if (auto job = m_queues[(worker + i) % m_queues.size()]->try_pop()) {
+            return job;
+        }
+    }
+    return std::nullopt;
+}
+
+inline void Executor::worker_loop(std::size_t worker) {
+    for (;;) {
+        // Read the signal before scanning: a job queued after the scan changes it, so wait() returns.
+        const std::uint32_t observed = m_work_signal.load(std::memory_order_acquire);
+        if (auto job = next_job(worker)) {
+            (*job)();
+            continue;
+        }
+        if (m_stopping.load(std::memory_order_acquire)) {
+            return;
+        }
+        m_work_signal.wait(observed, std::memory_order_acquire);
+    }
+}
+
+template <typename F>
+inline std::optional<std::future<std::invoke_result_t<std::decay_t<F>&>>> Executor::try_submit(F&& job) {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+    std::packaged_task<Result()> task(std::forward<F>(job));
+    auto future = task.get_future();
+    Job wrapped(std::move(task));
+    if (!try_enqueue(wrapped)) {
+        return std::nullopt;
+    }
+    return future;
+}
+
+template <typename F>
+inline std::future<std::invoke_result_t<std::decay_t<F>&>> Executor::submit(F&& job) {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+    std::packaged_task<Result()> task(std::forward<F>(job));
+    auto future = task.get_future();
+    enqueue(Job(std::move(task)));
+    return future;
+}
+
+template <typename F>
+inline std::future<std::invoke_result_t<std::decay_t<F>&, Connection&>> Executor::submit(std::string alias, std::string connection_string, F&& job) {
+    return submit([alias = std::move(alias), connection_string = std::move(connection_string), job = std::forward<F>(job)]() mutable {
+        return std::invoke(job, getThreadLocalConnection(alias, connection_string));
+    });
+}
+
+template <typename F, typename Callback>
+inline void Executor::post(std::string alias, std::string connection_string, F&& job, Callback&& on_done) {
+    enqueue([alias = std::move(alias), connection_string = std::move(connection_string),
+             job = std::forward<F>(job), on_done = std::forward<Callback>(on_done)]() mutable {
+        try {
+            Connection& connection = getThreadLocalConnection(alias, connection_string);
+            if constexpr (std::is_void_v<std::invoke_result_t<F&, Connection&>>) {
+                std::invoke(job, connection);
+                std::invoke(on_done);
+            } else {
+                std::invoke(on_done, std::invoke(job, connection));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << std::format("[Executor] Job for alias '{}' failed: {}\n", alias, e.what());
+        } catch (...) {
+            // Anything escaping here would reach the worker's std::jthread and terminate.
+            std::cerr << std::format("[Executor] Job for alias '{}' failed: unknown exception\n", alias);
+        }
+    });
+}
+
+inline std::future<std::expected<ResultSet, OdbcError>> Executor::query(std::string alias, std::string connection_string, std::string sql) {
+    return submit(std::move(alias), std::move(connection_string), [sql = std::move(sql)](Connection& connection) -> std::expected<ResultSet, OdbcError> {
+        Statement stmt(connection);
+        if (auto exec_res = stmt.execute_direct(sql); !exec_res) {
+            return std::unexpected(exec_res.error());
+        }
+        return materialize(stmt);
+    });
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_EXECUTOR_H
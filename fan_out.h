@@ -0,0 +1,202 @@
+#ifndef MODERN_ODBC_FAN_OUT_H
+#define MODERN_ODBC_FAN_OUT_H
+
+/**
+ * @file fan_out.h
+ * @brief Runs independent queries concurrently and joins their results.
+ *
+ * odbc::when_all() submits every query to an Executor, where each one runs on
+ * a worker's own connection, and waits until all of them have finished. The
+ * total latency is therefore close to that of the slowest query instead of the
+ * sum of all of them.
+ *
+ * If any query fails, when_all() returns that first error immediately. Queries
+ * that have not started yet are skipped and queries that are still running are
+ * interrupted with SQLCancel.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "executor.h"
+#include "result_set.h"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct QueryTask
+ * @brief One query of a fan-out: where to run it and what to do with the statement.
+ * @tparam T The value produced by the task on success.
+ */
+template <typename T>
+struct QueryTask {
+    std::string alias;
+    std::string connection_string;
+    std::move_only_function<std::expected<T, OdbcError>(Statement&)> body;
+};
+
+/**
+ * @brief Creates a task that executes a query and materializes all of its rows.
+ */
+inline QueryTask<ResultSet> query(std::string alias, std::string connection_string, std::string sql) {
+    return {std::move(alias), std::move(connection_string),
+            [sql = std::move(sql)](Statement& stmt) -> std::expected<ResultSet, OdbcError> {
+                if (auto exec_res = stmt.execute_direct(sql); !exec_res) {
+                    return std::unexpected(exec_res.error());
+                }
+                return materialize(stmt);
+            }};
+}
+
+/**
+ * @brief Creates a task from a callable taking odbc::Statement& and returning std::expected<T, OdbcError>.
+ */
+template <typename F>
+auto make_task(std::string alias, std::string connection_string, F&& body) {
+    using Result = std::invoke_result_t<std::decay_t<F>&, Statement&>;
+    return QueryTask<typename Result::value_type>{std::move(alias), std::move(connection_string), std::forward<F>(body)};
+}
+
+namespace detail {
+
+    /**
+     * @struct FanOutState
+     * @brief Completion and cancellation state shared by the queries of one when_all() call.
+     *
+     * Held through a shared_ptr so that workers can still finish (or notice the
+     * cancellation) after when_all() has already returned an error.
+     */
+    template <typename... T>
+    struct FanOutState {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t remaining = sizeof...(T);
+        std::optional<OdbcError> first_error;
+        std::vector<SQLHSTMT> running;
+        std::tuple<std::optional<T>...> results;
+
+        /**
+         * @brief Registers a statement that is about to execute.
+         * @return false if the fan-out has already failed and the query should not run.
+         */
+        bool start(SQLHSTMT handle) {
+            std::scoped_lock lock(mutex);
+            if (first_error) return false;
+            running.push_back(handle);
+            return true;
+        }
+
+        void stop(SQLHSTMT handle) {
+            std::scoped_lock lock(mutex);
+            std::erase(running, handle);
+        }
+
+        void fail(OdbcError error) {
+            std::scoped_lock lock(mutex);
+            if (!first_error) {
+                first_error = std::move(error);
+                // Statements stay registered until stop(), which takes the same lock,
+                // so every handle here is still allocated.
+                for (SQLHSTMT handle : running) {
+                    SQLCancel(handle);
+                }
+            }
+            --remaining;
+            changed.notify_all();
+        }
+
+        template <std::size_t I, typename V>
+        void succeed(V&& value) {
+            std::scoped_lock lock(mutex);
+            std::get<I>(results).emplace(std::forward<V>(value));
+            --remaining;
+            changed.notify_all();
+        }
+
+        void skip() {
+            std::scoped_lock lock(mutex);
+            --remaining;
+            changed.notify_all();
+        }
+    };
+
+    template <std::size_t I, typename State, typename T>
+    void submit_fan_out_task(Executor& executor, const std::shared_ptr<State>& state, QueryTask<T> task) {
+        (void)executor.submit([state, task = std::move(task)]() mutable {
+            std::optional<Statement> stmt;
+            try {
+                stmt.emplace(getThreadLocalConnection(task.alias, task.connection_string));
+            } catch (const std::exception& e) {
+                state->fail(OdbcError{"08001", 0, e.what()});
+                return;
+            } catch (...) {
+                // Escaping into the executor job would leave when_all() waiting for this task.
+                state->fail(OdbcError{"HY000", 0, "Unknown exception in fan-out task"});
+                return;
+            }
+            if (!state->start(stmt->get())) {
+                state->skip();
+                return;
+            }
+            std::expected<T, OdbcError> result = [&]() -> std::expected<T, OdbcError> {
+                try {
+                    return task.body(*stmt);
+                } catch (const std::exception& e) {
+                    return std::unexpected(OdbcError{"HY000", 0, e.what()});
+                } catch (...) {
+                    return std::unexpected(OdbcError{"HY000", 0, "Unknown exception in fan-out task"});
+                }
+            }();
+            state->stop(stmt->get());
+            if (result) {
+                state->template succeed<I>(std::move(*result));
+            } else {
+                state->fail(std::move(result.error()));
+            }
+        });
+    }
+
+} // namespace detail
+
+/**
+ * @brief Runs independent queries concurrently on an Executor and returns all results.
+ *
+ * Each query runs on a different worker when enough workers are idle, using that
+ * worker's connection for the task's alias. Results are returned in argument order.
+ * Do not call this from a worker of the same executor: the calling worker would
+ * block while its own queue may hold one of the tasks.
+ *
+ * @param executor The executor whose workers run the queries.
+ * @param tasks The queries, e.g. odbc::query("DB", conn_str, "SELECT ...").
+ * @return A tuple with one value per task, or the first error reported by any task.
+ *         Connection failures are reported as SQLSTATE 08001.
+ */
+template <typename... T>
+[[nodiscard]] std::expected<std::tuple<T...>, OdbcError> when_all(Executor& executor, QueryTask<T>... tasks) {
+    auto state = std::make_shared<detail::FanOutState<T...>>();
+
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (detail::submit_fan_out_task<I>(executor, state, std::move(tasks)), ...);
+    }(std::index_sequence_for<T...>{});
+
+    std::unique_lock lock(state->mutex);
+    state->changed.wait(lock, [&] { return state->remaining == 0 || state->first_error.has_value(); });
+    if (state->first_error) {
+        return std::unexpected(*state->first_error);
+    }
+    return std::apply([](auto&... values) { return std::tuple<T...>(std::move(*values)...); }, state->results);
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_FAN_OUT_H
@@ -0,0 +1,147 @@
+#ifndef MODERN_ODBC_INSTRUMENTATION_H
+#define MODERN_ODBC_INSTRUMENTATION_H
+
+/**
+ * @file instrumentation.h
+ * @brief Compile-time instrumentation policies for BasicConnection and BasicStatement.
+ *
+ * A policy provides a Scope type constructed at the start of each instrumented
+ * call (connect, prepare, execute, fetch, get_data) with the phase, the handle,
+ * the statement's metrics series and its execution state (query statistics
+ * entry and per-execution timing; either may be null), and destroyed when the call returns. TraceInstrumentation records
+ * trace spans (see trace.h); StandardInstrumentation records trace spans,
+ * latency metrics (see metrics.h), per-fingerprint query statistics (see
+ * query_stats.h) and the totals of the active request profile (see
+ * request_profile.h). Each can still be switched on and off at run time.
+ * NullInstrumentation has an empty Scope and compiles to nothing.
+ *
+ * odbc::Connection and odbc::Statement use DefaultInstrumentation, which is
+ * StandardInstrumentation unless the build defines MODERN_ODBC_INSTRUMENTATION=0.
+ * Either policy can also be chosen per object, e.g.
+ *   odbc::BasicStatement<odbc::NullInstrumentation> stmt(conn);
+ * for a hot path that must never pay for instrumentation.
+ */
+
+#include "trace.h"
+#include "metrics.h"
+#include "query_stats.h"
+#include <chrono>
+
+#ifndef MODERN_ODBC_INSTRUMENTATION
+#define MODERN_ODBC_INSTRUMENTATION 1
+#endif
+
+namespace odbc {
+
+/**
+ * @struct TraceInstrumentation
+ * @brief Records a span per call while tracing is enabled.
+ */
+struct TraceInstrumentation {
+    static constexpr bool enabled = true;
+    static constexpr bool query_stats = false;
+
+    struct Scope : TraceScope {
+        Scope(TracePhase phase, const void* handle, const detail::StatementMetrics*, detail::StatementExecution*) noexcept
+            : TraceScope(phase, handle) {}
+    };
+};
+
+/**
+ * @struct StandardInstrumentation
+ * @brief Records a span per call while tracing is enabled, the latency of
+ *        prepare, execute and fetch calls while metrics are enabled, and the
+ *        calls and execute/fetch time of each query fingerprint and execution,
+ *        and the round trips and database time of the active request profile.
+ */
+struct StandardInstrumentation {
+    static constexpr bool enabled = true;
+    static constexpr bool query_stats = true;
+
+    class Scope {
+    public:
+        Scope(TracePhase phase, const void* handle, const detail::StatementMetrics* metrics, detail::StatementExecution* execution) noexcept
+            : m_trace(phase, handle), m_phase(phase) {
+            if (metrics != nullptr && detail::metrics_on.load(std::memory_order_relaxed)) {
+                switch (phase) {
+                    case TracePhase::prepare: m_histogram = &metrics->prepare; break;
+                    case TracePhase::execute: m_histogram = &metrics->execute; break;
+                    case TracePhase::first_row: m_histogram = &metrics->first_row; break;
+                    case TracePhase::fetch: m_histogram = &metrics->fetch; break;
+                    default: break;   // connect is timed by the pools; get_data is too fine-grained
+                }
+            }
+            if (execution != nullptr && execution->query != nullptr &&
+                (phase == TracePhase::execute || phase == TracePhase::first_row || phase == TracePhase::fetch)) {
+                m_execution = execution;
+                if (phase == TracePhase::execute) {
+                    execution->query->calls.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (detail::RequestCounters* request = detail::active_request) [[unlikely]] {
+                m_request = request;
+                if (phase != TracePhase::get_data) {
+                    request->round_trips.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (m_histogram != nullptr || m_execution != nullptr || m_request != nullptr) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope() {
+            if (m_histogram == nullptr && m_execution == nullptr && m_request == nullptr) {
+                return;
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - m_start;
+            if (m_histogram != nullptr) {
+                m_histogram->record(elapsed);
+            }
+            if (m_execution != nullptr) {
+                m_execution->query->add_time(elapsed);
+                switch (m_phase) {
+                    case TracePhase::execute: m_execution->execute += elapsed; break;
+                    case TracePhase::first_row: m_execution->first_row += elapsed; break;
+                    default: m_execution->fetch += elapsed; break;
+                }
+            }
+            if (m_request != nullptr) {
+                m_request->db_ns.fetch_add(static_cast<std::uint64_t>(std::chrono::nanoseconds(elapsed).count()), std::memory_order_relaxed);
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TraceScope m_trace;
+        const Histogram* m_histogram = nullptr;
+        TracePhase m_phase;
+        detail::StatementExecution* m_execution = nullptr;
+        detail::RequestCounters* m_request = nullptr;
+        std::chrono::steady_clock::time_point m_start;
+    };
+};
+
+/**
+ * @struct NullInstrumentation
+ * @brief Records nothing; every Scope is optimized away.
+ */
+struct NullInstrumentation {
+    static constexpr bool enabled = false;
+    static constexpr bool query_stats = false;
+
+    struct Scope {
+        constexpr Scope(TracePhase, const void*, const detail::StatementMetrics*, detail::StatementExecution*) noexcept {}
+    };
+};
+
+#if MODERN_ODBC_INSTRUMENTATION
+using DefaultInstrumentation = StandardInstrumentation;
+#else
+using DefaultInstrumentation = NullInstrumentation;
+#endif
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_INSTRUMENTATION_H
@@ -0,0 +1,327 @@
+#ifndef MODERN_ODBC_KEYSET_PAGER_H
+#define MODERN_ODBC_KEYSET_PAGER_H
+
+/**
+ * @file keyset_pager.h
+ * @brief Keyset (seek) pagination with opaque resume tokens.
+ *
+ * OFFSET paging makes the database read and discard every row before the
+ * requested page, so page N costs N times page 1. Keyset paging instead
+ * remembers the sort key of the last row returned and continues with
+ * "WHERE key > last ORDER BY key", which an index on the key answers directly;
+ * every page costs the same.
+ *
+ * KeysetPager wraps a base query, orders it by a key tuple that must be unique
+ * and non-NULL (add the primary key as the last column if needed), and encodes
+ * the last row's key values in a compact base64url token that the caller hands
+ * back for the next page.
+ */
+
+#include "odbc_wrapper.h"
+#include "result_set.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct KeysetColumn
+ * @brief One column of the ordered key tuple.
+ */
+struct KeysetColumn {
+    std::string name;
+    bool descending = false;
+};
+
+/**
+ * @enum PageLimitSyntax
+ * @brief How the page size is expressed in SQL.
+ */
+enum class PageLimitSyntax {
+    offset_fetch,   ///< OFFSET 0 ROWS FETCH NEXT n ROWS ONLY (SQL Server, Oracle, PostgreSQL, DB2)
+    limit           ///< LIMIT n (MySQL, SQLite, PostgreSQL)
+};
+
+/**
+ * @struct KeysetPage
+ * @brief One page of rows and the token for the page after it.
+ */
+struct KeysetPage {
+    ResultSet rows;
+    std::optional<std::string> next_token;   ///< std::nullopt on the last page.
+};
+
+/**
+ * @class KeysetPager
+ * @brief Generates and runs keyset-paginated queries over a base query.
+ */
+class KeysetPager {
+public:
+    /**
+     * @param base_query The unpaged query, optionally with '?' markers; it is used as a
+     *        derived table, so it must not contain ORDER BY and must select every key column.
+     * @param keys The ordered key tuple; together the columns must identify a row.
+     * @param page_size Rows per page.
+     * @param syntax The dialect used to limit the page size.
+     */
+    KeysetPager(std::string base_query, std::vector<KeysetColumn> keys, std::size_t page_size,
+                PageLimitSyntax syntax = PageLimitSyntax::offset_fetch);
+
+    /**
+     * @brief Fetches one page.
+     *
+     * @param stmt The statement to prepare and execute the page query on.
+     * @param token Empty for the first page, otherwise a next_token from a previous page.
+     * @param base_parameters Values for the markers in the base query.
+     * @return The page, or an error; a token from a different pager is rejected with SQLSTATE HY024.
+     */
+    [[nodiscard]] std::expected<KeysetPage, OdbcError> fetch(Statement& stmt, std::string_view token = {},
+                                                             std::vector<Parameter> base_parameters = {}) const;
+
+    /**
+     * @brief The generated SQL for the first page or for a continuation page.
+     */
+    [[nodiscard]] const std::string& query(bool continuation) const noexcept {
+        return continuation ? m_continuation_query : m_first_query;
+    }
+
+    /**
+     * @brief Encodes key values (one per key column) as a resume token.
+     */
+    [[nodiscard]] std::string encode_token(const std::vector<Parameter>& key_values) const;
+
+    /**
+     * @brief Decodes a resume token into its key values.
+     */
+    [[nodiscard]] std::expected<std::vector<Parameter>, OdbcError> decode_token(std::string_view token) const;
+
+    [[nodiscard]] std::size_t page_size() const noexcept { return m_page_size; }
+
+private:
+    std::vector<KeysetColumn> m_keys;
+    std::size_t m_page_size;
+    std::uint32_t m_fingerprint;   // ties tokens to this pager's query and keys
+    std::string m_first_query;
+    std::string m_continuation_query;
+};
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    inline constexpr std::string_view base64url_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    inline std::string base64url_encode(std::string_view bytes) {
+        std::string out;
+        out.reserve((bytes.size() * 4 + 2) / 3);
+        std::uint32_t buffer = 0;
+        int bits = 0;
+        for (unsigned char c : bytes) {
+            buffer = (buffer << 8) | c;
+            bits += 8;
+            while (bits >= 6) {
+                bits -= 6;
+                out.push_back(base64url_alphabet[(buffer >> bits) & 0x3F]);
+            }
+        }
+        if (bits > 0) {
+            out.push_back(base64url_alphabet[(buffer << (6 - bits)) & 0x3F]);
+        }
+        return out;
+    }
+
+    inline std::optional<std::string> base64url_decode(std::string_view text) {
+        std::string out;
+        out.reserve(text.size() * 3 / 4);
+        std::uint32_t buffer = 0;
+        int bits = 0;
+        for (char c : text) {
+            const auto pos = base64url_alphabet.find(c);
+            if (pos == std::string_view::npos) return std::nullopt;
+            buffer = (buffer << 6) | static_cast<std::uint32_t>(pos);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+            }
+        }
+        return out;
+    }
+
+    inline std::uint32_t fnv1a32(std::string_view text, std::uint32_t hash = 2166136261u) {
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+} // namespace detail
+
+inline KeysetPager::KeysetPager(std::string base_query, std::vector<KeysetColumn> keys, std::size_t page_size, PageLimitSyntax syntax)
+    : m_keys(std::move(keys)), m_page_size(std::max<std::size_t>(1, page_size)) {
+    if (m_keys.empty()) {
+        throw OdbcSetupError("KeysetPager needs at least one key column.");
+    }
+
+    std::string order_by;
+    for (const auto& key : m_keys) {
+        order_by += std::format("{}{}{}", order_by.empty() ? "" : ", ", key.name, key.descending ? " DESC" : "");
+    }
+
+    // (k1, k2) > (?, ?) expanded to k1 > ? OR (k1 = ? AND k2 > ?), which every dialect supports
+    // and which also handles mixed sort directions.
+    std::string seek;
+    for (std::size_t i = 0; i < m_keys.size(); ++i) {
+        std::string term;
+        for (std::size_t j = 0; j < i; ++j) {
+            term += std::format("{} = ? AND ", m_keys[j].name);
+        }
+        term += std::format("{} {} ?", m_keys[i].name, m_keys[i].descending ? "<" : ">");
+        seek += std::format("{}({})", seek.empty() ? "" : " OR ", term);
+    }
+
+    const std::string limit = (syntax == PageLimitSyntax::limit)
+        ? std::format(" LIMIT {}", m_page_size)
+        : std::format(" OFFSET 0 ROWS FETCH NEXT {} ROWS ONLY", m_page_size);
+    const std::string from = std::format("SELECT * FROM ({}) keyset_page", base_query);
+    m_first_query = std::format("{} ORDER BY {}{}", from, order_by, limit);
+    m_continuation_query = std::format("{} WHERE {} ORDER BY {}{}", from, seek, order_by, limit);
+
+    m_fingerprint = detail::fnv1a32(base_query);
+    for (const auto& key : m_keys) {
+        m_fingerprint = detail::fnv1a32(std::string_view(key.descending ? "D" : "A", 1), detail::fnv1a32(key.name, m_fingerprint));
+    }
+}
+
+// Token layout: 4-byte fingerprint, then per key a type tag ('N', 'I', 'R', 'S')
+// followed by 8 bytes for numbers or a 4-byte length and the bytes for text.
+inline std::string KeysetPager::encode_token(const std::vector<Parameter>& key_values) const {
+    std::string bytes(reinterpret_cast<const char*>(&m_fingerprint), sizeof(m_fingerprint));
+    for (const auto& value : key_values) {
+        std::visit([&](const auto& v) {
+            using V = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<V, std::monostate>) {
+                bytes.push_back('N');
+            } else if constexpr (std::is_same_v<V, long long> || std::is_same_v<V, double>) {
+                bytes.push_back(std::is_same_v<V, long long> ? 'I' : 'R');
+                bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+            } else {
+                bytes.push_back('S');
+                const auto length = static_cast<std::uint32_t>(v.size());
+                bytes.append(reinterpret_cast<const char*>(&length), sizeof(length)).append(v);
+            }
+        }, value);
+    }
+    return detail::base64url_encode(bytes);
+}
+
+inline std::expected<std::vector<Parameter>, OdbcError> KeysetPager::decode_token(std::string_view token) const {
+    const OdbcError invalid{"HY024", 0, "Invalid page token."};
+    auto bytes = detail::base64url_decode(token);
+    std::uint32_t fingerprint = 0;
+    if (!bytes || bytes->size() < sizeof(fingerprint)) {
+        return std::unexpected(invalid);
+    }
+    std::memcpy(&fingerprint, bytes->data(), sizeof(fingerprint));
+    if (fingerprint != m_fingerprint) {
+        return std::unexpected(invalid);
+    }
+
+    std::vector<Parameter> values;
+    std::size_t pos = sizeof(fingerprint);
+    auto read = [&](void* out, std::size_t size) {
+        if (bytes->size() - pos < size) return false;
+        std::memcpy(out, bytes->data() + pos, size);
+        pos += size;
+        return true;
+    };
+    while (pos < bytes->size() && values.size() < m_keys.size()) {
+        const char tag = (*bytes)[pos++];
+        if (tag == 'N') {
+            values.emplace_back();
+        } else if (tag == 'I' || tag == 'R') {
+            long long integer = 0;
+            double real = 0;
+            if (!(tag == 'I' ? read(&integer, sizeof(integer)) : read(&real, sizeof(real)))) return std::unexpected(invalid);
+            values.push_back(tag == 'I' ? Parameter{integer} : Parameter{real});
+        } else if (tag == 'S') {
+            std::uint32_t length = 0;
+            if (!read(&length, sizeof(length)) || bytes->size() - pos < length) return std::unexpected(invalid);
+            values.emplace_back(bytes->substr(pos, length));
+            pos += length;
+        } else {
+            return std::unexpected(invalid);
+        }
+    }
+    if (values.size() != m_keys.size() || pos != bytes->size()) {
+        return std::unexpected(invalid);
+    }
+    return values;
+}
+
+inline std::expected<KeysetPage, OdbcError> KeysetPager::fetch(Statement& stmt, std::string_view token,
+                                                               std::vector<Parameter> base_parameters) const {
+    const bool continuation = !token.empty();
+    if (continuation) {
+        auto last_key = decode_token(token);
+        if (!last_key) {
+            return std::unexpected(last_key.error());
+        }
+        for (std::size_t i = 0; i < m_keys.size(); ++i) {
+            for (std::size_t j = 0; j <= i; ++j) {
+                base_parameters.push_back((*last_key)[j]);
+            }
+        }
+    }
+
+    if (auto prepared = stmt.prepare(query(continuation)); !prepared) {
+        return std::unexpected(prepared.error());
+    }
+    stmt.clear_parameters();
+    for (std::size_t i = 0; i < base_parameters.size(); ++i) {
+        stmt.bind_parameter(static_cast<SQLUSMALLINT>(i + 1), std::move(base_parameters[i]));
+    }
+    if (auto exec_res = stmt.execute(); !exec_res) {
+        return std::unexpected(exec_res.error());
+    }
+    auto rows = materialize(stmt);
+    (void)stmt.close_cursor();
+    if (!rows) {
+        return std::unexpected(rows.error());
+    }
+
+    KeysetPage page{std::move(*rows), std::nullopt};
+    // A short page is the last one; a full page may be followed by an empty one.
+    if (page.rows.row_count() == m_page_size) {
+        const std::size_t last = page.rows.row_count() - 1;
+        std::vector<Parameter> key_values;
+        for (const auto& key : m_keys) {
+            auto column = page.rows.find_column(key.name);
+            if (!column) {
+                return std::unexpected(OdbcError{"42S22", 0, std::format("Key column '{}' is not in the result.", key.name)});
+            }
+            switch (page.rows.column_kind(*column)) {
+                case ResultSet::ColumnKind::integer: key_values.emplace_back(page.rows.get<long long>(last, *column).value_or(0)); break;
+                case ResultSet::ColumnKind::real: key_values.emplace_back(page.rows.get<double>(last, *column).value_or(0.0)); break;
+                case ResultSet::ColumnKind::text: key_values.emplace_back(page.rows.get<std::string>(last, *column).value_or(std::string{})); break;
+            }
+        }
+        page.next_token = encode_token(key_values);
+    }
+    return page;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_KEYSET_PAGER_H
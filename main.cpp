@@ -1,4 +1,26 @@
 #include "odbc_wrapper.h"
+#include "sharded_connection_pool.h"
+#include "executor.h"
+#include "fan_out.h"
+#include "single_flight.h"
+#include "point_lookup_batcher.h"
+#include "data_loader.h"
+#include "reference_table.h"
+#include "result_cache.h"
+#include "snapshot_file.h"
+#include "change_poller.h"
+#include "keyset_pager.h"
+#include "write_behind.h"
+#include "table_copy.h"
+#include "trace.h"
+#include "metrics.h"
+#include "query_stats.h"
+#include "async_logger.h"
+#include "slow_query_log.h"
+#include "request_profile.h"
+#include "resource_usage.h"
+#include "pool_telemetry.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -8,6 +30,9 @@
 #include <stdexcept>
 #include <future>
 #include <mutex>
+#include <optional>
+#include <format>
+#include <filesystem>
 
 // --- Configuration ---
 // Use preprocessor directives to set the connection string based on the OS.
@@ -66,6 +91,10 @@ void setup_database_schema() {
     handle_execute_result(stmt, stmt.execute_direct("DROP TABLE IF EXISTS test_table"), "DROP TABLE");
     handle_execute_result(stmt, stmt.execute_direct("CREATE TABLE test_table (id INT, name VARCHAR(100), value REAL)"), "CREATE TABLE");
     handle_execute_result(stmt, stmt.execute_direct("INSERT INTO test_table VALUES (1, 'First', 10.5), (2, NULL, 20.25)"), "INSERT");
+    handle_execute_result(stmt, stmt.execute_direct("DROP TABLE IF EXISTS write_behind_log"), "DROP TABLE");
+    handle_execute_result(stmt, stmt.execute_direct("CREATE TABLE write_behind_log (id INT, note VARCHAR(100))"), "CREATE TABLE");
+    handle_execute_result(stmt, stmt.execute_direct("DROP TABLE IF EXISTS copy_target"), "DROP TABLE");
+    handle_execute_result(stmt, stmt.execute_direct("CREATE TABLE copy_target (id INT, name VARCHAR(100), value REAL)"), "CREATE TABLE");
 
     std::cout << "--- Setup Complete ---" << std::endl;
 }
@@ -110,11 +139,565 @@ void setup_database_schema() {
     return true;
 }
 
+[[nodiscard]] bool test_sharded_pool_checkout() {
+    ShardingOptions options;
+    options.mode = ShardingMode::per_cpu;
+    options.max_connections_per_shard = 2;
+    ShardedConnectionPool pool("TEST_SHARDED", std::string(CONNECTION_STRING), options);
+
+    {
+        auto lease = pool.acquire();
+        odbc::Statement stmt(*lease);
+        auto exec_res = stmt.execute_direct("SELECT id FROM test_table WHERE id = 1");
+        ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+        auto fetch_res = stmt.fetch();
+        ASSERT_TRUE(fetch_res.has_value() && *fetch_res, "Fetch through a pooled connection returned no data.");
+    }
+
+    // The first connection is idle again (on its owning shard); a second concurrent
+    // lease must get a distinct connection.
+    auto again = pool.acquire();
+    auto second = pool.acquire();
+    ASSERT_TRUE(second->get() != again->get(), "Two leases share one connection handle.");
+    return true;
+}
+
+[[nodiscard]] bool test_nested_statement_in_fetch_loop() {
+    auto outer = getThreadLocalStatement("TEST_MARS", CONNECTION_STRING);
+    auto exec_res = outer->execute_direct("SELECT id FROM test_table ORDER BY id");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+
+    int rows = 0;
+    while (true) {
+        auto fetch_res = outer->fetch();
+        ASSERT_TRUE(fetch_res.has_value(), fetch_res.error().to_string());
+        if (!*fetch_res) break;
+        auto id_res = outer->get_data<long>(1);
+        ASSERT_TRUE(id_res.has_value() && id_res->has_value(), "Outer get_data failed.");
+
+        // Runs while the outer cursor is still open: shares the connection with MARS,
+        // or transparently gets a secondary connection without it.
+        auto inner = getThreadLocalStatement("TEST_MARS", CONNECTION_STRING);
+        auto inner_res = inner->execute_direct(std::format("SELECT name FROM test_table WHERE id = {}", **id_res));
+        ASSERT_TRUE(inner_res.has_value(), inner_res.error().to_string());
+        auto inner_fetch = inner->fetch();
+        ASSERT_TRUE(inner_fetch.has_value() && *inner_fetch, "Nested query returned no data.");
+        ++rows;
+    }
+    ASSERT_TRUE(rows == 2, "Expected two rows in the outer query.");
+    return true;
+}
+
+[[nodiscard]] bool test_executor_query() {
+    odbc::Executor executor({2, 16});
+    auto future = executor.query("TEST_EXECUTOR", std::string(CONNECTION_STRING), "SELECT id, name, value FROM test_table ORDER BY id");
+    auto result = future.get();
+    ASSERT_TRUE(result.has_value(), result.error().to_string());
+    ASSERT_TRUE(result->row_count() == 2, "Expected two materialized rows.");
+    ASSERT_TRUE(result->get<long>(0, 0) == 1L, "First id was not 1.");
+    ASSERT_TRUE(result->get<std::string>(0, 1) == "First", "First name was not 'First'.");
+    ASSERT_TRUE(result->is_null(1, 1), "Second name was expected to be NULL.");
+    return true;
+}
+
+[[nodiscard]] bool test_when_all_queries() {
+    odbc::Executor executor({2, 16});
+    const std::string conn_str(CONNECTION_STRING);
+    auto result = odbc::when_all(executor,
+        odbc::query("TEST_FANOUT", conn_str, "SELECT id FROM test_table WHERE id = 1"),
+        odbc::make_task("TEST_FANOUT", conn_str, [](odbc::Statement& stmt) -> std::expected<long, odbc::OdbcError> {
+            if (auto exec_res = stmt.execute_direct("SELECT COUNT(*) FROM test_table"); !exec_res) {
+                return std::unexpected(exec_res.error());
+            }
+            if (auto fetch_res = stmt.fetch(); !fetch_res) {
+                return std::unexpected(fetch_res.error());
+            }
+            auto count = stmt.get_data<long>(1);
+            if (!count) return std::unexpected(count.error());
+            return count->value_or(0);
+        }));
+    ASSERT_TRUE(result.has_value(), result.error().to_string());
+    auto& [rows, count] = *result;
+    ASSERT_TRUE(rows.row_count() == 1, "Expected one row from the first query.");
+    ASSERT_TRUE(count == 2, "Expected COUNT(*) to be 2.");
+
+    auto failed = odbc::when_all(executor,
+        odbc::query("TEST_FANOUT", conn_str, "SELECT id FROM test_table"),
+        odbc::query("TEST_FANOUT", conn_str, "SELECT no_such_column FROM test_table"));
+    ASSERT_TRUE(!failed.has_value(), "Expected the invalid query to fail the fan-out.");
+    return true;
+}
+
+[[nodiscard]] bool test_single_flight_parameterized_query() {
+    odbc::SingleFlight flights;
+    std::vector<std::future<odbc::SingleFlight::Result>> results;
+    for (int i = 0; i < 8; ++i) {
+        results.push_back(std::async(std::launch::async, [&flights] {
+            return flights.query("TEST_SINGLE_FLIGHT", CONNECTION_STRING,
+                                 "SELECT name FROM test_table WHERE id = ?", {odbc::Parameter{1LL}});
+        }));
+    }
+    for (auto& future : results) {
+        auto result = future.get();
+        ASSERT_TRUE(result.has_value(), result.error().to_string());
+        ASSERT_TRUE(result->row_count() == 1, "Expected exactly one row.");
+        ASSERT_TRUE(result->get<std::string>(0, 0) == "First", "Unexpected name for id 1.");
+    }
+    ASSERT_TRUE(flights.in_flight() == 0, "A flight was left behind after completion.");
+    return true;
+}
+
+[[nodiscard]] bool test_point_lookup_batching() {
+    odbc::PointLookupBatcher batcher("TEST_BATCHER", std::string(CONNECTION_STRING));
+    const std::string query = "SELECT id, name FROM test_table WHERE id IN ({keys})";
+    auto first = batcher.lookup(query, 1LL);
+    auto second = batcher.lookup(query, 2LL);
+    auto missing = batcher.lookup(query, 3LL);
+
+    auto first_res = first.get();
+    ASSERT_TRUE(first_res.has_value(), first_res.error().to_string());
+    ASSERT_TRUE(first_res->row_count() == 1 && first_res->get<std::string>(0, 1) == "First", "Wrong row for key 1.");
+    auto second_res = second.get();
+    ASSERT_TRUE(second_res.has_value() && second_res->row_count() == 1, "Wrong row count for key 2.");
+    auto missing_res = missing.get();
+    ASSERT_TRUE(missing_res.has_value() && missing_res->row_count() == 0, "Key 3 should match no rows.");
+    return true;
+}
+
+[[nodiscard]] bool test_data_loader_batches_keys() {
+    auto names = odbc::make_query_loader<long long>("TEST_LOADER", std::string(CONNECTION_STRING),
+                                                    "SELECT id, name FROM test_table WHERE id IN ({keys})");
+    std::vector<decltype(names)::Pending> pending;
+    {
+        odbc::DispatchScope tick(names);
+        for (long long id : {1LL, 2LL, 3LL, 1LL}) {
+            pending.push_back(names.load(id));
+        }
+    }
+    ASSERT_TRUE(names.batches_dispatched() == 1, "Expected all keys of one tick in a single batch.");
+
+    auto first = pending[0].get();
+    ASSERT_TRUE(first.has_value() && first->has_value(), "Key 1 was not loaded.");
+    ASSERT_TRUE((*first)->get<std::string>(0, 1) == "First", "Wrong row for key 1.");
+    auto missing = pending[2].get();
+    ASSERT_TRUE(missing.has_value() && !missing->has_value(), "Key 3 should be memoized as not found.");
+
+    (void)names.get(2);
+    ASSERT_TRUE(names.batches_dispatched() == 1, "A memoized key caused another query.");
+    return true;
+}
+
+[[nodiscard]] bool test_result_cache_hit_and_invalidate() {
+    odbc::ResultCache cache;
+    const odbc::CacheEntryOptions options{{"test_table"}, std::chrono::milliseconds(60000)};
+    const char* sql = "SELECT name FROM test_table WHERE id = ?";
+
+    auto first = cache.query("TEST_CACHE", CONNECTION_STRING, sql, {odbc::Parameter{1LL}}, options);
+    ASSERT_TRUE(first.has_value(), first.error().to_string());
+    auto second = cache.query("TEST_CACHE", CONNECTION_STRING, "SELECT name\n  FROM test_table WHERE id = ?", {odbc::Parameter{1LL}}, options);
+    ASSERT_TRUE(second.has_value() && second->get<std::string>(0, 0) == "First", "Cached result is wrong.");
+    ASSERT_TRUE(cache.stats().hits == 1 && cache.stats().misses == 1, "Expected one miss followed by one hit.");
+
+    cache.invalidate("test_table");
+    ASSERT_TRUE(cache.stats().entries == 0, "Invalidation by tag left entries behind.");
+    auto third = cache.query("TEST_CACHE", CONNECTION_STRING, sql, {odbc::Parameter{1LL}}, options);
+    ASSERT_TRUE(third.has_value() && cache.stats().misses == 2, "Expected a reload after invalidation.");
+    return true;
+}
+
+[[nodiscard]] bool test_result_cache_l1_find() {
+    odbc::ResultCache cache;
+    const std::string key = odbc::ResultCache::make_key("TEST_CACHE", "SELECT name FROM test_table WHERE id = ?", {odbc::Parameter{2LL}});
+    const odbc::CacheEntryOptions options{{"test_table"}, std::chrono::milliseconds(60000)};
+    auto loaded = cache.get_or_load(key, [] { return odbc::ResultCache::Result(odbc::ResultSet{}); }, options);
+    ASSERT_TRUE(loaded.has_value(), "Loading the entry failed.");
+
+    const odbc::ResultSet* first = cache.find(key);
+    const odbc::ResultSet* second = cache.find(key);
+    ASSERT_TRUE(first != nullptr && first == second, "Repeated find() should be served from the same L1 slot.");
+
+    // A thread alternating between two caches must not lose the L1 hits it buffered for either.
+    odbc::ResultCache other;
+    auto other_loaded = other.get_or_load(key, [] { return odbc::ResultCache::Result(odbc::ResultSet{}); }, options);
+    ASSERT_TRUE(other_loaded.has_value(), "Loading the second cache failed.");
+    const auto hits_before = cache.stats().hits;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(cache.find(key) != nullptr && other.find(key) != nullptr, "An alternating find() missed.");
+    }
+    ASSERT_TRUE(cache.stats().hits == hits_before + 10 && other.stats().hits == 10,
+                std::format("Alternating L1 hits were lost: {} and {}.", cache.stats().hits - hits_before, other.stats().hits));
+
+    cache.invalidate("test_table");
+    ASSERT_TRUE(cache.find(key) == nullptr, "L1 served an entry after invalidation.");
+    return true;
+}
+
+[[nodiscard]] bool test_reference_table_lookup() {
+    struct Item {
+        long long id;
+        std::optional<std::string> name;
+    };
+    odbc::ReferenceTableOptions options;
+    options.load_query = "SELECT id, name, value FROM test_table";
+    options.index_columns = {"id"};
+    options.version_query = "SELECT COUNT(*) FROM test_table";
+    options.refresh_interval = std::chrono::milliseconds(0);
+    odbc::ReferenceTable<Item, long long> items("TEST_REFERENCE", std::string(CONNECTION_STRING), options,
+        [](const odbc::ResultSet& rows, std::size_t row) { return Item{*rows.get<long long>(row, 0), rows.get<std::string>(row, 1)}; });
+
+    auto first = items.refresh();
+    ASSERT_TRUE(first.has_value() && *first, "Initial load of the reference table failed.");
+    auto item = items.find(1);
+    ASSERT_TRUE(item && item->name == "First", "Lookup by primary key returned the wrong row.");
+    ASSERT_TRUE(!items.find(42), "Lookup of a missing key should return nothing.");
+
+    auto second = items.refresh();
+    ASSERT_TRUE(second.has_value() && !*second, "Refresh should be skipped while the version is unchanged.");
+    return true;
+}
+
+[[nodiscard]] bool test_snapshot_file_round_trip() {
+    auto stmt = getThreadLocalStatement("TEST_SNAPSHOT", CONNECTION_STRING);
+    ASSERT_TRUE(stmt->execute_direct("SELECT id, name FROM test_table ORDER BY id").has_value(), "Query failed.");
+    auto rows = odbc::materialize(*stmt);
+    ASSERT_TRUE(rows.has_value(), "Materializing the result failed.");
+
+    const auto path = std::filesystem::temp_directory_path() / "modern_odbc_test.snap";
+    odbc::SnapshotWriter writer;
+    writer.add("test_table", "v1", *rows);
+    ASSERT_TRUE(writer.write(path).has_value(), "Writing the snapshot failed.");
+
+    auto snapshot = odbc::MappedSnapshot::open(path);
+    ASSERT_TRUE(snapshot.has_value(), snapshot.error().to_string());
+    const auto* entry = snapshot->find("test_table");
+    ASSERT_TRUE(entry && entry->metadata == "v1" && entry->data.row_count() == rows->row_count(), "Snapshot entry does not match.");
+    ASSERT_TRUE(entry->data.get<std::string>(0, 1) == "First", "Mapped result has the wrong contents.");
+    std::filesystem::remove(path);
+    return true;
+}
+
+[[nodiscard]] bool test_change_poller_advances_watermark() {
+    odbc::ChangePollerOptions options;
+    options.query = "SELECT id, name FROM test_table WHERE id > ? ORDER BY id";
+    options.watermark_column = "id";
+    options.block_rows = 1;
+    options.background = false;
+    std::size_t blocks = 0;
+    odbc::ChangePoller poller("TEST_POLLER", std::string(CONNECTION_STRING), options,
+                              [&](const odbc::BlockCursor& block) { blocks += block.rows() > 0; return true; });
+
+    auto first = poller.poll_once();
+    ASSERT_TRUE(first.has_value(), first.error().to_string());
+    ASSERT_TRUE(*first == 2 && blocks == 2, "Expected both rows, one block each.");
+    ASSERT_TRUE(poller.watermark() == odbc::Parameter{2LL}, "Watermark did not advance to the last id.");
+
+    auto second = poller.poll_once();
+    ASSERT_TRUE(second.has_value() && *second == 0, "A second poll should find no new rows.");
+    return true;
+}
+
+[[nodiscard]] bool test_keyset_pager_pages() {
+    odbc::KeysetPager pager("SELECT id, name FROM test_table", {{"id"}}, 1);
+    auto stmt = getThreadLocalStatement("TEST_PAGER", CONNECTION_STRING);
+
+    auto first = pager.fetch(*stmt);
+    ASSERT_TRUE(first.has_value(), first.error().to_string());
+    ASSERT_TRUE(first->rows.get<long long>(0, 0) == 1 && first->next_token, "First page should hold id 1 and a token.");
+
+    auto second = pager.fetch(*stmt, *first->next_token);
+    ASSERT_TRUE(second.has_value(), second.error().to_string());
+    ASSERT_TRUE(second->rows.get<long long>(0, 0) == 2, "Second page should continue after id 1.");
+
+    auto last = pager.fetch(*stmt, *second->next_token);
+    ASSERT_TRUE(last.has_value() && last->rows.empty() && !last->next_token, "Paging should end after the last row.");
+    ASSERT_TRUE(!pager.fetch(*stmt, "not-a-token").has_value(), "A forged token should be rejected.");
+    return true;
+}
+
+[[nodiscard]] bool test_write_behind_flushes_batches() {
+    {
+        odbc::WriteBehindOptions options;
+        options.batch_rows = 2;
+        odbc::WriteBehindQueue<int, std::optional<std::string>> queue("TEST_WRITE_BEHIND", std::string(CONNECTION_STRING),
+                                                                      "write_behind_log", {"id", "note"}, options);
+        ASSERT_TRUE(queue.push(1, "one") && queue.push(2, std::nullopt) && queue.push(3, "three"), "Rows should be queued.");
+        queue.flush();
+        const auto stats = queue.stats();
+        ASSERT_TRUE(stats.flushed_rows == 3 && stats.failed_rows == 0, std::format("Expected 3 flushed rows, got {}.", stats.flushed_rows));
+        ASSERT_TRUE(stats.flushes == 2, "Three rows should take two batches of two.");
+    }
+
+    auto stmt = getThreadLocalStatement("TEST_WRITE_BEHIND", CONNECTION_STRING);
+    auto exec_res = stmt->execute_direct("SELECT COUNT(*) FROM write_behind_log");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    auto fetch_res = stmt->fetch();
+    ASSERT_TRUE(fetch_res.has_value() && *fetch_res, "Count query returned no row.");
+    auto count = stmt->get_data<long long>(1);
+    ASSERT_TRUE(count.has_value() && *count == 3, "Flushed rows are missing from the table.");
+    (void)stmt->close_cursor();
+    return true;
+}
+
+[[nodiscard]] bool test_copy_table_pipelined() {
+    odbc::TableCopyOptions options;
+    options.block_rows = 1;
+    options.commit_rows = 1;
+    std::size_t reports = 0;
+    options.on_progress = [&](const odbc::TableCopyProgress&) { ++reports; };
+
+    auto copied = odbc::copy_table("TEST_COPY_SRC", CONNECTION_STRING, "SELECT id, name, value FROM test_table ORDER BY id",
+                                   "TEST_COPY_DST", CONNECTION_STRING, "copy_target", options);
+    ASSERT_TRUE(copied.has_value(), copied.error().to_string());
+    ASSERT_TRUE(copied->rows_copied == 2 && copied->commits == 2 && reports == 2, "Expected two rows in two commits.");
+
+    auto stmt = getThreadLocalStatement("TEST_COPY_DST", CONNECTION_STRING);
+    auto exec_res = stmt->execute_direct("SELECT COUNT(*) FROM copy_target WHERE name IS NULL AND value = 20.25");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    auto fetch_res = stmt->fetch();
+    ASSERT_TRUE(fetch_res.has_value() && *fetch_res, "Count query returned no row.");
+    auto count = stmt->get_data<long long>(1);
+    ASSERT_TRUE(count.has_value() && *count == 1, "The NULL name should be copied as NULL.");
+    (void)stmt->close_cursor();
+    return true;
+}
+
+[[nodiscard]] bool test_trace_export() {
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    odbc::set_tracing(true);
+    auto stmt = getThreadLocalStatement("TEST_TRACE", CONNECTION_STRING);
+    auto exec_res = stmt->execute_direct("SELECT id FROM test_table WHERE id = 1");
+    auto fetch_res = stmt->fetch();
+    (void)stmt->close_cursor();
+    odbc::set_tracing(false);
+    ASSERT_TRUE(exec_res.has_value() && fetch_res.has_value(), "Traced query failed.");
+
+    const std::string trace = odbc::export_chrome_trace();
+    ASSERT_TRUE(trace.starts_with("{\"traceEvents\":["), "Export is not Chrome trace JSON.");
+    ASSERT_TRUE(trace.find("\"name\":\"execute\"") != std::string::npos, "The execute span is missing.");
+    ASSERT_TRUE(trace.find("\"name\":\"first_row\"") != std::string::npos, "The first fetch should be traced as first_row.");
+    return true;
+}
+
+[[nodiscard]] bool test_null_instrumentation_statement() {
+    odbc::Environment env;
+    odbc::BasicConnection<odbc::NullInstrumentation> conn(env);
+    auto connect_res = conn.driver_connect(CONNECTION_STRING);
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::BasicStatement<odbc::NullInstrumentation> stmt(conn);
+    auto exec_res = stmt.execute_direct("SELECT value FROM test_table WHERE id = 2");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    auto fetch_res = stmt.fetch();
+    ASSERT_TRUE(fetch_res.has_value() && *fetch_res, "Fetch failed or returned no data.");
+    auto value = stmt.get_data<double>(1);
+    ASSERT_TRUE(value.has_value() && *value == 20.25, "Uninstrumented statement read the wrong value.");
+    return true;
+}
+
+[[nodiscard]] bool test_metrics_prometheus_output() {
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    auto stmt = getThreadLocalStatement("TEST_METRICS", CONNECTION_STRING);
+    stmt->set_metrics_label("metrics_test");
+    auto exec_res = stmt->execute_direct("SELECT id FROM test_table");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    while (stmt->fetch().value_or(false)) {}
+    (void)stmt->close_cursor();
+
+    const std::string text = odbc::render_prometheus();
+    ASSERT_TRUE(text.find("# TYPE odbc_execute_duration_seconds histogram") != std::string::npos, "Execute histogram is missing.");
+    ASSERT_TRUE(text.find("odbc_execute_duration_seconds_count{alias=\"TEST_METRICS\",statement=\"metrics_test\"} 1\n") != std::string::npos,
+                "Execute latency was not recorded for the labelled statement.");
+    ASSERT_TRUE(text.find("odbc_pool_connects_total{pool=\"thread_local\",alias=\"TEST_METRICS\"} 1\n") != std::string::npos, "Connect was not counted.");
+    return true;
+}
+
+[[nodiscard]] bool test_query_fingerprint_stats() {
+    ASSERT_TRUE(odbc::normalize_sql("SELECT * FROM t WHERE id IN (1, 2, 3) AND name = 'it''s'") == "select * from t where id in (...) and name = ?",
+                "Literals and the IN-list were not normalized.");
+    ASSERT_TRUE(odbc::sql_fingerprint("select *  from t where id in (4,5) and name='y' -- retry") ==
+                    odbc::sql_fingerprint("SELECT * FROM t WHERE id IN (1, 2, 3) AND name = 'x'"),
+                "Queries of the same shape have different fingerprints.");
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    auto stmt = getThreadLocalStatement("TEST_QUERY_STATS", CONNECTION_STRING);
+    for (std::string_view query : {"SELECT id FROM test_table WHERE id IN (1, 2) AND value > 0.5 ORDER BY id",
+                                   "select id from test_table where id in (1,2,3) and value > 5 order by id"}) {
+        auto exec_res = stmt->execute_direct(query);
+        ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+        while (stmt->fetch().value_or(false)) {
+            (void)stmt->get_data<long long>(1);
+        }
+        (void)stmt->close_cursor();
+    }
+
+    const auto fingerprint = odbc::sql_fingerprint("SELECT id FROM test_table WHERE id IN (7) AND value > 1 ORDER BY id");
+    const auto entries = odbc::query_stats();
+    const auto it = std::ranges::find(entries, fingerprint, &odbc::QueryStatsEntry::fingerprint);
+    ASSERT_TRUE(it != entries.end(), "The query shape was not recorded.");
+    ASSERT_TRUE(it->calls == 2 && it->rows == 4 && it->bytes == 4 * sizeof(long long) && it->errors == 0,
+                std::format("Unexpected stats: calls {}, rows {}, bytes {}, errors {}", it->calls, it->rows, it->bytes, it->errors));
+    ASSERT_TRUE(odbc::dump_query_stats().find(it->query) != std::string::npos, "The dump does not list the query.");
+    return true;
+}
+
+[[nodiscard]] bool test_slow_query_log() {
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    std::mutex lines_mutex;
+    std::vector<std::string> lines;
+    odbc::AsyncLogger logger([&](std::string_view line) {
+        std::scoped_lock lock(lines_mutex);
+        lines.emplace_back(line);
+    });
+    {
+        odbc::SlowQueryLog slow_log(logger);
+        slow_log.watch("TEST_SLOW_LOG", {.threshold = std::chrono::milliseconds(0),
+                                         .plan_connection_string = std::string(CONNECTION_STRING),
+                                         .plan_sample_every = 1});
+        auto stmt = getThreadLocalStatement("TEST_SLOW_LOG", CONNECTION_STRING);
+        auto exec_res = stmt->execute_direct("SELECT id, name FROM test_table WHERE id = ?", {1LL});
+        ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+        while (stmt->fetch().value_or(false)) {}
+        (void)stmt->close_cursor();
+
+        slow_log.wait_for_plans();
+        const auto stats = slow_log.stats();
+        ASSERT_TRUE(stats.logged == 1, std::format("Expected one slow statement, logged {}.", stats.logged));
+        ASSERT_TRUE(stats.plans_captured == 1, std::format("Plan capture failed ({} failures).", stats.plans_failed));
+    }
+    logger.flush();
+
+    std::scoped_lock lock(lines_mutex);
+    ASSERT_TRUE(lines.size() == 2, std::format("Expected a slow-query line and a plan line, got {} lines.", lines.size()));
+    ASSERT_TRUE(lines[0].find("\"event\":\"slow_query\"") != std::string::npos &&
+                lines[0].find("\"parameters\":[\"1\"]") != std::string::npos &&
+                lines[0].find("\"rows\":1,") != std::string::npos, "Unexpected slow-query line: " + lines[0]);
+    ASSERT_TRUE(lines[1].find("\"event\":\"query_plan\"") != std::string::npos, "Unexpected plan line: " + lines[1]);
+    return true;
+}
+
+[[nodiscard]] bool test_request_profile_flags_repeats() {
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    auto stmt = getThreadLocalStatement("TEST_REQUEST_PROFILE", CONNECTION_STRING);
+    odbc::RequestProfile profile({.repeat_threshold = 3, .warn_on_repeats = false, .label = "test"});
+    for (int i = 0; i < 5; ++i) {
+        // One query per "row": the N+1 shape the profile should flag.
+        auto exec_res = stmt->execute_direct("SELECT name FROM test_table WHERE id = ?", {1LL});
+        ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+        while (stmt->fetch().value_or(false)) {
+            (void)stmt->get_data<std::string>(1);
+        }
+        (void)stmt->close_cursor();
+    }
+
+    const auto summary = profile.summary();
+    ASSERT_TRUE(summary.statements == 5 && summary.rows == 5 && summary.bytes == 5 * std::string_view("First").size(),
+                std::format("Unexpected totals: {} statements, {} rows, {} bytes", summary.statements, summary.rows, summary.bytes));
+    ASSERT_TRUE(summary.round_trips >= 15, std::format("Expected an execute and two fetches per query, got {} round trips.", summary.round_trips));
+    ASSERT_TRUE(summary.repeated.size() == 1 && summary.repeated.front().executions == 5, "The repeated query was not flagged.");
+    ASSERT_TRUE(summary.to_string().starts_with("DB: 5 queries, "), summary.to_string());
+    return true;
+}
+
+[[nodiscard]] bool test_execution_resource_usage() {
+    if constexpr (!odbc::DefaultInstrumentation::enabled) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    auto stmt = getThreadLocalStatement("TEST_RESOURCE_USAGE", CONNECTION_STRING);
+    auto exec_res = stmt->execute_direct("SELECT id, name, value FROM test_table WHERE id IN (1, 2) ORDER BY id");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    while (stmt->fetch().value_or(false)) {
+        (void)stmt->get_data<long long>(1);
+        (void)stmt->get_data<std::string>(2);
+        (void)stmt->get_data<double>(3);
+    }
+
+    const odbc::ExecutionUsage& usage = stmt->last_execution();
+    ASSERT_TRUE(usage.rows == 2, std::format("Expected 2 rows, got {}.", usage.rows));
+    ASSERT_TRUE(usage.column_bytes.size() == 3, std::format("Expected bytes for 3 columns, got {}.", usage.column_bytes.size()));
+    ASSERT_TRUE(usage.column_bytes[1] == std::string_view("First").size(), "The NULL name should add no bytes.");
+    ASSERT_TRUE(usage.column_bytes[0] > 0 && usage.column_bytes[2] > 0, "Fixed-size columns were not counted.");
+    ASSERT_TRUE(usage.allocations > 0, "The statement's buffers should come from the counting resource.");
+    ASSERT_TRUE(usage.cpu_time.count() >= 0 && usage.wall_time.count() > 0, "Timing was not recorded.");
+    return true;
+}
+
+[[nodiscard]] bool test_pool_telemetry_snapshot() {
+    ShardingOptions options;
+    options.mode = ShardingMode::single;
+    ShardedConnectionPool pool("TEST_POOL_TELEMETRY", std::string(CONNECTION_STRING), options);
+    auto find = [](const odbc::PoolTelemetrySnapshot& snapshot, std::string_view kind, std::string_view alias) {
+        auto it = std::ranges::find_if(snapshot.pools, [&](const odbc::PoolStats& p) { return p.pool == kind && p.alias == alias; });
+        return it != snapshot.pools.end() ? std::optional<odbc::PoolStats>(*it) : std::nullopt;
+    };
+
+    {
+        auto first = pool.acquire();
+        auto second = pool.acquire();
+        auto sharded = find(odbc::pool_telemetry(), "sharded", "TEST_POOL_TELEMETRY");
+        ASSERT_TRUE(sharded.has_value(), "The sharded pool is missing from the snapshot.");
+        ASSERT_TRUE(sharded->open == 2 && sharded->active == 2 && sharded->idle() == 0,
+                    std::format("Expected 2 open and active connections, got {} open, {} active.", sharded->open, sharded->active));
+        ASSERT_TRUE(sharded->connects == 2 && sharded->connect_time.count == 2, "Connect latency was not recorded.");
+    }
+    auto sharded = find(odbc::pool_telemetry(), "sharded", "TEST_POOL_TELEMETRY");
+    ASSERT_TRUE(sharded->active == 0 && sharded->idle() == 2, "Returned connections should count as idle.");
+    ASSERT_TRUE(sharded->checkouts == 2 && sharded->checkout_wait.count == 2 && sharded->hold_time.count == 2,
+                "Checkout wait and hold time were not recorded.");
+
+    {
+        auto outer = getThreadLocalStatement("TEST_POOL_TELEMETRY_TL", CONNECTION_STRING);
+        const auto snapshot = odbc::pool_telemetry();
+        const std::string self = odbc::detail::current_thread_name();
+        auto owned = std::ranges::find_if(snapshot.threads, [&](const odbc::ConnectionOwnership& o) {
+            return o.thread == self && o.alias == "TEST_POOL_TELEMETRY_TL";
+        });
+        ASSERT_TRUE(owned != snapshot.threads.end() && owned->open == 1 && owned->active == 1,
+                    "The thread-local connection is not attributed to its thread.");
+    }
+    auto thread_local_stats = find(odbc::pool_telemetry(), "thread_local", "TEST_POOL_TELEMETRY_TL");
+    ASSERT_TRUE(thread_local_stats.has_value() && thread_local_stats->active == 0 && thread_local_stats->hold_time.count == 1,
+                "The statement's hold time was not recorded.");
+    ASSERT_TRUE(odbc::pool_telemetry().to_string().find("TEST_POOL_TELEMETRY") != std::string::npos, "The table lists no pool.");
+    return true;
+}
+
 int main() {
     using TestFunc = std::function<bool()>;
     std::vector<std::pair<std::string, TestFunc>> tests_to_run = {
         {"test_fetch_valid_data", test_fetch_valid_data},
-        {"test_fetch_null_string", test_fetch_null_string}
+        {"test_fetch_null_string", test_fetch_null_string},
+        {"test_sharded_pool_checkout", test_sharded_pool_checkout},
+        {"test_nested_statement_in_fetch_loop", test_nested_statement_in_fetch_loop},
+        {"test_executor_query", test_executor_query},
+        {"test_when_all_queries", test_when_all_queries},
+        {"test_single_flight_parameterized_query", test_single_flight_parameterized_query},
+        {"test_point_lookup_batching", test_point_lookup_batching},
+        {"test_data_loader_batches_keys", test_data_loader_batches_keys},
+        {"test_result_cache_hit_and_invalidate", test_result_cache_hit_and_invalidate},
+        {"test_result_cache_l1_find", test_result_cache_l1_find},
+        {"test_reference_table_lookup", test_reference_table_lookup},
+        {"test_snapshot_file_round_trip", test_snapshot_file_round_trip},
+        {"test_change_poller_advances_watermark", test_change_poller_advances_watermark},
+        {"test_keyset_pager_pages", test_keyset_pager_pages},
+        {"test_write_behind_flushes_batches", test_write_behind_flushes_batches},
+        {"test_copy_table_pipelined", test_copy_table_pipelined},
+        {"test_trace_export", test_trace_export},
+        {"test_null_instrumentation_statement", test_null_instrumentation_statement},
+        {"test_metrics_prometheus_output", test_metrics_prometheus_output},
+        {"test_query_fingerprint_stats", test_query_fingerprint_stats},
+        {"test_slow_query_log", test_slow_query_log},
+        {"test_request_profile_flags_repeats", test_request_profile_flags_repeats},
+        {"test_execution_resource_usage", test_execution_resource_usage},
+        {"test_pool_telemetry_snapshot", test_pool_telemetry_snapshot}
     };
 
     try {
@@ -0,0 +1,460 @@
+#ifndef MODERN_ODBC_METRICS_H
+#define MODERN_ODBC_METRICS_H
+
+/**
+ * @file metrics.h
+ * @brief Counters, gauges and latency histograms with Prometheus text output.
+ *
+ * Every metric value lives in per-thread shards: each thread owns its own copy
+ * of every cell it has touched, so an increment is a plain load and store on a
+ * cache line no other thread writes. render_prometheus() sums the shards on
+ * demand; the cells of exited threads are folded into a shared total.
+ *
+ * Histograms are HDR-style log-linear: each power of two of nanoseconds is split
+ * into eight linear sub-buckets (at most 12.5% relative error) from 1 ns up to
+ * about 68 s. The Prometheus output reports them with fixed "le" buckets from
+ * 100 us to 10 s; snapshot() gives exact percentiles in process.
+ *
+ * With the default instrumentation policy (see instrumentation.h) statements
+ * record prepare, execute, first-row and fetch latency per alias and statement
+ * name, and the pools record connect latency and counts per pool and alias
+ * (the odbc_pool_* families of pool_telemetry.h).
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @brief Label names and values of one metric series, e.g. {{"alias", "DB_PRIMARY"}}.
+ */
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class MetricsRegistry;
+
+/**
+ * @class Counter
+ * @brief A monotonically increasing count. Cheap to copy; obtained from MetricsRegistry.
+ */
+class Counter {
+public:
+    void inc(std::uint64_t n = 1) const noexcept;
+    [[nodiscard]] std::uint64_t value() const;
+
+private:
+    friend class MetricsRegistry;
+    explicit Counter(std::uint32_t cell) : m_cell(cell) {}
+    std::uint32_t m_cell;
+};
+
+/**
+ * @class Gauge
+ * @brief A value that goes up and down (e.g. open connections), kept as per-thread deltas.
+ */
+class Gauge {
+public:
+    void add(std::int64_t n = 1) const noexcept;
+    void sub(std::int64_t n = 1) const noexcept { add(-n); }
+    [[nodiscard]] std::int64_t value() const;
+
+private:
+    friend class MetricsRegistry;
+    explicit Gauge(std::uint32_t cell) : m_cell(cell) {}
+    std::uint32_t m_cell;
+};
+
+/**
+ * @struct HistogramSnapshot
+ * @brief Aggregated contents of a Histogram.
+ */
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds sum{0};
+    std::vector<std::uint64_t> buckets;   ///< Counts per log-linear bucket.
+
+    /**
+     * @brief The value below which the fraction q (0..1) of the recorded values fall, at bucket resolution.
+     */
+    [[nodiscard]] std::chrono::nanoseconds percentile(double q) const;
+};
+
+/**
+ * @class Histogram
+ * @brief A log-linear latency histogram.
+ */
+class Histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 3;
+    static constexpr std::uint64_t sub_buckets = std::uint64_t{1} << sub_bucket_bits;
+    static constexpr unsigned max_exponent = 36;   // values from 2^36 ns (~68 s) up share the last bucket
+    static constexpr std::size_t bucket_count = sub_buckets * (max_exponent - sub_bucket_bits + 2);
+
+    void record(std::chrono::nanoseconds latency) const noexcept;
+    [[nodiscard]] HistogramSnapshot snapshot() const;
+
+    [[nodiscard]] static constexpr std::size_t bucket_index(std::uint64_t ns) noexcept {
+        if (ns < sub_buckets) return static_cast<std::size_t>(ns);
+        const unsigned exponent = std::min<unsigned>(static_cast<unsigned>(std::bit_width(ns)) - 1, max_exponent);
+        if (exponent == max_exponent && ns >= (std::uint64_t{1} << (max_exponent + 1))) return bucket_count - 1;
+        const std::uint64_t mantissa = (ns >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+        return static_cast<std::size_t>((exponent - sub_bucket_bits + 1) * sub_buckets + mantissa);
+    }
+
+    // The largest value that falls into a bucket.
+    [[nodiscard]] static constexpr std::uint64_t bucket_upper_bound(std::size_t index) noexcept {
+        if (index < sub_buckets) return index;
+        const unsigned exponent = static_cast<unsigned>(index / sub_buckets) + sub_bucket_bits - 1;
+        const std::uint64_t mantissa = index % sub_buckets;
+        const unsigned shift = exponent - sub_bucket_bits;
+        return ((sub_buckets + mantissa + 1) << shift) - 1;
+    }
+
+private:
+    friend class MetricsRegistry;
+    explicit Histogram(std::uint32_t cell) : m_cell(cell) {}
+    std::uint32_t m_cell;   // cells: count, sum in ns, then bucket_count buckets
+};
+
+namespace detail {
+
+    /**
+     * @struct StatementMetrics
+     * @brief The latency histograms of one (alias, statement) series.
+     */
+    struct StatementMetrics {
+        std::string alias;
+        std::string statement;
+        Histogram prepare;
+        Histogram execute;
+        Histogram first_row;
+        Histogram fetch;
+    };
+
+    /**
+     * @class MetricsShard
+     * @brief One thread's cells, allocated in chunks as metrics are touched.
+     */
+    class MetricsShard {
+    public:
+        static constexpr std::size_t chunk_cells = 4096;
+        static constexpr std::size_t max_chunks = 1024;
+
+        MetricsShard() = default;
+        MetricsShard(const MetricsShard&) = delete;
+        MetricsShard& operator=(const MetricsShard&) = delete;
+        ~MetricsShard() {
+            for (auto& chunk : m_chunks) delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        // Owner thread only: a plain load and store, no read-modify-write.
+        void add(std::uint32_t cell, std::uint64_t n) noexcept {
+            auto& value = slot(cell);
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint64_t read(std::uint32_t cell) const noexcept {
+            const auto* chunk = m_chunks[cell / chunk_cells].load(std::memory_order_acquire);
+            return chunk != nullptr ? chunk[cell % chunk_cells].load(std::memory_order_relaxed) : 0;
+        }
+
+    private:
+        std::array<std::atomic<std::atomic<std::uint64_t>*>, max_chunks> m_chunks{};
+
+        std::atomic<std::uint64_t>& slot(std::uint32_t cell) noexcept {
+            auto& entry = m_chunks[cell / chunk_cells];
+            auto* chunk = entry.load(std::memory_order_relaxed);
+            if (chunk == nullptr) [[unlikely]] {
+                chunk = new std::atomic<std::uint64_t>[chunk_cells]();
+                entry.store(chunk, std::memory_order_release);
+            }
+            return chunk[cell % chunk_cells];
+        }
+    };
+
+    alignas(64) inline std::atomic<bool> metrics_on{true};
+
+    inline std::string escape_label_value(std::string_view value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\') escaped += "\\\\";
+            else if (c == '"') escaped += "\\\"";
+            else if (c == '\n') escaped += "\\n";
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+} // namespace detail
+
+/**
+ * @brief Turns the automatic statement and connection metrics on or off (on by default).
+ */
+inline void set_metrics_enabled(bool enabled) noexcept { detail::metrics_on.store(enabled, std::memory_order_relaxed); }
+[[nodiscard]] inline bool metrics_enabled() noexcept { return detail::metrics_on.load(std::memory_order_relaxed); }
+
+/**
+ * @class MetricsRegistry
+ * @brief The process-wide set of metric families and their per-thread shards.
+ */
+class MetricsRegistry {
+public:
+    [[nodiscard]] static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Returns the series of a metric, registering it on first use.
+     * @throws std::invalid_argument if the name is already registered with another type.
+     */
+    [[nodiscard]] Counter counter(std::string_view name, std::string_view help, const MetricLabels& labels = {}) {
+        return Counter(series(name, help, Type::counter, labels, 1));
+    }
+    [[nodiscard]] Gauge gauge(std::string_view name, std::string_view help, const MetricLabels& labels = {}) {
+        return Gauge(series(name, help, Type::gauge, labels, 1));
+    }
+    [[nodiscard]] Histogram histogram(std::string_view name, std::string_view help, const MetricLabels& labels = {}) {
+        return Histogram(series(name, help, Type::histogram, labels, 2 + Histogram::bucket_count));
+    }
+
+    /**
+     * @brief The statement latency histograms for an alias and statement name; the pointer stays valid.
+     */
+    [[nodiscard]] const detail::StatementMetrics* statement_metrics(std::string_view alias, std::string_view statement);
+
+    /**
+     * @brief Renders every metric in the Prometheus text exposition format (version 0.0.4).
+     */
+    [[nodiscard]] std::string render_prometheus();
+
+private:
+    friend class Counter;
+    friend class Gauge;
+    friend class Histogram;
+
+    enum class Type { counter, gauge, histogram };
+
+    struct Series {
+        std::string labels;   // rendered, e.g. alias="A",statement="S"
+        std::uint32_t cell;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Family> m_families;
+    std::map<std::string, std::uint32_t, std::less<>> m_cells;   // "name{labels}" -> first cell
+    std::uint32_t m_next_cell = 0;
+    std::vector<std::shared_ptr<detail::MetricsShard>> m_shards;
+    std::vector<std::uint64_t> m_retired;   // totals of exited threads' shards
+    std::map<std::string, std::unique_ptr<detail::StatementMetrics>, std::less<>> m_statements;
+
+    MetricsRegistry() = default;
+
+    std::uint32_t series(std::string_view name, std::string_view help, Type type, const MetricLabels& labels, std::uint32_t cells);
+    detail::MetricsShard& local_shard();
+    void retire(const std::shared_ptr<detail::MetricsShard>& shard);
+    std::uint64_t read_locked(std::uint32_t cell) const;
+    std::uint64_t read(std::uint32_t cell) {
+        std::scoped_lock lock(m_mutex);
+        return read_locked(cell);
+    }
+    HistogramSnapshot snapshot_locked(std::uint32_t cell) const;
+};
+
+/**
+ * @brief Shorthand for MetricsRegistry::instance().render_prometheus().
+ */
+[[nodiscard]] inline std::string render_prometheus() { return MetricsRegistry::instance().render_prometheus(); }
+
+
+// --- Implementation ---
+
+inline void Counter::inc(std::uint64_t n) const noexcept { MetricsRegistry::instance().local_shard().add(m_cell, n); }
+
+inline std::uint64_t Counter::value() const { return MetricsRegistry::instance().read(m_cell); }
+
+inline void Gauge::add(std::int64_t n) const noexcept {
+    // Two's complement: the shards' unsigned sum wraps to the signed total.
+    MetricsRegistry::instance().local_shard().add(m_cell, static_cast<std::uint64_t>(n));
+}
+
+inline std::int64_t Gauge::value() const { return static_cast<std::int64_t>(MetricsRegistry::instance().read(m_cell)); }
+
+inline void Histogram::record(std::chrono::nanoseconds latency) const noexcept {
+    const auto ns = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, latency.count()));
+    auto& shard = MetricsRegistry::instance().local_shard();
+    shard.add(m_cell, 1);
+    shard.add(m_cell + 1, ns);
+    shard.add(m_cell + 2 + static_cast<std::uint32_t>(bucket_index(ns)), 1);
+}
+
+inline HistogramSnapshot Histogram::snapshot() const {
+    auto& registry = MetricsRegistry::instance();
+    std::scoped_lock lock(registry.m_mutex);
+    return registry.snapshot_locked(m_cell);
+}
+
+inline std::chrono::nanoseconds HistogramSnapshot::percentile(double q) const {
+    if (count == 0) return std::chrono::nanoseconds(0);
+    const auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::chrono::nanoseconds(Histogram::bucket_upper_bound(i));
+    }
+    return std::chrono::nanoseconds(Histogram::bucket_upper_bound(buckets.size() - 1));
+}
+
+inline detail::MetricsShard& MetricsRegistry::local_shard() {
+    struct Owner {
+        std::shared_ptr<detail::MetricsShard> shard;
+        ~Owner() { MetricsRegistry::instance().retire(shard); }
+    };
+    thread_local Owner owner{[this] {
+        auto shard = std::make_shared<detail::MetricsShard>();
+        std::scoped_lock lock(m_mutex);
+        m_shards.push_back(shard);
+        return shard;
+    }()};
+    return *owner.shard;
+}
+
+inline void MetricsRegistry::retire(const std::shared_ptr<detail::MetricsShard>& shard) {
+    std::scoped_lock lock(m_mutex);
+    m_retired.resize(m_next_cell, 0);
+    for (std::uint32_t cell = 0; cell < m_next_cell; ++cell) {
+        m_retired[cell] += shard->read(cell);
+    }
+    std::erase(m_shards, shard);
+}
+
+inline std::uint64_t MetricsRegistry::read_locked(std::uint32_t cell) const {
+    std::uint64_t total = cell < m_retired.size() ? m_retired[cell] : 0;
+    for (const auto& shard : m_shards) {
+        total += shard->read(cell);
+    }
+    return total;
+}
+
+inline HistogramSnapshot MetricsRegistry::snapshot_locked(std::uint32_t cell) const {
+    HistogramSnapshot snapshot;
+    snapshot.buckets.resize(Histogram::bucket_count);
+    for (std::size_t i = 0; i < Histogram::bucket_count; ++i) {
+        snapshot.buckets[i] = read_locked(cell + 2 + static_cast<std::uint32_t>(i));
+        snapshot.count += snapshot.buckets[i];   // consistent with the buckets even while writers run
+    }
+    snapshot.sum = std::chrono::nanoseconds(read_locked(cell + 1));
+    return snapshot;
+}
+
+inline std::uint32_t MetricsRegistry::series(std::string_view name, std::string_view help, Type type,
+                                             const MetricLabels& labels, std::uint32_t cells) {
+    std::string rendered;
+    for (const auto& [label, value] : labels) {
+        rendered += std::format("{}{}=\"{}\"", rendered.empty() ? "" : ",", label, detail::escape_label_value(value));
+    }
+    const std::string key = std::format("{}{{{}}}", name, rendered);
+
+    std::scoped_lock lock(m_mutex);
+    auto family = std::ranges::find(m_families, name, &Family::name);
+    if (family != m_families.end() && family->type != type) {
+        throw std::invalid_argument(std::format("Metric '{}' is already registered with another type.", name));
+    }
+    if (auto it = m_cells.find(key); it != m_cells.end()) {
+        return it->second;
+    }
+    if (static_cast<std::size_t>(m_next_cell) + cells > detail::MetricsShard::chunk_cells * detail::MetricsShard::max_chunks) {
+        throw std::length_error("Too many metric series.");
+    }
+    if (family == m_families.end()) {
+        family = m_families.insert(m_families.end(), Family{std::string(name), std::string(help), type, {}});
+    }
+    const std::uint32_t cell = m_next_cell;
+    m_next_cell += cells;
+    family->series.push_back(Series{std::move(rendered), cell});
+    m_cells.emplace(key, cell);
+    return cell;
+}
+
+inline const detail::StatementMetrics* MetricsRegistry::statement_metrics(std::string_view alias, std::string_view statement) {
+    const std::string key = std::format("{}\n{}", alias, statement);
+    {
+        std::scoped_lock lock(m_mutex);
+        if (auto it = m_statements.find(key); it != m_statements.end()) {
+            return it->second.get();
+        }
+    }
+    const MetricLabels labels{{"alias", std::string(alias)}, {"statement", std::string(statement)}};
+    auto metrics = std::make_unique<detail::StatementMetrics>(detail::StatementMetrics{
+        std::string(alias), std::string(statement),
+        histogram("odbc_prepare_duration_seconds", "Time spent in SQLPrepare.", labels),
+        histogram("odbc_execute_duration_seconds", "Time spent in SQLExecute and SQLExecDirect.", labels),
+        histogram("odbc_first_row_duration_seconds", "Time of the first SQLFetch after an execute.", labels),
+        histogram("odbc_fetch_duration_seconds", "Time spent in later SQLFetch calls.", labels)});
+
+    std::scoped_lock lock(m_mutex);
+    // Another thread may have registered the same series meanwhile; the histograms are shared either way.
+    auto [it, inserted] = m_statements.try_emplace(key, std::move(metrics));
+    return it->second.get();
+}
+
+inline std::string MetricsRegistry::render_prometheus() {
+    static constexpr std::array<double, 16> le_seconds{
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+    std::scoped_lock lock(m_mutex);
+    std::string out;
+    for (const auto& family : m_families) {
+        const char* type = family.type == Type::counter ? "counter" : family.type == Type::gauge ? "gauge" : "histogram";
+        out += std::format("# HELP {} {}\n# TYPE {} {}\n", family.name, family.help, family.name, type);
+        for (const auto& series : family.series) {
+            const std::string braces = series.labels.empty() ? std::string() : std::format("{{{}}}", series.labels);
+            if (family.type == Type::counter) {
+                out += std::format("{}{} {}\n", family.name, braces, read_locked(series.cell));
+            } else if (family.type == Type::gauge) {
+                out += std::format("{}{} {}\n", family.name, braces, static_cast<std::int64_t>(read_locked(series.cell)));
+            } else {
+                const HistogramSnapshot snapshot = snapshot_locked(series.cell);
+                const std::string prefix = series.labels.empty() ? std::string() : series.labels + ",";
+                std::size_t bucket = 0;
+                std::uint64_t cumulative = 0;
+                for (double le : le_seconds) {
+                    const auto limit_ns = static_cast<std::uint64_t>(le * 1e9);
+                    while (bucket < snapshot.buckets.size() && Histogram::bucket_upper_bound(bucket) <= limit_ns) {
+                        cumulative += snapshot.buckets[bucket++];
+                    }
+                    out += std::format("{}_bucket{{{}le=\"{}\"}} {}\n", family.name, prefix, le, cumulative);
+                }
+                out += std::format("{}_bucket{{{}le=\"+Inf\"}} {}\n", family.name, prefix, snapshot.count);
+                out += std::format("{}_sum{} {}\n", family.name, braces, std::chrono::duration<double>(snapshot.sum).count());
+                out += std::format("{}_count{} {}\n", family.name, braces, snapshot.count);
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_METRICS_H
@@ -0,0 +1,1112 @@
+// Mock ODBC driver serving synthetic result sets.
+//
+// A loadable ODBC 3.x driver (a shared library for unixODBC) that talks to no
+// database: every query returns generated rows, every other statement succeeds
+// with a row count. It lets the wrapper, the pools and the benchmarks run
+// deterministically without a server, with latency and faults on demand.
+//
+// Connect with the library path as the driver, or register it with odbcinst
+// (see odbcinst.ini in this directory):
+//
+//   Driver=/path/to/libodbcmock.so;Rows=1000;Columns=bigint,double,varchar;NullRate=0.1
+//
+// Options, in the connection string (defaults for the connection, unknown keys
+// ignored) or in a /*mock ...*/ comment of a statement (overrides for that
+// statement, unknown keys rejected), e.g.
+//
+//   SELECT * FROM t /*mock rows=5 columns=int,varchar stringlength=lognormal:32-8000*/
+//
+//   Rows=N                 rows per query result (default 100)
+//   Columns=t1,t2,...      int, bigint, double or varchar (default bigint,double,varchar)
+//   NullRate=p             probability that a cell is NULL (default 0); an integer
+//                          first column holds the row number and is never NULL
+//   StringLength=D         varchar lengths: N (fixed), MIN-MAX (uniform) or
+//                          lognormal:MEDIAN-MAX (heavy tail) (default 8-32)
+//   Seed=N                 the data is a pure function of seed, row and column (default 1)
+//   ConnectLatencyUs=N     added to every connect
+//   ExecuteLatencyUs=N     added to every execute
+//   FetchLatencyUs=N       added to every SQLFetch call (one per block with row arrays)
+//   FailConnect=STATE[:p]  fail connects with SQLSTATE STATE, with probability p (default 1)
+//   FailExecute=STATE[:p]  fail executes likewise
+//   FailFetch=STATE[:p]    fail fetches likewise, per row
+//   FailAfterRows=N        fail the fetch after N rows of each result (with the FailFetch
+//                          state, 08S01 if unset)
+//   FailParamSet=N         fail the Nth parameter set (zero-based) a statement executes after
+//                          its prepare with 23000; the other sets of its array still apply
+//                          and the execute returns SQL_SUCCESS_WITH_INFO with SQL_PARAM_ERROR
+//                          in the parameter status array
+//   Activities=N           SQL_MAX_CONCURRENT_ACTIVITIES; with 1, a statement cannot run
+//                          while another one on the connection has pending rows (default 0)
+//   Dbms=NAME              SQL_DBMS_NAME (default MockDB)
+//
+// A statement whose first keyword is SELECT, WITH or VALUES returns a result
+// set; anything else affects one row per parameter set. Fault decisions come
+// from the same hash as the data, so a run is reproducible. A fault in SQLSTATE
+// class 08 also marks the connection dead: later calls fail with 08S01 and
+// SQL_ATTR_CONNECTION_DEAD reports SQL_CD_TRUE. Latency waits honour SQLCancel
+// (HY008) and SQL_ATTR_QUERY_TIMEOUT (HYT00).
+
+#include <sql.h>
+#include <sqlext.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define MOCK_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace {
+
+// ------------------------------------------------------------------ options
+
+enum class ColumnType { integer, bigint, real, varchar };
+
+struct LengthDistribution {
+    enum class Kind { fixed, uniform, lognormal } kind = Kind::uniform;
+    std::size_t min = 8;
+    std::size_t max = 32;   // for lognormal: min is the median
+};
+
+struct Fault {
+    std::string state;   // empty: off
+    double probability = 1.0;
+};
+
+struct Options {
+    std::size_t rows = 100;
+    std::vector<ColumnType> columns{ColumnType::bigint, ColumnType::real, ColumnType::varchar};
+    double null_rate = 0.0;
+    LengthDistribution strings;
+    std::uint64_t seed = 1;
+    std::chrono::microseconds connect_latency{0};
+    std::chrono::microseconds execute_latency{0};
+    std::chrono::microseconds fetch_latency{0};
+    Fault fail_connect;
+    Fault fail_execute;
+    Fault fail_fetch;
+    std::optional<std::size_t> fail_after_rows;
+    std::optional<std::size_t> fail_param_set;
+    SQLUSMALLINT activities = 0;
+    std::string dbms = "MockDB";
+};
+
+std::string lowered(std::string_view text) {
+    std::string out(text);
+    std::ranges::transform(out, out.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+template <typename T>
+bool parse_number(std::string_view text, T& value) {
+    text = trimmed(text);
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc{} && end == text.data() + text.size();
+}
+
+bool parse_range(std::string_view text, std::size_t& min, std::size_t& max) {
+    const auto dash = text.find('-');
+    if (dash == std::string_view::npos) {
+        return parse_number(text, min) && ((max = min), true);
+    }
+    return parse_number(text.substr(0, dash), min) && parse_number(text.substr(dash + 1), max) && min <= max;
+}
+
+bool parse_fault(std::string_view text, Fault& fault) {
+    const auto colon = text.find(':');
+    fault.state = std::string(trimmed(text.substr(0, colon)));
+    fault.probability = 1.0;
+    if (colon != std::string_view::npos && !parse_number(text.substr(colon + 1), fault.probability)) return false;
+    return fault.state.size() == 5 && fault.probability >= 0.0 && fault.probability <= 1.0;
+}
+
+bool parse_microseconds(std::string_view text, std::chrono::microseconds& value) {
+    long long count = 0;
+    if (!parse_number(text, count) || count < 0) return false;
+    value = std::chrono::microseconds(count);
+    return true;
+}
+
+enum class Applied { ok, unknown_key, bad_value };
+
+Applied apply_option(Options& options, std::string_view raw_key, std::string_view value) {
+    const std::string key = lowered(trimmed(raw_key));
+    value = trimmed(value);
+    bool ok = true;
+    if (key == "rows") {
+        ok = parse_number(value, options.rows);
+    } else if (key == "columns") {
+        options.columns.clear();
+        while (ok && !value.empty()) {
+            const auto comma = value.find(',');
+            const std::string type = lowered(trimmed(value.substr(0, comma)));
+            value = comma == std::string_view::npos ? std::string_view{} : value.substr(comma + 1);
+            if (type == "int" || type == "integer") options.columns.push_back(ColumnType::integer);
+            else if (type == "bigint") options.columns.push_back(ColumnType::bigint);
+            else if (type == "double" || type == "float" || type == "real") options.columns.push_back(ColumnType::real);
+            else if (type == "varchar" || type == "string" || type == "text") options.columns.push_back(ColumnType::varchar);
+            else ok = false;
+        }
+        ok = ok && !options.columns.empty();
+    } else if (key == "nullrate") {
+        ok = parse_number(value, options.null_rate) && options.null_rate >= 0.0 && options.null_rate <= 1.0;
+    } else if (key == "stringlength") {
+        LengthDistribution strings;
+        std::string_view range = value;
+        if (lowered(value).starts_with("lognormal:")) {
+            strings.kind = LengthDistribution::Kind::lognormal;
+            range.remove_prefix(std::string_view("lognormal:").size());
+        } else {
+            strings.kind = range.find('-') == std::string_view::npos ? LengthDistribution::Kind::fixed : LengthDistribution::Kind::uniform;
+        }
+        ok = parse_range(range, strings.min, strings.max);
+        if (ok) options.strings = strings;
+    } else if (key == "seed") {
+        ok = parse_number(value, options.seed);
+    } else if (key == "connectlatencyus") {
+        ok = parse_microseconds(value, options.connect_latency);
+    } else if (key == "executelatencyus") {
+        ok = parse_microseconds(value, options.execute_latency);
+    } else if (key == "fetchlatencyus") {
+        ok = parse_microseconds(value, options.fetch_latency);
+    } else if (key == "failconnect") {
+        ok = parse_fault(value, options.fail_connect);
+    } else if (key == "failexecute") {
+        ok = parse_fault(value, options.fail_execute);
+    } else if (key == "failfetch") {
+        ok = parse_fault(value, options.fail_fetch);
+    } else if (key == "failafterrows") {
+        std::size_t rows = 0;
+        ok = parse_number(value, rows);
+        if (ok) options.fail_after_rows = rows;
+    } else if (key == "failparamset") {
+        std::size_t set = 0;
+        ok = parse_number(value, set);
+        if (ok) options.fail_param_set = set;
+    } else if (key == "activities") {
+        ok = parse_number(value, options.activities);
+    } else if (key == "dbms") {
+        options.dbms = std::string(value);
+    } else {
+        return Applied::unknown_key;
+    }
+    return ok ? Applied::ok : Applied::bad_value;
+}
+
+// ------------------------------------------------------------------ data
+
+// splitmix64 finalizer: a well-mixed 64-bit hash of a few inputs.
+std::uint64_t mix(std::uint64_t a, std::uint64_t b = 0, std::uint64_t c = 0) {
+    std::uint64_t x = a ^ (b * 0x9E3779B97F4A7C15ULL) ^ (c * 0xC2B2AE3D27D4EB4FULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+double unit(std::uint64_t hash) { return static_cast<double>(hash >> 11) * 0x1.0p-53; }
+
+struct Cell {
+    bool null = false;
+    long long integer = 0;
+    double real = 0.0;
+    std::string text;   // also the character form of numbers
+};
+
+std::size_t string_length(const LengthDistribution& strings, std::uint64_t hash) {
+    switch (strings.kind) {
+        case LengthDistribution::Kind::fixed:
+            return strings.min;
+        case LengthDistribution::Kind::uniform:
+            return strings.min + static_cast<std::size_t>(hash % (strings.max - strings.min + 1));
+        case LengthDistribution::Kind::lognormal: {
+            // Box-Muller from two halves of the hash; sigma 1 gives a tail of a few times the median.
+            const double u1 = std::max(unit(mix(hash, 1)), 1e-12);
+            const double u2 = unit(mix(hash, 2));
+            const double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * 3.14159265358979323846 * u2);
+            const double length = static_cast<double>(strings.min) * std::exp(z);
+            return std::clamp<std::size_t>(static_cast<std::size_t>(std::llround(length)), 1, strings.max);
+        }
+    }
+    return strings.min;
+}
+
+Cell generate(const Options& options, std::size_t row, std::size_t column) {
+    Cell cell;
+    const ColumnType type = options.columns[column];
+    const std::uint64_t hash = mix(options.seed, row, column);
+    const bool row_number = column == 0 && (type == ColumnType::integer || type == ColumnType::bigint);
+    if (!row_number && unit(mix(hash, 3)) < options.null_rate) {
+        cell.null = true;
+        return cell;
+    }
+    char digits[32];
+    switch (type) {
+        case ColumnType::integer:
+        case ColumnType::bigint: {
+            cell.integer = row_number ? static_cast<long long>(row + 1)
+                         : type == ColumnType::integer ? static_cast<long long>(hash % 1000000)
+                         : static_cast<long long>(hash >> 16);
+            cell.real = static_cast<double>(cell.integer);
+            const auto end = std::to_chars(digits, digits + sizeof(digits), cell.integer).ptr;
+            cell.text.assign(digits, end);
+            break;
+        }
+        case ColumnType::real: {
+            cell.real = std::round(unit(hash) * 100000.0) / 100.0;
+            cell.integer = static_cast<long long>(cell.real);
+            const auto end = std::to_chars(digits, digits + sizeof(digits), cell.real).ptr;
+            cell.text.assign(digits, end);
+            break;
+        }
+        case ColumnType::varchar: {
+            cell.text.resize(string_length(options.strings, hash));
+            for (std::size_t i = 0; i < cell.text.size(); ++i) {
+                cell.text[i] = static_cast<char>('a' + (hash + i) % 26);
+            }
+            break;
+        }
+    }
+    return cell;
+}
+
+// ------------------------------------------------------------------ handles
+
+constexpr std::uint32_t handle_magic = 0x4D4F434B;   // "MOCK"
+
+struct Diagnostic {
+    std::string state;
+    SQLINTEGER native = 0;
+    std::string message;
+};
+
+struct Handle {
+    explicit Handle(SQLSMALLINT handle_type) : type(handle_type) {}
+    std::uint32_t magic = handle_magic;
+    SQLSMALLINT type;
+    std::vector<Diagnostic> diagnostics;
+};
+
+struct Env : Handle {
+    Env() : Handle(SQL_HANDLE_ENV) {}
+    SQLINTEGER odbc_version = SQL_OV_ODBC3;
+};
+
+struct Dbc : Handle {
+    explicit Dbc(Env* owner) : Handle(SQL_HANDLE_DBC), env(owner) {}
+    Env* env;
+    Options options;
+    bool connected = false;
+    std::atomic<bool> dead{false};
+    bool autocommit = true;
+    SQLUINTEGER login_timeout = 0;
+    std::atomic<std::uint64_t> executes{0};
+    std::atomic<int> busy{0};   // statements holding the connection's activity
+};
+
+struct Desc : Handle {
+    Desc() : Handle(SQL_HANDLE_DESC) {}
+};
+
+struct BoundColumn {
+    SQLSMALLINT c_type = 0;
+    SQLPOINTER target = nullptr;
+    SQLLEN length = 0;
+    SQLLEN* indicator = nullptr;
+};
+
+struct Stmt : Handle {
+    explicit Stmt(Dbc* owner) : Handle(SQL_HANDLE_STMT), dbc(owner) {}
+    Dbc* dbc;
+
+    // Prepared or executed statement
+    Options options;
+    bool prepared = false;
+    bool query = false;
+    std::size_t parameter_markers = 0;
+    std::size_t params_executed = 0;   // parameter sets executed since the prepare, for FailParamSet
+
+    // Cursor
+    bool cursor_open = false;
+    bool holds_activity = false;
+    bool on_row = false;
+    std::size_t next_row = 0;      // rows returned so far
+    std::size_t current_row = 0;   // the row SQLGetData reads
+    std::uint64_t execution = 0;   // serial of the execute, for fault decisions
+    SQLLEN row_count = -1;
+    std::vector<std::size_t> getdata_offset;   // bytes of a character cell already returned, per column
+    std::vector<bool> getdata_done;
+
+    // Attributes
+    SQLULEN row_array_size = 1;
+    SQLULEN row_bind_type = SQL_BIND_BY_COLUMN;
+    SQLULEN* rows_fetched = nullptr;
+    SQLUSMALLINT* row_status = nullptr;
+    SQLULEN paramset_size = 1;
+    SQLULEN* params_processed = nullptr;
+    SQLUSMALLINT* param_status = nullptr;
+    SQLULEN query_timeout = 0;
+    std::vector<BoundColumn> bound;
+
+    std::atomic<bool> canceled{false};
+    Desc app_row, app_param, imp_row, imp_param;
+};
+
+template <typename T>
+T* as(SQLHANDLE handle, SQLSMALLINT type) {
+    auto* h = static_cast<Handle*>(handle);
+    if (h == nullptr || h->magic != handle_magic || h->type != type) return nullptr;
+    return static_cast<T*>(h);
+}
+
+SQLRETURN error(Handle& handle, std::string_view state, std::string_view message, SQLINTEGER native = 0) {
+    handle.diagnostics.push_back({std::string(state), native, "[ModernOdbc][Mock] " + std::string(message)});
+    return SQL_ERROR;
+}
+
+SQLRETURN warning(Handle& handle, std::string_view state, std::string_view message) {
+    handle.diagnostics.push_back({std::string(state), 0, "[ModernOdbc][Mock] " + std::string(message)});
+    return SQL_SUCCESS_WITH_INFO;
+}
+
+// Copies a string into an output buffer of `capacity` bytes, NUL-terminated; reports the full length.
+template <typename Length>
+bool copy_string(std::string_view text, SQLPOINTER buffer, SQLLEN capacity, Length* length) {
+    if (length != nullptr) *length = static_cast<Length>(text.size());
+    if (buffer == nullptr || capacity <= 0) return text.empty();
+    const std::size_t copied = std::min(text.size(), static_cast<std::size_t>(capacity - 1));
+    std::memcpy(buffer, text.data(), copied);
+    static_cast<char*>(buffer)[copied] = '\0';
+    return copied == text.size();
+}
+
+// Waits for an injected latency in short slices so that SQLCancel and the query timeout can end it.
+SQLRETURN wait(Stmt* stmt, std::chrono::microseconds latency) {
+    if (latency <= std::chrono::microseconds::zero()) return SQL_SUCCESS;
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + latency;
+    const auto timeout = stmt != nullptr && stmt->query_timeout > 0
+                             ? start + std::chrono::seconds(stmt->query_timeout)
+                             : std::chrono::steady_clock::time_point::max();
+    for (auto now = start; now < deadline; now = std::chrono::steady_clock::now()) {
+        if (stmt != nullptr && stmt->canceled.exchange(false)) return error(*stmt, "HY008", "Operation canceled");
+        if (now >= timeout) return error(*stmt, "HYT00", "Timeout expired");
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, std::chrono::milliseconds(1)));
+    }
+    return SQL_SUCCESS;
+}
+
+bool fault_fires(const Fault& fault, std::uint64_t seed, std::uint64_t a, std::uint64_t b) {
+    return !fault.state.empty() && unit(mix(seed ^ 0xFA17, a, b)) < fault.probability;
+}
+
+SQLRETURN inject(Handle& handle, Dbc& dbc, const std::string& state, std::string_view where) {
+    if (state.starts_with("08")) dbc.dead.store(true);
+    return error(handle, state, "Injected fault on " + std::string(where));
+}
+
+std::atomic<std::uint64_t> connect_attempts{0};
+
+// ------------------------------------------------------------------ statements
+
+void release_activity(Stmt& stmt) {
+    if (stmt.holds_activity) {
+        stmt.dbc->busy.fetch_sub(1);
+        stmt.holds_activity = false;
+    }
+}
+
+void close_cursor(Stmt& stmt) {
+    release_activity(stmt);
+    stmt.cursor_open = false;
+    stmt.on_row = false;
+}
+
+// Parses the statement's options and shape; on error the diagnostic is set.
+SQLRETURN prepare(Stmt& stmt, std::string_view text) {
+    close_cursor(stmt);
+    stmt.options = stmt.dbc->options;
+    stmt.prepared = false;
+    stmt.parameter_markers = static_cast<std::size_t>(std::ranges::count(text, '?'));
+    stmt.params_executed = 0;
+
+    for (auto open = text.find("/*"); open != std::string_view::npos; open = text.find("/*", open + 2)) {
+        const auto close = text.find("*/", open + 2);
+        std::string_view comment = trimmed(text.substr(open + 2, close == std::string_view::npos ? std::string_view::npos : close - open - 2));
+        if (!lowered(comment.substr(0, 4)).starts_with("mock")) continue;
+        comment.remove_prefix(4);
+        while (!comment.empty()) {
+            const auto end = comment.find_first_of(" \t\r\n;");
+            const std::string_view item = comment.substr(0, end);
+            comment = end == std::string_view::npos ? std::string_view{} : comment.substr(end + 1);
+            if (item.empty()) continue;
+            const auto equals = item.find('=');
+            if (equals == std::string_view::npos) return error(stmt, "42000", "Mock option without a value: " + std::string(item));
+            switch (apply_option(stmt.options, item.substr(0, equals), item.substr(equals + 1))) {
+                case Applied::ok: break;
+                case Applied::unknown_key: return error(stmt, "42000", "Unknown mock option: " + std::string(item));
+                case Applied::bad_value: return error(stmt, "42000", "Invalid mock option value: " + std::string(item));
+            }
+        }
+    }
+
+    // The first keyword, after whitespace, parentheses and comments, decides whether rows come back.
+    std::string_view rest = text;
+    for (;;) {
+        rest = trimmed(rest);
+        if (rest.starts_with("(")) {
+            rest.remove_prefix(1);
+        } else if (rest.starts_with("/*")) {
+            const auto close = rest.find("*/");
+            rest = close == std::string_view::npos ? std::string_view{} : rest.substr(close + 2);
+        } else if (rest.starts_with("--")) {
+            const auto newline = rest.find('\n');
+            rest = newline == std::string_view::npos ? std::string_view{} : rest.substr(newline + 1);
+        } else {
+            break;
+        }
+    }
+    const std::string keyword = lowered(rest.substr(0, rest.find_first_of(" \t\r\n(")));
+    stmt.query = keyword == "select" || keyword == "with" || keyword == "values";
+    stmt.prepared = true;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN execute(Stmt& stmt) {
+    if (!stmt.prepared) return error(stmt, "HY010", "Function sequence error: no prepared statement");
+    Dbc& dbc = *stmt.dbc;
+    close_cursor(stmt);
+    stmt.row_count = -1;
+    if (dbc.dead.load()) return error(stmt, "08S01", "Communication link failure");
+    if (dbc.options.activities == 1 && dbc.busy.load() > 0) {
+        return error(stmt, "HY000", "Connection is busy with results for another command");
+    }
+    stmt.execution = dbc.executes.fetch_add(1);
+    if (SQLRETURN ret = wait(&stmt, stmt.options.execute_latency); ret != SQL_SUCCESS) return ret;
+    if (fault_fires(stmt.options.fail_execute, stmt.options.seed, 1, stmt.execution)) {
+        return inject(stmt, dbc, stmt.options.fail_execute.state, "execute");
+    }
+
+    if (!stmt.query) {
+        const std::size_t first_set = stmt.params_executed;
+        stmt.params_executed += stmt.paramset_size;
+        const auto& fail = stmt.options.fail_param_set;
+        const bool fails = fail && *fail >= first_set && *fail < stmt.params_executed;
+        stmt.row_count = static_cast<SQLLEN>(stmt.paramset_size - (fails ? 1 : 0));
+        if (stmt.params_processed != nullptr) *stmt.params_processed = stmt.paramset_size;
+        if (stmt.param_status != nullptr) {
+            std::fill_n(stmt.param_status, stmt.paramset_size, static_cast<SQLUSMALLINT>(SQL_PARAM_SUCCESS));
+            if (fails) stmt.param_status[*fail - first_set] = SQL_PARAM_ERROR;
+        }
+        if (fails) {
+            const std::string message = "Injected fault on parameter set " + std::to_string(*fail);
+            return stmt.paramset_size == 1 ? error(stmt, "23000", message) : warning(stmt, "23000", message);
+        }
+        return SQL_SUCCESS;
+    }
+    if (stmt.params_processed != nullptr) *stmt.params_processed = stmt.paramset_size;
+    stmt.cursor_open = true;
+    stmt.holds_activity = true;
+    dbc.busy.fetch_add(1);
+    stmt.next_row = 0;
+    return SQL_SUCCESS;
+}
+
+// Converts a cell to a C type. Character data continues from `offset` and advances it.
+SQLRETURN write_value(Stmt& stmt, const Cell& cell, ColumnType type, SQLSMALLINT c_type, SQLPOINTER target, SQLLEN length,
+                      SQLLEN* indicator, std::size_t* offset) {
+    if (cell.null) {
+        if (indicator == nullptr) return error(stmt, "22002", "Indicator variable required but not supplied");
+        *indicator = SQL_NULL_DATA;
+        return SQL_SUCCESS;
+    }
+    if (c_type == SQL_C_DEFAULT) {
+        c_type = type == ColumnType::varchar ? SQL_C_CHAR : type == ColumnType::real ? SQL_C_DOUBLE
+               : type == ColumnType::integer ? SQL_C_SLONG : SQL_C_SBIGINT;
+    }
+    auto numeric = [&](double& real, long long& integer) {
+        if (type != ColumnType::varchar) {
+            real = cell.real;
+            integer = cell.integer;
+            return true;
+        }
+        return parse_number(cell.text, real) && ((integer = static_cast<long long>(real)), true);
+    };
+
+    switch (c_type) {
+        case SQL_C_CHAR: {
+            const std::size_t start = offset != nullptr ? *offset : 0;
+            const std::string_view rest = std::string_view(cell.text).substr(std::min(start, cell.text.size()));
+            const bool complete = copy_string(rest, target, length, indicator);
+            if (offset != nullptr) *offset = start + (complete ? rest.size() : static_cast<std::size_t>(std::max<SQLLEN>(length - 1, 0)));
+            return complete ? SQL_SUCCESS : warning(stmt, "01004", "String data, right truncated");
+        }
+        case SQL_C_SBIGINT:
+        case SQL_C_SLONG:
+        case SQL_C_LONG:
+        case SQL_C_DOUBLE: {
+            double real = 0.0;
+            long long integer = 0;
+            if (!numeric(real, integer)) return error(stmt, "22018", "Invalid character value for cast specification");
+            if (c_type == SQL_C_DOUBLE) {
+                std::memcpy(target, &real, sizeof(real));
+                if (indicator != nullptr) *indicator = sizeof(real);
+            } else if (c_type == SQL_C_SBIGINT) {
+                std::memcpy(target, &integer, sizeof(integer));
+                if (indicator != nullptr) *indicator = sizeof(integer);
+            } else {
+                if (integer < INT32_MIN || integer > INT32_MAX) return error(stmt, "22003", "Numeric value out of range");
+                const auto value = static_cast<std::int32_t>(integer);
+                std::memcpy(target, &value, sizeof(value));
+                if (indicator != nullptr) *indicator = sizeof(value);
+            }
+            return SQL_SUCCESS;
+        }
+        default:
+            return error(stmt, "HYC00", "Optional feature not implemented: C type " + std::to_string(c_type));
+    }
+}
+
+std::size_t element_size(SQLSMALLINT c_type, SQLLEN length) {
+    switch (c_type) {
+        case SQL_C_SBIGINT: return sizeof(long long);
+        case SQL_C_DOUBLE: return sizeof(double);
+        case SQL_C_SLONG:
+        case SQL_C_LONG: return sizeof(std::int32_t);
+        default: return static_cast<std::size_t>(std::max<SQLLEN>(length, 0));
+    }
+}
+
+SQLRETURN fetch(Stmt& stmt) {
+    if (!stmt.cursor_open) return error(stmt, "24000", "Invalid cursor state");
+    Dbc& dbc = *stmt.dbc;
+    if (dbc.dead.load()) return error(stmt, "08S01", "Communication link failure");
+    if (SQLRETURN ret = wait(&stmt, stmt.options.fetch_latency); ret != SQL_SUCCESS) return ret;
+
+    const Options& options = stmt.options;
+    const std::size_t remaining = options.rows - std::min(stmt.next_row, options.rows);
+    const std::size_t block = std::min<std::size_t>(std::max<SQLULEN>(stmt.row_array_size, 1), remaining);
+    if (stmt.rows_fetched != nullptr) *stmt.rows_fetched = 0;
+    stmt.on_row = false;
+    if (block == 0) {
+        release_activity(stmt);
+        return SQL_NO_DATA;
+    }
+    for (std::size_t i = 0; i < block; ++i) {
+        const std::size_t row = stmt.next_row + i;
+        const bool after_rows = options.fail_after_rows && row >= *options.fail_after_rows;
+        if (after_rows || fault_fires(options.fail_fetch, options.seed, 2 + stmt.execution, row)) {
+            return inject(stmt, dbc, options.fail_fetch.state.empty() ? std::string("08S01") : options.fail_fetch.state, "fetch");
+        }
+    }
+
+    SQLRETURN result = SQL_SUCCESS;
+    for (std::size_t i = 0; i < block; ++i) {
+        bool truncated = false;
+        for (std::size_t c = 0; c < stmt.bound.size() && c < options.columns.size(); ++c) {
+            const BoundColumn& bound = stmt.bound[c];
+            if (bound.target == nullptr && bound.indicator == nullptr) continue;
+            const std::size_t stride = stmt.row_bind_type != SQL_BIND_BY_COLUMN ? stmt.row_bind_type : element_size(bound.c_type, bound.length);
+            const std::size_t indicator_stride = stmt.row_bind_type != SQL_BIND_BY_COLUMN ? stmt.row_bind_type : sizeof(SQLLEN);
+            auto* target = bound.target != nullptr ? static_cast<char*>(bound.target) + i * stride : nullptr;
+            auto* indicator = bound.indicator != nullptr
+                ? reinterpret_cast<SQLLEN*>(reinterpret_cast<char*>(bound.indicator) + i * indicator_stride) : nullptr;
+            const SQLRETURN ret = write_value(stmt, generate(options, stmt.next_row + i, c), options.columns[c], bound.c_type,
+                                              target, bound.length, indicator, nullptr);
+            if (ret == SQL_ERROR) return ret;
+            truncated = truncated || ret == SQL_SUCCESS_WITH_INFO;
+        }
+        if (stmt.row_status != nullptr) stmt.row_status[i] = truncated ? SQL_ROW_SUCCESS_WITH_INFO : SQL_ROW_SUCCESS;
+        if (truncated) result = SQL_SUCCESS_WITH_INFO;
+    }
+    if (stmt.row_status != nullptr) {
+        for (std::size_t i = block; i < stmt.row_array_size; ++i) stmt.row_status[i] = SQL_ROW_NOROW;
+    }
+    if (stmt.rows_fetched != nullptr) *stmt.rows_fetched = block;
+    stmt.current_row = stmt.next_row;
+    stmt.next_row += block;
+    stmt.on_row = true;
+    stmt.getdata_offset.assign(options.columns.size(), 0);
+    stmt.getdata_done.assign(options.columns.size(), false);
+    return result;
+}
+
+SQLRETURN get_data(Stmt& stmt, SQLUSMALLINT column, SQLSMALLINT c_type, SQLPOINTER target, SQLLEN length, SQLLEN* indicator) {
+    if (!stmt.cursor_open || !stmt.on_row) return error(stmt, "24000", "Invalid cursor state");
+    if (column == 0 || column > stmt.options.columns.size()) return error(stmt, "07009", "Invalid descriptor index");
+    const std::size_t c = column - 1;
+    if (stmt.getdata_done[c]) return SQL_NO_DATA;   // a character value was returned completely
+    const Cell cell = generate(stmt.options, stmt.current_row, c);
+    const bool character = c_type == SQL_C_CHAR || (c_type == SQL_C_DEFAULT && stmt.options.columns[c] == ColumnType::varchar);
+    const SQLRETURN ret = write_value(stmt, cell, stmt.options.columns[c], c_type, target, length, indicator,
+                                      character ? &stmt.getdata_offset[c] : nullptr);
+    if (character && ret == SQL_SUCCESS) stmt.getdata_done[c] = true;
+    return ret;
+}
+
+SQLSMALLINT sql_type(ColumnType type) {
+    switch (type) {
+        case ColumnType::integer: return SQL_INTEGER;
+        case ColumnType::bigint: return SQL_BIGINT;
+        case ColumnType::real: return SQL_DOUBLE;
+        case ColumnType::varchar: return SQL_VARCHAR;
+    }
+    return SQL_VARCHAR;
+}
+
+SQLULEN column_size(const Options& options, ColumnType type) {
+    switch (type) {
+        case ColumnType::integer: return 10;
+        case ColumnType::bigint: return 19;
+        case ColumnType::real: return 15;
+        case ColumnType::varchar: return std::max<std::size_t>(options.strings.max, 1);
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------------ info
+
+SQLRETURN get_info(Dbc& dbc, SQLUSMALLINT type, SQLPOINTER value, SQLSMALLINT length, SQLSMALLINT* out_length) {
+    auto text = [&](std::string_view s) {
+        return copy_string(s, value, length, out_length) ? SQL_SUCCESS : warning(dbc, "01004", "String data, right truncated");
+    };
+    auto number = [&](auto n) {
+        if (value != nullptr) std::memcpy(value, &n, sizeof(n));
+        if (out_length != nullptr) *out_length = sizeof(n);
+        return SQL_SUCCESS;
+    };
+    switch (type) {
+        case SQL_DRIVER_NAME: return text("libodbcmock.so");
+        case SQL_DRIVER_VER: return text("01.00.0000");
+        case SQL_DRIVER_ODBC_VER: return text("03.80");
+        case SQL_DBMS_NAME: return text(dbc.options.dbms);
+        case SQL_DBMS_VER: return text("01.00.0000");
+        case SQL_SERVER_NAME: return text("mock");
+        case SQL_DATA_SOURCE_NAME: return text("");
+        case SQL_IDENTIFIER_QUOTE_CHAR: return text("\"");
+        case SQL_MAX_CONCURRENT_ACTIVITIES: return number(static_cast<SQLUSMALLINT>(dbc.options.activities));
+        case SQL_MAX_DRIVER_CONNECTIONS: return number(static_cast<SQLUSMALLINT>(0));
+        case SQL_TXN_CAPABLE: return number(static_cast<SQLUSMALLINT>(SQL_TC_ALL));
+        case SQL_CURSOR_COMMIT_BEHAVIOR:
+        case SQL_CURSOR_ROLLBACK_BEHAVIOR: return number(static_cast<SQLUSMALLINT>(SQL_CB_PRESERVE));
+        case SQL_GETDATA_EXTENSIONS: return number(static_cast<SQLUINTEGER>(SQL_GD_ANY_COLUMN | SQL_GD_ANY_ORDER | SQL_GD_BOUND));
+        case SQL_SCROLL_OPTIONS: return number(static_cast<SQLUINTEGER>(SQL_SO_FORWARD_ONLY));
+        case SQL_PARAM_ARRAY_ROW_COUNTS: return number(static_cast<SQLUINTEGER>(SQL_PARC_BATCH));
+        case SQL_PARAM_ARRAY_SELECTS: return number(static_cast<SQLUINTEGER>(SQL_PAS_NO_SELECT));
+        default: return error(dbc, "HY096", "Information type out of range: " + std::to_string(type));
+    }
+}
+
+} // namespace
+
+// ------------------------------------------------------------------ ODBC entry points
+//
+// The entry points never call each other: with a driver manager loaded, a call to an
+// exported SQL* name could bind to the manager's function instead of this driver's.
+
+MOCK_EXPORT SQLRETURN SQL_API SQLAllocHandle(SQLSMALLINT type, SQLHANDLE input, SQLHANDLE* output) {
+    if (output == nullptr) return SQL_ERROR;
+    *output = SQL_NULL_HANDLE;
+    switch (type) {
+        case SQL_HANDLE_ENV:
+            *output = new Env();
+            return SQL_SUCCESS;
+        case SQL_HANDLE_DBC: {
+            auto* env = as<Env>(input, SQL_HANDLE_ENV);
+            if (env == nullptr) return SQL_INVALID_HANDLE;
+            env->diagnostics.clear();
+            *output = new Dbc(env);
+            return SQL_SUCCESS;
+        }
+        case SQL_HANDLE_STMT: {
+            auto* dbc = as<Dbc>(input, SQL_HANDLE_DBC);
+            if (dbc == nullptr) return SQL_INVALID_HANDLE;
+            dbc->diagnostics.clear();
+            if (!dbc->connected) return error(*dbc, "08003", "Connection not open");
+            *output = new Stmt(dbc);
+            return SQL_SUCCESS;
+        }
+        default:
+            return SQL_ERROR;
+    }
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLFreeHandle(SQLSMALLINT type, SQLHANDLE handle) {
+    switch (type) {
+        case SQL_HANDLE_ENV:
+            if (auto* env = as<Env>(handle, type)) { env->magic = 0; delete env; return SQL_SUCCESS; }
+            break;
+        case SQL_HANDLE_DBC:
+            if (auto* dbc = as<Dbc>(handle, type)) { dbc->magic = 0; delete dbc; return SQL_SUCCESS; }
+            break;
+        case SQL_HANDLE_STMT:
+            if (auto* stmt = as<Stmt>(handle, type)) { close_cursor(*stmt); stmt->magic = 0; delete stmt; return SQL_SUCCESS; }
+            break;
+        default:
+            break;
+    }
+    return SQL_INVALID_HANDLE;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLSetEnvAttr(SQLHENV handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER) {
+    auto* env = as<Env>(handle, SQL_HANDLE_ENV);
+    if (env == nullptr) return SQL_INVALID_HANDLE;
+    env->diagnostics.clear();
+    if (attribute == SQL_ATTR_ODBC_VERSION) env->odbc_version = static_cast<SQLINTEGER>(reinterpret_cast<SQLLEN>(value));
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetEnvAttr(SQLHENV handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER, SQLINTEGER* length) {
+    auto* env = as<Env>(handle, SQL_HANDLE_ENV);
+    if (env == nullptr) return SQL_INVALID_HANDLE;
+    env->diagnostics.clear();
+    SQLINTEGER result = attribute == SQL_ATTR_ODBC_VERSION ? env->odbc_version : 0;
+    if (value != nullptr) std::memcpy(value, &result, sizeof(result));
+    if (length != nullptr) *length = sizeof(result);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLDriverConnect(SQLHDBC handle, SQLHWND, SQLCHAR* in, SQLSMALLINT in_length, SQLCHAR* out,
+                                               SQLSMALLINT out_capacity, SQLSMALLINT* out_length, SQLUSMALLINT) {
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    if (dbc->connected) return error(*dbc, "08002", "Connection name in use");
+    const char* chars = reinterpret_cast<const char*>(in);
+    const std::string_view text = chars == nullptr ? std::string_view{}
+                                : in_length == SQL_NTS ? std::string_view(chars) : std::string_view(chars, static_cast<std::size_t>(in_length));
+
+    Options options;
+    for (std::string_view rest = text; !rest.empty();) {
+        const auto equals = rest.find('=');
+        if (equals == std::string_view::npos) break;
+        const std::string_view key = rest.substr(0, equals);
+        rest.remove_prefix(equals + 1);
+        std::string_view value;
+        if (rest.starts_with("{")) {
+            const auto close = rest.find('}');
+            value = rest.substr(1, close == std::string_view::npos ? std::string_view::npos : close - 1);
+            rest = close == std::string_view::npos ? std::string_view{} : rest.substr(close + 1);
+        } else {
+            value = rest.substr(0, rest.find(';'));
+            rest.remove_prefix(value.size());
+        }
+        if (rest.starts_with(";")) rest.remove_prefix(1);
+        if (apply_option(options, key, value) == Applied::bad_value) {
+            return error(*dbc, "HY024", "Invalid attribute value: " + std::string(trimmed(key)) + "=" + std::string(value));
+        }
+    }
+
+    if (SQLRETURN ret = wait(nullptr, options.connect_latency); ret != SQL_SUCCESS) return ret;
+    if (fault_fires(options.fail_connect, options.seed, 0, connect_attempts.fetch_add(1))) {
+        return error(*dbc, options.fail_connect.state, "Injected fault on connect");
+    }
+    dbc->options = std::move(options);
+    dbc->connected = true;
+    if (out != nullptr || out_length != nullptr) copy_string(text, out, out_capacity, out_length);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLDisconnect(SQLHDBC handle) {
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    if (!dbc->connected) return error(*dbc, "08003", "Connection not open");
+    dbc->connected = false;
+    dbc->dead.store(false);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetInfo(SQLHDBC handle, SQLUSMALLINT type, SQLPOINTER value, SQLSMALLINT length, SQLSMALLINT* out_length) {
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    return get_info(*dbc, type, value, length, out_length);
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLSetConnectAttr(SQLHDBC handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER) {
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    const auto number = reinterpret_cast<SQLULEN>(value);
+    if (attribute == SQL_ATTR_AUTOCOMMIT) dbc->autocommit = number == SQL_AUTOCOMMIT_ON;
+    else if (attribute == SQL_ATTR_LOGIN_TIMEOUT) dbc->login_timeout = static_cast<SQLUINTEGER>(number);
+    return SQL_SUCCESS;   // other attributes are accepted and ignored
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetConnectAttr(SQLHDBC handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER, SQLINTEGER* length) {
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    SQLUINTEGER result = 0;
+    if (attribute == SQL_ATTR_AUTOCOMMIT) result = dbc->autocommit ? SQL_AUTOCOMMIT_ON : SQL_AUTOCOMMIT_OFF;
+    else if (attribute == SQL_ATTR_CONNECTION_DEAD) result = dbc->dead.load() || !dbc->connected ? SQL_CD_TRUE : SQL_CD_FALSE;
+    else if (attribute == SQL_ATTR_LOGIN_TIMEOUT) result = dbc->login_timeout;
+    else return error(*dbc, "HY092", "Invalid attribute/option identifier");
+    if (value != nullptr) std::memcpy(value, &result, sizeof(result));
+    if (length != nullptr) *length = sizeof(result);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLEndTran(SQLSMALLINT type, SQLHANDLE handle, SQLSMALLINT) {
+    if (type == SQL_HANDLE_ENV) return as<Env>(handle, type) != nullptr ? SQL_SUCCESS : SQL_INVALID_HANDLE;
+    auto* dbc = as<Dbc>(handle, SQL_HANDLE_DBC);
+    if (type != SQL_HANDLE_DBC || dbc == nullptr) return SQL_INVALID_HANDLE;
+    dbc->diagnostics.clear();
+    if (dbc->dead.load()) return error(*dbc, "08S01", "Communication link failure");
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLPrepare(SQLHSTMT handle, SQLCHAR* text, SQLINTEGER length) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    const char* chars = reinterpret_cast<const char*>(text);
+    if (chars == nullptr) return error(*stmt, "HY009", "Invalid use of null pointer");
+    return prepare(*stmt, length == SQL_NTS ? std::string_view(chars) : std::string_view(chars, static_cast<std::size_t>(length)));
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLExecute(SQLHSTMT handle) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    stmt->canceled.store(false);
+    return execute(*stmt);
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLExecDirect(SQLHSTMT handle, SQLCHAR* text, SQLINTEGER length) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    stmt->canceled.store(false);
+    const char* chars = reinterpret_cast<const char*>(text);
+    if (chars == nullptr) return error(*stmt, "HY009", "Invalid use of null pointer");
+    if (SQLRETURN ret = prepare(*stmt, length == SQL_NTS ? std::string_view(chars) : std::string_view(chars, static_cast<std::size_t>(length)));
+        ret != SQL_SUCCESS) {
+        return ret;
+    }
+    return execute(*stmt);
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLFetch(SQLHSTMT handle) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    return fetch(*stmt);
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetData(SQLHSTMT handle, SQLUSMALLINT column, SQLSMALLINT c_type, SQLPOINTER target, SQLLEN length,
+                                         SQLLEN* indicator) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    return get_data(*stmt, column, c_type, target, length, indicator);
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLBindCol(SQLHSTMT handle, SQLUSMALLINT column, SQLSMALLINT c_type, SQLPOINTER target, SQLLEN length,
+                                         SQLLEN* indicator) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (column == 0) return error(*stmt, "07009", "Invalid descriptor index");
+    if (stmt->bound.size() < column) stmt->bound.resize(column);
+    stmt->bound[column - 1] = BoundColumn{c_type, target, length, indicator};
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLBindParameter(SQLHSTMT handle, SQLUSMALLINT parameter, SQLSMALLINT, SQLSMALLINT, SQLSMALLINT,
+                                               SQLULEN, SQLSMALLINT, SQLPOINTER, SQLLEN, SQLLEN*) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    // Values do not influence the generated data; only the parameter set size (row counts) does.
+    return parameter == 0 ? error(*stmt, "07009", "Invalid descriptor index") : SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLNumParams(SQLHSTMT handle, SQLSMALLINT* count) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (count != nullptr) *count = static_cast<SQLSMALLINT>(stmt->parameter_markers);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLNumResultCols(SQLHSTMT handle, SQLSMALLINT* count) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (!stmt->prepared) return error(*stmt, "HY010", "Function sequence error");
+    if (count != nullptr) *count = stmt->query ? static_cast<SQLSMALLINT>(stmt->options.columns.size()) : 0;
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLDescribeCol(SQLHSTMT handle, SQLUSMALLINT column, SQLCHAR* name, SQLSMALLINT name_capacity,
+                                             SQLSMALLINT* name_length, SQLSMALLINT* type, SQLULEN* size, SQLSMALLINT* digits,
+                                             SQLSMALLINT* nullable) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (!stmt->prepared || !stmt->query) return error(*stmt, "07005", "Prepared statement not a cursor-specification");
+    if (column == 0 || column > stmt->options.columns.size()) return error(*stmt, "07009", "Invalid descriptor index");
+    const ColumnType column_type = stmt->options.columns[column - 1];
+    if (type != nullptr) *type = sql_type(column_type);
+    if (size != nullptr) *size = column_size(stmt->options, column_type);
+    if (digits != nullptr) *digits = 0;
+    if (nullable != nullptr) {
+        const bool row_number = column == 1 && (column_type == ColumnType::integer || column_type == ColumnType::bigint);
+        *nullable = stmt->options.null_rate > 0.0 && !row_number ? SQL_NULLABLE : SQL_NO_NULLS;
+    }
+    const bool complete = copy_string("c" + std::to_string(column), name, name_capacity, name_length);
+    return complete ? SQL_SUCCESS : warning(*stmt, "01004", "String data, right truncated");
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLRowCount(SQLHSTMT handle, SQLLEN* count) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (count != nullptr) *count = stmt->row_count;
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLMoreResults(SQLHSTMT handle) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    close_cursor(*stmt);
+    return SQL_NO_DATA;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLCloseCursor(SQLHSTMT handle) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    if (!stmt->cursor_open) return error(*stmt, "24000", "Invalid cursor state");
+    close_cursor(*stmt);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLFreeStmt(SQLHSTMT handle, SQLUSMALLINT option) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    switch (option) {
+        case SQL_CLOSE: close_cursor(*stmt); return SQL_SUCCESS;
+        case SQL_UNBIND: stmt->bound.clear(); return SQL_SUCCESS;
+        case SQL_RESET_PARAMS: return SQL_SUCCESS;
+        case SQL_DROP: close_cursor(*stmt); stmt->magic = 0; delete stmt; return SQL_SUCCESS;
+        default: return error(*stmt, "HY092", "Invalid attribute/option identifier");
+    }
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLCancel(SQLHSTMT handle) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    // Called from another thread while an execute or fetch waits: only touch the flag.
+    stmt->canceled.store(true);
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLSetStmtAttr(SQLHSTMT handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    const auto number = reinterpret_cast<SQLULEN>(value);
+    switch (attribute) {
+        case SQL_ATTR_ROW_ARRAY_SIZE: stmt->row_array_size = std::max<SQLULEN>(number, 1); break;
+        case SQL_ATTR_ROW_BIND_TYPE: stmt->row_bind_type = number; break;
+        case SQL_ATTR_ROWS_FETCHED_PTR: stmt->rows_fetched = static_cast<SQLULEN*>(value); break;
+        case SQL_ATTR_ROW_STATUS_PTR: stmt->row_status = static_cast<SQLUSMALLINT*>(value); break;
+        case SQL_ATTR_PARAMSET_SIZE: stmt->paramset_size = std::max<SQLULEN>(number, 1); break;
+        case SQL_ATTR_PARAM_BIND_TYPE: break;
+        case SQL_ATTR_PARAMS_PROCESSED_PTR: stmt->params_processed = static_cast<SQLULEN*>(value); break;
+        case SQL_ATTR_PARAM_STATUS_PTR: stmt->param_status = static_cast<SQLUSMALLINT*>(value); break;
+        case SQL_ATTR_QUERY_TIMEOUT: stmt->query_timeout = number; break;
+        default: break;   // accepted and ignored
+    }
+    return SQL_SUCCESS;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetStmtAttr(SQLHSTMT handle, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER, SQLINTEGER* length) {
+    auto* stmt = as<Stmt>(handle, SQL_HANDLE_STMT);
+    if (stmt == nullptr) return SQL_INVALID_HANDLE;
+    stmt->diagnostics.clear();
+    auto pointer = [&](void* p) {
+        if (value != nullptr) std::memcpy(value, &p, sizeof(p));
+        if (length != nullptr) *length = sizeof(p);
+        return SQL_SUCCESS;
+    };
+    auto number = [&](SQLULEN n) {
+        if (value != nullptr) std::memcpy(value, &n, sizeof(n));
+        if (length != nullptr) *length = sizeof(n);
+        return SQL_SUCCESS;
+    };
+    switch (attribute) {
+        // The driver manager asks for the implicit descriptors; they carry no fields here.
+        case SQL_ATTR_APP_ROW_DESC: return pointer(&stmt->app_row);
+        case SQL_ATTR_APP_PARAM_DESC: return pointer(&stmt->app_param);
+        case SQL_ATTR_IMP_ROW_DESC: return pointer(&stmt->imp_row);
+        case SQL_ATTR_IMP_PARAM_DESC: return pointer(&stmt->imp_param);
+        case SQL_ATTR_ROW_ARRAY_SIZE: return number(stmt->row_array_size);
+        case SQL_ATTR_ROW_BIND_TYPE: return number(stmt->row_bind_type);
+        case SQL_ATTR_PARAMSET_SIZE: return number(stmt->paramset_size);
+        case SQL_ATTR_QUERY_TIMEOUT: return number(stmt->query_timeout);
+        case SQL_ATTR_ROWS_FETCHED_PTR: return pointer(stmt->rows_fetched);
+        case SQL_ATTR_ROW_STATUS_PTR: return pointer(stmt->row_status);
+        default: return error(*stmt, "HY092", "Invalid attribute/option identifier");
+    }
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetDiagRec(SQLSMALLINT type, SQLHANDLE handle, SQLSMALLINT record, SQLCHAR* state, SQLINTEGER* native,
+                                            SQLCHAR* message, SQLSMALLINT capacity, SQLSMALLINT* length) {
+    auto* h = static_cast<Handle*>(handle);
+    if (h == nullptr || h->magic != handle_magic || h->type != type) return SQL_INVALID_HANDLE;
+    if (record <= 0) return SQL_ERROR;
+    if (static_cast<std::size_t>(record) > h->diagnostics.size()) return SQL_NO_DATA;
+    const Diagnostic& diagnostic = h->diagnostics[static_cast<std::size_t>(record) - 1];
+    if (state != nullptr) copy_string(diagnostic.state, state, 6, static_cast<SQLSMALLINT*>(nullptr));
+    if (native != nullptr) *native = diagnostic.native;
+    return copy_string(diagnostic.message, message, capacity, length) ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+}
+
+MOCK_EXPORT SQLRETURN SQL_API SQLGetDiagField(SQLSMALLINT type, SQLHANDLE handle, SQLSMALLINT record, SQLSMALLINT field,
+                                              SQLPOINTER value, SQLSMALLINT capacity, SQLSMALLINT* length) {
+    auto* h = static_cast<Handle*>(handle);
+    if (h == nullptr || h->magic != handle_magic || h->type != type) return SQL_INVALID_HANDLE;
+    if (field == SQL_DIAG_NUMBER) {
+        const auto count = static_cast<SQLINTEGER>(h->diagnostics.size());
+        if (value != nullptr) std::memcpy(value, &count, sizeof(count));
+        return SQL_SUCCESS;
+    }
+    if (record <= 0) return SQL_ERROR;
+    if (static_cast<std::size_t>(record) > h->diagnostics.size()) return SQL_NO_DATA;
+    const Diagnostic& diagnostic = h->diagnostics[static_cast<std::size_t>(record) - 1];
+    switch (field) {
+        case SQL_DIAG_SQLSTATE: return copy_string(diagnostic.state, value, capacity, length) ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+        case SQL_DIAG_MESSAGE_TEXT: return copy_string(diagnostic.message, value, capacity, length) ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+        case SQL_DIAG_NATIVE:
+            if (value != nullptr) std::memcpy(value, &diagnostic.native, sizeof(diagnostic.native));
+            return SQL_SUCCESS;
+        case SQL_DIAG_CLASS_ORIGIN:
+        case SQL_DIAG_SUBCLASS_ORIGIN:
+            return copy_string(diagnostic.state.starts_with("IM") ? "ODBC 3.0" : "ISO 9075", value, capacity, length) ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+        case SQL_DIAG_CONNECTION_NAME:
+        case SQL_DIAG_SERVER_NAME:
+            return copy_string("mock", value, capacity, length) ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+        default:
+            return SQL_ERROR;
+    }
+}
@@ -0,0 +1,549 @@
+// Deterministic tests of the wrapper against the mock ODBC driver, built and run by `make mock_test`.
+//
+// No database is involved: every result comes from the generator in
+// mock_driver.cpp, so row counts, values, latencies and failures are known up
+// front. MOCK_DRIVER_PATH is the absolute path of libodbcmock.so, which the
+// driver manager loads directly from the connection string.
+
+#include "bulk.h"
+#include "connection_pool.h"
+#include "executor.h"
+#include "fan_out.h"
+#include "point_lookup_batcher.h"
+#include "pool_telemetry.h"
+#include "slow_query_log.h"
+#include "snapshot_file.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef MOCK_DRIVER_PATH
+#define MOCK_DRIVER_PATH "libodbcmock.so"
+#endif
+
+const std::string MOCK_CONNECTION = "Driver=" MOCK_DRIVER_PATH ";";
+
+// --- Simple Assertion and Test Framework ---
+#define ASSERT_TRUE(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "\n--- ASSERTION FAILED ---\n" \
+                  << "Thread " << std::this_thread::get_id() << "\n" \
+                  << "File: " << __FILE__ << ", Line: " << __LINE__ << "\n" \
+                  << "Condition: " << #condition << "\n" \
+                  << "Message: " << message << "\n" \
+                  << "------------------------" << std::endl; \
+        return false; \
+    }
+
+// Reads column `column` of every row as text; NULLs become "<null>".
+std::expected<std::vector<std::string>, odbc::OdbcError> read_column(odbc::Statement& stmt, SQLUSMALLINT column) {
+    std::vector<std::string> values;
+    for (;;) {
+        auto fetched = stmt.fetch();
+        if (!fetched) return std::unexpected(fetched.error());
+        if (!*fetched) break;
+        auto value = stmt.get_data<std::string>(column);
+        if (!value) return std::unexpected(value.error());
+        values.push_back(value->value_or("<null>"));
+    }
+    return values;
+}
+
+[[nodiscard]] bool test_mock_result_shape() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=10;Columns=int,bigint,double,varchar;StringLength=12");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+    ASSERT_TRUE(conn.dbms_name().value_or("") == "MockDB", "Unexpected DBMS name.");
+    ASSERT_TRUE(conn.supports_multiple_active_statements().value_or(false), "Activities=0 should allow any number of statements.");
+
+    odbc::Statement stmt(conn);
+    auto exec_res = stmt.execute_direct("SELECT * FROM anything");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    ASSERT_TRUE(stmt.num_result_cols().value_or(0) == 4, "Expected four columns.");
+    auto described = stmt.describe_column(4);
+    ASSERT_TRUE(described.has_value(), described.error().to_string());
+    ASSERT_TRUE(described->data_type == SQL_VARCHAR && described->column_size == 12 && !described->nullable,
+                "Unexpected description of the varchar column.");
+
+    long long expected_id = 0;
+    while (stmt.fetch().value_or(false)) {
+        auto id = stmt.get_data<long long>(1);
+        ASSERT_TRUE(id.has_value() && id->has_value(), "Row number missing.");
+        ASSERT_TRUE(**id == ++expected_id, std::format("Row number {} where {} was expected.", **id, expected_id));
+        auto text = stmt.get_data<std::string>(4);
+        ASSERT_TRUE(text.has_value() && text->has_value() && (*text)->size() == 12, "Fixed-length string has the wrong length.");
+    }
+    ASSERT_TRUE(expected_id == 10, std::format("Read {} rows instead of 10.", expected_id));
+
+    auto update = stmt.execute_direct("UPDATE t SET x = 1");
+    ASSERT_TRUE(update.has_value(), update.error().to_string());
+    ASSERT_TRUE(stmt.row_count().value_or(0) == 1, "A statement without results should affect one row.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_deterministic_data() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=50;Columns=bigint,varchar;NullRate=0.2;Seed=7");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::Statement stmt(conn);
+    auto run = [&](std::string_view query) -> std::expected<std::vector<std::string>, odbc::OdbcError> {
+        if (auto exec = stmt.execute_direct(query); !exec) return std::unexpected(exec.error());
+        auto values = read_column(stmt, 2);
+        (void)stmt.close_cursor();
+        return values;
+    };
+    auto first = run("SELECT s FROM t");
+    auto second = run("SELECT s FROM t");
+    auto reseeded = run("SELECT s FROM t /*mock seed=8*/");
+    ASSERT_TRUE(first.has_value() && second.has_value() && reseeded.has_value(), "A query failed.");
+    ASSERT_TRUE(first->size() == 50, "Expected 50 rows.");
+    ASSERT_TRUE(*first == *second, "The same seed produced different data.");
+    ASSERT_TRUE(*first != *reseeded, "A different seed produced the same data.");
+
+    auto unknown = stmt.execute_direct("SELECT 1 /*mock rowz=5*/");
+    ASSERT_TRUE(!unknown.has_value() && unknown.error().sql_state == "42000", "An unknown statement option was accepted.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_null_rate() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=2000;Columns=bigint,double;NullRate=0.25");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::Statement stmt(conn);
+    auto exec_res = stmt.execute_direct("SELECT id, d FROM t");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    std::size_t nulls = 0;
+    while (stmt.fetch().value_or(false)) {
+        auto id = stmt.get_data<long long>(1);
+        auto value = stmt.get_data<double>(2);
+        ASSERT_TRUE(id.has_value() && id->has_value(), "The row number column must never be NULL.");
+        ASSERT_TRUE(value.has_value(), value.error().to_string());
+        nulls += value->has_value() ? 0 : 1;
+    }
+    // 500 expected; the bounds are far outside what a fixed seed could miss.
+    ASSERT_TRUE(nulls > 400 && nulls < 600, std::format("{} NULLs in 2000 rows at a 25% rate.", nulls));
+    return true;
+}
+
+[[nodiscard]] bool test_mock_long_strings() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=20;Columns=bigint,varchar;StringLength=lognormal:2000-9000");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    // Values longer than get_data's first buffer come back in two SQLGetData calls.
+    odbc::Statement stmt(conn);
+    auto exec_res = stmt.execute_direct("SELECT id, s FROM t");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    auto values = read_column(stmt, 2);
+    ASSERT_TRUE(values.has_value(), values.error().to_string());
+    std::size_t long_values = 0;
+    for (const std::string& value : *values) {
+        long_values += value.size() > 1024 ? 1 : 0;
+    }
+    ASSERT_TRUE(long_values > 0, "No value exceeded the first get_data buffer.");
+
+    // The same rows read through bound buffers, which never split a value, must match exactly.
+    auto again = stmt.execute_direct("SELECT id, s FROM t");
+    ASSERT_TRUE(again.has_value(), again.error().to_string());
+    auto cursor = odbc::BlockCursor::open(stmt, 8, 9000);
+    ASSERT_TRUE(cursor.has_value(), cursor.error().to_string());
+    std::size_t row = 0;
+    while (cursor->fetch_block().value_or(0) > 0) {
+        for (std::size_t r = 0; r < cursor->rows(); ++r, ++row) {
+            const std::string bound(cursor->get<std::string_view>(r, 1).value_or("<null>"));
+            ASSERT_TRUE(row < values->size() && (*values)[row] == bound,
+                        std::format("Row {}: get_data returned {} characters, the bound buffer {}.", row + 1,
+                                    row < values->size() ? (*values)[row].size() : 0, bound.size()));
+        }
+    }
+    ASSERT_TRUE(row == values->size(), "The two reads returned different row counts.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_latency_injection() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=5;ExecuteLatencyUs=20000;FetchLatencyUs=2000");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::Statement stmt(conn);
+    const auto started = std::chrono::steady_clock::now();
+    auto exec_res = stmt.execute_direct("SELECT latency_probe FROM t");
+    const auto executed = std::chrono::steady_clock::now();
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    std::size_t rows = 0;
+    while (stmt.fetch().value_or(false)) ++rows;
+    const auto fetched = std::chrono::steady_clock::now();
+    ASSERT_TRUE(rows == 5, "Expected five rows.");
+    ASSERT_TRUE(executed - started >= std::chrono::milliseconds(20), "Execute returned before its latency.");
+    // Six fetch calls: five rows and the end of the result.
+    ASSERT_TRUE(fetched - executed >= std::chrono::milliseconds(12), "Fetches returned before their latency.");
+
+    if constexpr (odbc::DefaultInstrumentation::query_stats) {
+        // The maximum is the whole execution, so it can never be below the mean.
+        const auto entries = odbc::query_stats();
+        const auto it = std::ranges::find_if(entries, [](const odbc::QueryStatsEntry& e) { return e.query.find("latency_probe") != std::string::npos; });
+        ASSERT_TRUE(it != entries.end() && it->calls == 1, "The query has no statistics.");
+        ASSERT_TRUE(it->max_time >= std::chrono::milliseconds(32) && it->max_time >= it->total_time,
+                    std::format("max_time {} is not the whole execution (total {}).", it->max_time.count(), it->total_time.count()));
+    }
+    return true;
+}
+
+[[nodiscard]] bool test_mock_fault_injection() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=100");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::Statement stmt(conn);
+    auto deadlock = stmt.execute_direct("UPDATE t SET x = 1 /*mock failexecute=40001*/");
+    ASSERT_TRUE(!deadlock.has_value() && deadlock.error().sql_state == "40001", "Expected an injected 40001.");
+    auto retried = stmt.execute_direct("UPDATE t SET x = 1");
+    ASSERT_TRUE(retried.has_value(), "A non-connection fault should leave the connection usable.");
+
+    auto exec_res = stmt.execute_direct("SELECT * FROM t /*mock failafterrows=3*/");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    std::size_t rows = 0;
+    std::expected<bool, odbc::OdbcError> fetched;
+    while ((fetched = stmt.fetch()) && *fetched) ++rows;
+    ASSERT_TRUE(rows == 3 && !fetched.has_value() && fetched.error().sql_state == "08S01",
+                std::format("Expected a link failure after 3 rows, read {}.", rows));
+
+    SQLUINTEGER dead = SQL_CD_FALSE;
+    SQLGetConnectAttr(conn.get(), SQL_ATTR_CONNECTION_DEAD, &dead, SQL_IS_UINTEGER, nullptr);
+    ASSERT_TRUE(dead == SQL_CD_TRUE, "The connection should report itself dead.");
+    auto after = stmt.execute_direct("SELECT 1");
+    ASSERT_TRUE(!after.has_value() && after.error().sql_state == "08S01", "A dead connection accepted a statement.");
+
+    odbc::Connection refused(env);
+    auto refused_res = refused.driver_connect(MOCK_CONNECTION + "FailConnect=08001");
+    ASSERT_TRUE(!refused_res.has_value() && refused_res.error().sql_state == "08001", "Expected an injected connect failure.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_block_cursor_and_arrays() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=1000;Columns=bigint,double,varchar;NullRate=0.1");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    odbc::Statement stmt(conn);
+    auto exec_res = stmt.execute_direct("SELECT id, d, s FROM t");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    std::size_t rows = 0;
+    long long sum = 0;
+    {
+        auto cursor = odbc::BlockCursor::open(stmt, 64);
+        ASSERT_TRUE(cursor.has_value(), cursor.error().to_string());
+        for (;;) {
+            auto block = cursor->fetch_block();
+            ASSERT_TRUE(block.has_value(), block.error().to_string());
+            if (*block == 0) break;
+            for (std::size_t r = 0; r < cursor->rows(); ++r) {
+                sum += cursor->get<long long>(r, 0).value_or(0);
+            }
+            rows += *block;
+        }
+    }
+    ASSERT_TRUE(rows == 1000 && sum == 500500, std::format("Block fetch read {} rows summing to {}.", rows, sum));
+
+    auto prepared = stmt.prepare("INSERT INTO t (id, d, s) VALUES (?, ?, ?)");
+    ASSERT_TRUE(prepared.has_value(), prepared.error().to_string());
+    odbc::ParameterArray batch(3);
+    for (long long r = 0; r < 250; ++r) {
+        batch.add_row({r, static_cast<double>(r) / 2.0, std::format("row-{}", r)});
+    }
+    auto inserted = odbc::execute_array(stmt, batch, 100);
+    ASSERT_TRUE(inserted.has_value(), inserted.error().to_string());
+    return true;
+}
+
+[[nodiscard]] bool test_mock_pool_secondary_connection() {
+    // With one activity per connection, a nested query needs a second connection.
+    const std::string connection = MOCK_CONNECTION + "Rows=3;Activities=1";
+    auto outer = getThreadLocalStatement("MOCK_POOL_NESTED", connection);
+    auto exec_res = outer->execute_direct("SELECT id FROM t");
+    ASSERT_TRUE(exec_res.has_value(), exec_res.error().to_string());
+    std::size_t inner_rows = 0;
+    while (outer->fetch().value_or(false)) {
+        auto inner = getThreadLocalStatement("MOCK_POOL_NESTED", connection);
+        auto inner_res = inner->execute_direct("SELECT id FROM t /*mock rows=1*/");
+        ASSERT_TRUE(inner_res.has_value(), inner_res.error().to_string());
+        while (inner->fetch().value_or(false)) ++inner_rows;
+    }
+    ASSERT_TRUE(inner_rows == 3, std::format("Nested queries read {} rows instead of 3.", inner_rows));
+
+    // Sharing one connection directly is refused by the driver, as a real one would.
+    odbc::Connection& primary = getThreadLocalConnection("MOCK_POOL_NESTED", connection);
+    odbc::Statement first(primary);
+    odbc::Statement second(primary);
+    ASSERT_TRUE(first.execute_direct("SELECT 1").has_value(), "First statement failed.");
+    auto busy = second.execute_direct("SELECT 1");
+    ASSERT_TRUE(!busy.has_value() && busy.error().sql_state == "HY000", "A second active statement was accepted.");
+
+    const auto snapshot = odbc::pool_telemetry();
+    const auto it = std::ranges::find_if(snapshot.pools, [](const odbc::PoolStats& s) { return s.alias == "MOCK_POOL_NESTED"; });
+    ASSERT_TRUE(it != snapshot.pools.end(), "The alias has no pool telemetry.");
+    ASSERT_TRUE(it->open == 2 && it->connects == 2, std::format("Expected two connections, saw {} open.", it->open));
+    return true;
+}
+
+[[nodiscard]] bool test_mock_execution_attribution() {
+    if constexpr (!odbc::DefaultInstrumentation::query_stats) {
+        return true;   // built with MODERN_ODBC_INSTRUMENTATION=0
+    }
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=5;Columns=bigint");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    std::mutex lines_mutex;
+    std::vector<std::string> lines;
+    odbc::AsyncLogger logger([&](std::string_view line) {
+        std::scoped_lock lock(lines_mutex);
+        lines.emplace_back(line);
+    });
+    odbc::Statement stmt(conn);
+    {
+        odbc::SlowQueryLog slow_log(logger);
+        slow_log.watch("", {.threshold = std::chrono::milliseconds(0), .plan_connection_string = {}, .plan_sample_every = 0});
+
+        // A result left half-read stays the running execution until the next statement starts.
+        auto select_res = stmt.execute_direct("SELECT attribution_select FROM t WHERE id = ?", {7LL});
+        ASSERT_TRUE(select_res.has_value(), select_res.error().to_string());
+        ASSERT_TRUE(stmt.fetch().value_or(false), "Expected a row.");
+        const auto burn_until = odbc::thread_cpu_time() + std::chrono::milliseconds(40);
+        while (odbc::thread_cpu_time() < burn_until) {}
+        auto update_res = stmt.execute_direct("UPDATE attribution_update SET x = ?", {8LL});
+        ASSERT_TRUE(update_res.has_value(), update_res.error().to_string());
+
+        // Rebinding a prepared statement likewise ends the execution that used the old values.
+        auto prepared = stmt.prepare("SELECT attribution_prepared FROM t WHERE id = ?");
+        ASSERT_TRUE(prepared.has_value(), prepared.error().to_string());
+        stmt.bind_parameter(1, 9LL);
+        auto first_res = stmt.execute();
+        ASSERT_TRUE(first_res.has_value(), first_res.error().to_string());
+        ASSERT_TRUE(stmt.fetch().value_or(false), "Expected a row.");
+        stmt.bind_parameter(1, 10LL);
+        auto second_res = stmt.execute();
+        ASSERT_TRUE(second_res.has_value(), second_res.error().to_string());
+        while (stmt.fetch().value_or(false)) {}
+    }
+    logger.flush();
+
+    auto cpu_ms = [](std::string_view shape) {
+        const auto entries = odbc::query_stats();
+        const auto it = std::ranges::find_if(entries, [&](const odbc::QueryStatsEntry& e) { return e.query.find(shape) != std::string::npos; });
+        return it != entries.end() ? std::chrono::duration<double, std::milli>(it->cpu_time).count() : -1.0;
+    };
+    const double select_ms = cpu_ms("attribution_select");
+    const double update_ms = cpu_ms("attribution_update");
+    ASSERT_TRUE(select_ms >= 30.0, std::format("The SELECT was charged {:.1f} ms of CPU instead of the time spent after it.", select_ms));
+    ASSERT_TRUE(update_ms >= 0.0 && update_ms < 30.0, std::format("The UPDATE was charged {:.1f} ms of CPU.", update_ms));
+
+    // Each slow-query record samples the parameters its own execution ran with.
+    auto logged = [&](std::string_view shape) {
+        std::vector<std::string> matching;
+        std::scoped_lock lock(lines_mutex);
+        for (const auto& line : lines) {
+            if (line.find(shape) != std::string::npos) matching.push_back(line);
+        }
+        return matching;
+    };
+    const auto selects = logged("attribution_select");
+    const auto executes = logged("attribution_prepared");
+    ASSERT_TRUE(selects.size() == 1 && selects[0].find("\"parameters\":[\"7\"]") != std::string::npos,
+                "The SELECT was logged with other parameters: " + (selects.empty() ? std::string() : selects[0]));
+    ASSERT_TRUE(executes.size() == 2 && executes[0].find("\"parameters\":[\"9\"]") != std::string::npos &&
+                    executes[1].find("\"parameters\":[\"10\"]") != std::string::npos,
+                std::format("The prepared executions were logged with other parameters ({} lines).", executes.size()));
+
+    // A statement without a result set is finished by its execute.
+    auto update_again = stmt.execute_direct("UPDATE attribution_update SET x = 1");
+    ASSERT_TRUE(update_again.has_value(), update_again.error().to_string());
+    const odbc::ExecutionUsage& usage = stmt.last_execution();
+    ASSERT_TRUE(usage.rows == 0 && usage.column_bytes.empty(), std::format("The UPDATE reported {} rows.", usage.rows));
+    return true;
+}
+
+[[nodiscard]] bool test_mock_executor_post_survives_any_exception() {
+    odbc::Executor executor(odbc::ExecutorOptions{.threads = 1});
+    // A job throwing something other than std::exception must not take the worker down.
+    executor.post("MOCK_POST", MOCK_CONNECTION, [](odbc::Connection&) -> int { throw 42; }, [](int) {});
+    std::latch done(1);
+    executor.post("MOCK_POST", MOCK_CONNECTION, [](odbc::Connection&) {}, [&] { done.count_down(); });
+    done.wait();
+    auto next = executor.submit([] { return 7; });
+    ASSERT_TRUE(next.get() == 7, "The worker did not run the job queued after the failed one.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_point_lookup_null_key() {
+    // Every key cell is either NULL or an empty string; the two keys must not share rows.
+    odbc::PointLookupBatcher batcher("MOCK_BATCHER", MOCK_CONNECTION + "Rows=40;Columns=varchar;StringLength=0;NullRate=0.5",
+                                     odbc::PointLookupOptions{.window = std::chrono::milliseconds(50)});
+    auto null_key = batcher.lookup("SELECT s FROM t WHERE s IN ({keys})", odbc::Parameter{});
+    auto empty_key = batcher.lookup("SELECT s FROM t WHERE s IN ({keys})", odbc::Parameter{std::string()});
+    auto null_rows = null_key.get();
+    auto empty_rows = empty_key.get();
+    ASSERT_TRUE(null_rows.has_value() && empty_rows.has_value(), "A lookup failed.");
+    ASSERT_TRUE(null_rows->row_count() > 0 && empty_rows->row_count() > 0, "Expected rows for both keys.");
+    ASSERT_TRUE(null_rows->row_count() + empty_rows->row_count() == 40,
+                std::format("NULL got {} rows and \"\" got {} of 40.", null_rows->row_count(), empty_rows->row_count()));
+    for (std::size_t row = 0; row < null_rows->row_count(); ++row) {
+        ASSERT_TRUE(null_rows->is_null(row, 0), "The NULL key received a non-NULL row.");
+    }
+    for (std::size_t row = 0; row < empty_rows->row_count(); ++row) {
+        ASSERT_TRUE(!empty_rows->is_null(row, 0), "The empty-string key received a NULL row.");
+    }
+    return true;
+}
+
+[[nodiscard]] bool test_mock_array_row_failure() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "FailParamSet=6");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+
+    // One bad row in the second array must fail the call even though SQLExecute only warns.
+    odbc::Statement stmt(conn);
+    auto prepared = stmt.prepare("INSERT INTO t (id) VALUES (?)");
+    ASSERT_TRUE(prepared.has_value(), prepared.error().to_string());
+    odbc::ParameterArray batch(1);
+    for (long long r = 0; r < 10; ++r) {
+        batch.add_row({r});
+    }
+    auto inserted = odbc::execute_array(stmt, batch, 4);
+    ASSERT_TRUE(!inserted.has_value(), "A failed row of a parameter array was reported as success.");
+    ASSERT_TRUE(inserted.error().sql_state == "23000" && inserted.error().message.find("Parameter row 6 ") != std::string::npos,
+                "Unexpected error: " + inserted.error().to_string());
+    return true;
+}
+
+[[nodiscard]] bool test_mock_fan_out_unknown_exception() {
+    // A task throwing something other than std::exception must still complete the fan-out.
+    odbc::Executor executor(odbc::ExecutorOptions{.threads = 2});
+    auto result = odbc::when_all(executor,
+        odbc::query("MOCK_FANOUT", MOCK_CONNECTION, "SELECT id FROM t"),
+        odbc::make_task("MOCK_FANOUT", MOCK_CONNECTION, [](odbc::Statement&) -> std::expected<long long, odbc::OdbcError> { throw 42; }));
+    ASSERT_TRUE(!result.has_value() && result.error().sql_state == "HY000", "The throwing task did not fail the fan-out.");
+    return true;
+}
+
+[[nodiscard]] bool test_mock_snapshot_concurrent_writers() {
+    odbc::Environment env;
+    odbc::Connection conn(env);
+    auto connect_res = conn.driver_connect(MOCK_CONNECTION + "Rows=200;Columns=bigint,varchar");
+    ASSERT_TRUE(connect_res.has_value(), "Connection failed: " + connect_res.error().to_string());
+    odbc::Statement stmt(conn);
+    ASSERT_TRUE(stmt.execute_direct("SELECT id, s FROM t").has_value(), "Query failed.");
+    auto rows = odbc::materialize(stmt);
+    ASSERT_TRUE(rows.has_value(), rows.error().to_string());
+
+    const auto directory = std::filesystem::temp_directory_path() / std::format("modern_odbc_snapshots_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto path = directory / "shared.snap";
+
+    // Writers of the same snapshot must not clobber each other's temporary file.
+    std::vector<std::future<bool>> writers;
+    for (int w = 0; w < 4; ++w) {
+        writers.push_back(std::async(std::launch::async, [&, w] {
+            bool ok = true;
+            for (int i = 0; i < 10; ++i) {
+                odbc::SnapshotWriter writer;
+                writer.add("t", std::format("writer-{}", w), *rows);
+                ok = writer.write(path).has_value() && ok;
+            }
+            return ok;
+        }));
+    }
+    bool all_written = true;
+    for (auto& writer : writers) all_written = writer.get() && all_written;
+    ASSERT_TRUE(all_written, "A concurrent snapshot write failed.");
+    auto snapshot = odbc::MappedSnapshot::open(path);
+    ASSERT_TRUE(snapshot.has_value(), snapshot.error().to_string());
+    const auto* entry = snapshot->find("t");
+    ASSERT_TRUE(entry && entry->data.row_count() == 200, "The snapshot does not hold a complete entry.");
+
+    // A rename that fails (the target is a directory) must not leave the temporary file behind.
+    std::filesystem::create_directories(directory / "blocked.snap" / "child");
+    odbc::SnapshotWriter writer;
+    writer.add("t", "v", *rows);
+    ASSERT_TRUE(!writer.write(directory / "blocked.snap").has_value(), "Replacing a directory should fail.");
+    std::size_t files = 0;
+    for (const auto& item : std::filesystem::directory_iterator(directory)) {
+        files += item.is_regular_file() ? 1 : 0;
+    }
+    std::filesystem::remove_all(directory);
+    ASSERT_TRUE(files == 1, std::format("Expected only the snapshot in the directory, found {} files.", files));
+    return true;
+}
+
+int main() {
+    using TestFunc = std::function<bool()>;
+    std::vector<std::pair<std::string, TestFunc>> tests_to_run = {
+        {"test_mock_result_shape", test_mock_result_shape},
+        {"test_mock_deterministic_data", test_mock_deterministic_data},
+        {"test_mock_null_rate", test_mock_null_rate},
+        {"test_mock_long_strings", test_mock_long_strings},
+        {"test_mock_latency_injection", test_mock_latency_injection},
+        {"test_mock_fault_injection", test_mock_fault_injection},
+        {"test_mock_block_cursor_and_arrays", test_mock_block_cursor_and_arrays},
+        {"test_mock_pool_secondary_connection", test_mock_pool_secondary_connection},
+        {"test_mock_execution_attribution", test_mock_execution_attribution},
+        {"test_mock_executor_post_survives_any_exception", test_mock_executor_post_survives_any_exception},
+        {"test_mock_point_lookup_null_key", test_mock_point_lookup_null_key},
+        {"test_mock_array_row_failure", test_mock_array_row_failure},
+        {"test_mock_fan_out_unknown_exception", test_mock_fan_out_unknown_exception},
+        {"test_mock_snapshot_concurrent_writers", test_mock_snapshot_concurrent_writers}
+    };
+
+    std::vector<std::future<bool>> results;
+    for (const auto& test : tests_to_run) {
+        std::cout << "[ RUN      ] " << test.first << std::endl;
+        results.push_back(std::async(std::launch::async, test.second));
+    }
+
+    int tests_passed = 0;
+    int tests_failed = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        try {
+            if (results[i].get()) {
+                std::cout << "[       OK ] " << tests_to_run[i].first << std::endl;
+                tests_passed++;
+            } else {
+                std::cout << "[  FAILED  ] " << tests_to_run[i].first << std::endl;
+                tests_failed++;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "[ EXCEPTION ] " << tests_to_run[i].first << " threw: " << e.what() << std::endl;
+            tests_failed++;
+        }
+    }
+
+    std::cout << "\n--- Test Summary ---" << std::endl;
+    std::cout << tests_passed << " tests passed." << std::endl;
+    std::cout << tests_failed << " tests failed." << std::endl;
+    std::cout << "--------------------" << std::endl;
+
+    return (tests_failed > 0) ? 1 : 0;
+}
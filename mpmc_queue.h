@@ -0,0 +1,129 @@
+#ifndef MODERN_ODBC_MPMC_QUEUE_H
+#define MODERN_ODBC_MPMC_QUEUE_H
+
+/**
+ * @file mpmc_queue.h
+ * @brief A bounded, lock-free multi-producer/multi-consumer queue.
+ *
+ * This is Dmitry Vyukov's array-based MPMC queue: each cell carries a sequence
+ * number that tells producers and consumers whether it is free or filled, so a
+ * push or pop is one CAS on the shared position plus one release store on the
+ * cell. The capacity is fixed at construction, which is what gives callers
+ * back-pressure instead of unbounded memory growth.
+ */
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace odbc {
+
+/**
+ * @class MpmcQueue
+ * @brief Bounded lock-free queue; try_push() fails when full, try_pop() when empty.
+ * @tparam T The element type. It must be nothrow move constructible.
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    /**
+     * @param capacity Maximum number of queued elements, rounded up to a power of two (minimum 2).
+     */
+    explicit MpmcQueue(std::size_t capacity)
+        : m_mask(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          m_cells(std::make_unique<Cell[]>(m_mask + 1)) {
+        for (std::size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue() {
+        while (try_pop()) {}
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    /**
+     * @brief Enqueues a value unless the queue is full.
+     * @return false if the queue was full; the value is left untouched in that case.
+     */
+    [[nodiscard]] bool try_push(T& value) noexcept {
+        Cell* cell = nullptr;
+        std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (cell->storage) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool try_push(T&& value) noexcept {
+        return try_push(value);
+    }
+
+    /**
+     * @brief Dequeues the oldest value, or returns std::nullopt if the queue is empty.
+     */
+    [[nodiscard]] std::optional<T> try_pop() noexcept {
+        Cell* cell = nullptr;
+        std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        T* slot = std::launder(reinterpret_cast<T*>(cell->storage));
+        std::optional<T> value(std::move(*slot));
+        slot->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return value;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_mask + 1; }
+
+    /**
+     * @brief Number of queued elements; only a snapshot while other threads are active.
+     */
+    [[nodiscard]] std::size_t size_approx() const noexcept {
+        std::size_t head = m_dequeue_pos.load(std::memory_order_relaxed);
+        std::size_t tail = m_enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    const std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<std::size_t> m_enqueue_pos{0};
+    alignas(64) std::atomic<std::size_t> m_dequeue_pos{0};
+};
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_MPMC_QUEUE_H
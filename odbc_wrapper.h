@@ -1,6 +1,8 @@
 #ifndef MODERN_ODBC_WRAPPER_H
 #define MODERN_ODBC_WRAPPER_H
 
+#include <algorithm>
+#include <cstddef>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -9,14 +11,33 @@
 #include <stdexcept>
 #include <utility>
 #include <format>
+#include <type_traits>
+#include <variant>
+
+#include "instrumentation.h"
 
 // Platform-specific ODBC includes
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX   // Windows.h would otherwise turn std::min and std::max into macros
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
 #include <Windows.h>
 #endif
 #include <sql.h>
 #include <sqlext.h>
 
+// SQL Server driver-specific connection attribute for Multiple Active Result Sets.
+// Defined in msodbcsql.h, which is not available with every driver manager.
+#ifndef SQL_COPT_SS_MARS_ENABLED
+#define SQL_COPT_SS_MARS_ENABLED 1224
+#endif
+#ifndef SQL_MARS_ENABLED_YES
+#define SQL_MARS_ENABLED_YES 1L
+#endif
+
 namespace odbc {
 
 // --- Error and Exception Classes ---
@@ -83,11 +104,33 @@ inline std::string OdbcError::to_string() const {
 }
 
 
+/**
+ * @brief A value bound to a parameter marker ('?'). std::monostate binds SQL NULL.
+ */
+using Parameter = std::variant<std::monostate, long long, double, std::string>;
+
+/**
+ * @struct ColumnDescription
+ * @brief Metadata of one result set column, as reported by SQLDescribeCol.
+ */
+struct ColumnDescription {
+    std::string name;
+    SQLSMALLINT data_type = SQL_UNKNOWN_TYPE;
+    SQLULEN column_size = 0;
+    SQLSMALLINT decimal_digits = 0;
+    bool nullable = true;
+};
+
+
 // --- RAII Wrapper Classes ---
 
 class Environment;
-class Connection;
-class Statement;
+template <typename Instrumentation> class BasicConnection;
+template <typename Instrumentation> class BasicStatement;
+
+// The wrappers used throughout the library; see instrumentation.h for the policy.
+using Connection = BasicConnection<DefaultInstrumentation>;
+using Statement = BasicStatement<DefaultInstrumentation>;
 
 /**
  * @class Environment
@@ -109,51 +152,194 @@ private:
 };
 
 /**
- * @class Connection
+ * @class BasicConnection
  * @brief RAII wrapper for an ODBC Connection Handle (HDBC).
+ * @tparam Instrumentation The instrumentation policy of driver_connect() (see instrumentation.h).
  */
-class Connection {
+template <typename Instrumentation>
+class BasicConnection {
 public:
-    explicit Connection(const Environment& env);
-    ~Connection() noexcept;
-    Connection(const Connection&) = delete;
-    Connection& operator=(const Connection&) = delete;
-    Connection(Connection&& other) noexcept;
-    Connection& operator=(Connection&& other) noexcept;
+    explicit BasicConnection(const Environment& env);
+    ~BasicConnection() noexcept;
+    BasicConnection(const BasicConnection&) = delete;
+    BasicConnection& operator=(const BasicConnection&) = delete;
+    BasicConnection(BasicConnection&& other) noexcept;
+    BasicConnection& operator=(BasicConnection&& other) noexcept;
 
     [[nodiscard]] SQLHDBC get() const;
 
     [[nodiscard]] std::expected<void, OdbcError> driver_connect(std::string_view connection_string);
     [[nodiscard]] std::expected<void, OdbcError> disconnect();
 
+    [[nodiscard]] std::expected<void, OdbcError> set_attribute(SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER length = 0);
+
+    /**
+     * @brief Requests Multiple Active Result Sets (SQL Server drivers only).
+     * Must be called before driver_connect(); other drivers reject the attribute.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> enable_mars();
+
+    /**
+     * @brief Reports whether several statements may have open cursors at the same time
+     * on this connection, either through MARS or because the driver has no limit on
+     * concurrent activities. Call after driver_connect().
+     */
+    [[nodiscard]] std::expected<bool, OdbcError> supports_multiple_active_statements();
+
+    /**
+     * @brief The product name of the server (SQL_DBMS_NAME), e.g. "Microsoft SQL Server" or "SQLite".
+     */
+    [[nodiscard]] std::expected<std::string, OdbcError> dbms_name();
+
+    /**
+     * @brief Switches autocommit on or off; with it off, work is ended by commit() or rollback().
+     */
+    [[nodiscard]] std::expected<void, OdbcError> set_autocommit(bool enabled);
+    [[nodiscard]] std::expected<void, OdbcError> commit();
+    [[nodiscard]] std::expected<void, OdbcError> rollback();
+
 private:
     SQLHDBC m_handle = nullptr;
+
+    [[nodiscard]] std::expected<void, OdbcError> end_transaction(SQLSMALLINT completion);
 };
 
 /**
- * @class Statement
+ * @class BasicStatement
  * @brief RAII wrapper for an ODBC Statement Handle (HSTMT).
+ * @tparam Instrumentation The instrumentation policy of prepare, execute, fetch and get_data (see instrumentation.h).
  */
-class Statement {
+template <typename Instrumentation>
+class BasicStatement {
 public:
-    explicit Statement(const Connection& conn);
-    ~Statement();
-    Statement(const Statement&) = delete;
-    Statement& operator=(const Statement&) = delete;
-    Statement(Statement&& other) noexcept;
-    Statement& operator=(Statement&& other) noexcept;
+    explicit BasicStatement(const BasicConnection<Instrumentation>& conn);
+    ~BasicStatement();
+    BasicStatement(const BasicStatement&) = delete;
+    BasicStatement& operator=(const BasicStatement&) = delete;
+    BasicStatement(BasicStatement&& other) noexcept;
+    BasicStatement& operator=(BasicStatement&& other) noexcept;
 
     [[nodiscard]] SQLHSTMT get() const;
 
     [[nodiscard]] std::expected<void, OdbcError> execute_direct(std::string_view query);
+    [[nodiscard]] std::expected<void, OdbcError> execute_direct(std::string_view query, std::vector<Parameter> parameters);
+
+    /**
+     * @brief Prepares a query with parameter markers for repeated execute() calls.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> prepare(std::string_view query);
+
+    /**
+     * @brief Sets the value of a parameter marker (1-based) for the next execute().
+     * The value is copied into the statement, so it need not outlive this call.
+     */
+    void bind_parameter(SQLUSMALLINT parameter_index, Parameter value);
+    void clear_parameters();
+    [[nodiscard]] const std::vector<Parameter>& parameters() const { return m_parameters; }
+
+    /**
+     * @brief Executes the prepared query with the currently bound parameters.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> execute();
+
+    /**
+     * @brief Closes an open cursor so the statement can be executed again.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> close_cursor();
+
     [[nodiscard]] std::expected<bool, OdbcError> fetch();
     [[nodiscard]] std::expected<SQLLEN, OdbcError> row_count();
+    [[nodiscard]] std::expected<SQLSMALLINT, OdbcError> num_result_cols();
+    [[nodiscard]] std::expected<ColumnDescription, OdbcError> describe_column(SQLUSMALLINT column_index);
     
     template <typename T>
     [[nodiscard]] std::expected<std::optional<T>, OdbcError> get_data(SQLUSMALLINT column_index);
 
+    /**
+     * @brief Attributes this statement's latency metrics to a series (see metrics.h).
+     * Pooled statements start with their alias and an empty statement name.
+     */
+    void set_metrics(const detail::StatementMetrics* metrics) noexcept { m_metrics = metrics; }
+
+    /**
+     * @brief Names the statement in its latency metrics, keeping the alias.
+     * Use a fixed name per query (e.g. "orders_by_customer"), not the SQL text.
+     */
+    void set_metrics_label(std::string_view statement);
+
+    /**
+     * @brief The wall time, CPU time, allocations and bytes per column of the last
+     * finished execution (see resource_usage.h). All zero with NullInstrumentation.
+     */
+    [[nodiscard]] const ExecutionUsage& last_execution() const noexcept { return m_execution.usage; }
+
 private:
     SQLHSTMT m_handle = nullptr;
+    std::vector<Parameter> m_parameters;
+    std::vector<SQLLEN> m_indicators;
+    bool m_awaiting_first_row = false;   // traces the first fetch after an execute as first_row
+    const detail::StatementMetrics* m_metrics = nullptr;
+    detail::StatementExecution m_execution;   // fingerprint entry and timing of the executed or prepared query
+
+    std::expected<void, OdbcError> bind_parameters();
+    std::expected<void, OdbcError> run_execute_direct(std::string_view query);
+    std::expected<void, OdbcError> run_execute();
+    std::expected<bool, OdbcError> fetch_row();
+
+    void begin_query(std::string_view query) {
+        if constexpr (Instrumentation::query_stats) {
+            m_execution.query = detail::query_stats_for(query);
+            if (detail::slow_log_installed()) {
+                m_execution.text.assign(query);
+            } else {
+                m_execution.text.clear();
+            }
+        }
+    }
+
+    void add_query_stat(std::atomic<std::uint64_t> detail::QueryStats::*counter, std::uint64_t amount) noexcept {
+        if constexpr (Instrumentation::query_stats) {
+            if (m_execution.query != nullptr) (m_execution.query->*counter).fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    void count_row() noexcept {
+        if constexpr (Instrumentation::query_stats) {
+            add_query_stat(&detail::QueryStats::rows, 1);
+            ++m_execution.rows;
+            if (detail::RequestCounters* request = detail::active_request) request->rows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void count_bytes(SQLUSMALLINT column_index, std::uint64_t bytes) noexcept {
+        if constexpr (Instrumentation::query_stats) {
+            add_query_stat(&detail::QueryStats::bytes, bytes);
+            if (m_execution.active && column_index > 0) {
+                try {
+                    if (m_execution.column_bytes.size() < column_index) m_execution.column_bytes.resize(column_index);
+                    m_execution.column_bytes[column_index - 1] += bytes;
+                } catch (...) {
+                    // Only the per-column breakdown loses the bytes.
+                }
+            }
+            if (detail::RequestCounters* request = detail::active_request) request->bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    void start_execution() noexcept;
+    void end_execute(const std::expected<void, OdbcError>& result) noexcept;
+    void finish_execution() noexcept;
+
+    void mark_executed() noexcept {
+        if constexpr (Instrumentation::enabled) m_awaiting_first_row = true;
+    }
+
+    TracePhase fetch_phase() noexcept {
+        if constexpr (Instrumentation::enabled) {
+            if (std::exchange(m_awaiting_first_row, false)) return TracePhase::first_row;
+        }
+        return TracePhase::fetch;
+    }
 };
 
 // --- Implementation ---
@@ -191,24 +377,28 @@ inline Environment& Environment::operator=(Environment&& other) noexcept {
 
 inline SQLHENV Environment::get() const { return m_handle; }
 
-// --- Connection Implementation ---
-inline Connection::Connection(const Environment& env) {
+// --- BasicConnection Implementation ---
+template <typename Instrumentation>
+inline BasicConnection<Instrumentation>::BasicConnection(const Environment& env) {
     if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_DBC, env.get(), &m_handle))) {
         throw OdbcSetupError("ODBC: Failed to allocate connection handle.");
     }
 }
 
-inline Connection::~Connection() noexcept {
+template <typename Instrumentation>
+inline BasicConnection<Instrumentation>::~BasicConnection() noexcept {
     if (m_handle != nullptr) {
         SQLDisconnect(m_handle);
         SQLFreeHandle(SQL_HANDLE_DBC, m_handle);
     }
 }
 
-inline Connection::Connection(Connection&& other) noexcept
+template <typename Instrumentation>
+inline BasicConnection<Instrumentation>::BasicConnection(BasicConnection&& other) noexcept
     : m_handle(std::exchange(other.m_handle, nullptr)) {}
 
-inline Connection& Connection::operator=(Connection&& other) noexcept {
+template <typename Instrumentation>
+inline BasicConnection<Instrumentation>& BasicConnection<Instrumentation>::operator=(BasicConnection&& other) noexcept {
     if (this != &other) {
         if (m_handle != nullptr) {
             SQLDisconnect(m_handle);
@@ -219,9 +409,12 @@ inline Connection& Connection::operator=(Connection&& other) noexcept {
     return *this;
 }
 
-inline SQLHDBC Connection::get() const { return m_handle; }
+template <typename Instrumentation>
+inline SQLHDBC BasicConnection<Instrumentation>::get() const { return m_handle; }
 
-inline std::expected<void, OdbcError> Connection::driver_connect(std::string_view connection_string) {
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::driver_connect(std::string_view connection_string) {
+    typename Instrumentation::Scope trace(TracePhase::connect, m_handle, nullptr, nullptr);
     std::vector<SQLCHAR> conn_str_buffer(connection_string.begin(), connection_string.end());
     conn_str_buffer.push_back('\0');
 
@@ -234,7 +427,8 @@ inline std::expected<void, OdbcError> Connection::driver_connect(std::string_vie
     return {};
 }
 
-inline std::expected<void, OdbcError> Connection::disconnect() {
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::disconnect() {
     if (SQLRETURN ret = SQLDisconnect(m_handle); !SQL_SUCCEEDED(ret)) {
         return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_DBC)
             .value_or(OdbcError{"HY000", 0, "Unknown disconnection error"}));
@@ -242,36 +436,158 @@ inline std::expected<void, OdbcError> Connection::disconnect() {
     return {};
 }
 
-// --- Statement Implementation ---
-inline Statement::Statement(const Connection& conn) {
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::set_attribute(SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER length) {
+    if (SQLRETURN ret = SQLSetConnectAttr(m_handle, attribute, value, length); !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_DBC)
+            .value_or(OdbcError{"HY000", 0, "Unknown error setting connection attribute"}));
+    }
+    return {};
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::enable_mars() {
+    return set_attribute(SQL_COPT_SS_MARS_ENABLED, reinterpret_cast<SQLPOINTER>(SQL_MARS_ENABLED_YES), SQL_IS_UINTEGER);
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::set_autocommit(bool enabled) {
+    return set_attribute(SQL_ATTR_AUTOCOMMIT, reinterpret_cast<SQLPOINTER>(enabled ? SQL_AUTOCOMMIT_ON : SQL_AUTOCOMMIT_OFF), SQL_IS_UINTEGER);
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::commit() { return end_transaction(SQL_COMMIT); }
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::rollback() { return end_transaction(SQL_ROLLBACK); }
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicConnection<Instrumentation>::end_transaction(SQLSMALLINT completion) {
+    if (SQLRETURN ret = SQLEndTran(SQL_HANDLE_DBC, m_handle, completion); !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_DBC)
+            .value_or(OdbcError{"HY000", 0, "Unknown error ending transaction"}));
+    }
+    return {};
+}
+
+template <typename Instrumentation>
+inline std::expected<bool, OdbcError> BasicConnection<Instrumentation>::supports_multiple_active_statements() {
+    // SQL Server drivers report MARS through their own attribute.
+    SQLUINTEGER mars = 0;
+    if (SQL_SUCCEEDED(SQLGetConnectAttr(m_handle, SQL_COPT_SS_MARS_ENABLED, &mars, SQL_IS_UINTEGER, nullptr))
+        && mars == static_cast<SQLUINTEGER>(SQL_MARS_ENABLED_YES)) {
+        return true;
+    }
+
+    // Otherwise rely on the generic limit; 0 means the driver imposes none.
+    SQLUSMALLINT max_activities = 0;
+    if (SQLRETURN ret = SQLGetInfo(m_handle, SQL_MAX_CONCURRENT_ACTIVITIES, &max_activities, sizeof(max_activities), nullptr);
+        !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_DBC)
+            .value_or(OdbcError{"HY000", 0, "Unknown error reading SQL_MAX_CONCURRENT_ACTIVITIES"}));
+    }
+    return max_activities != 1;
+}
+
+template <typename Instrumentation>
+inline std::expected<std::string, OdbcError> BasicConnection<Instrumentation>::dbms_name() {
+    std::vector<SQLCHAR> buffer(256);
+    SQLSMALLINT length = 0;
+    if (SQLRETURN ret = SQLGetInfo(m_handle, SQL_DBMS_NAME, buffer.data(), static_cast<SQLSMALLINT>(buffer.size()), &length);
+        !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_DBC)
+            .value_or(OdbcError{"HY000", 0, "Unknown error reading SQL_DBMS_NAME"}));
+    }
+    auto size = std::min<std::size_t>(static_cast<std::size_t>(std::max<SQLSMALLINT>(length, 0)), buffer.size() - 1);
+    return std::string(reinterpret_cast<const char*>(buffer.data()), size);
+}
+
+// --- BasicStatement Implementation ---
+namespace detail {
+    inline constexpr std::size_t slow_parameter_sample = 16;
+
+    // Renders a parameter as a SQL literal for logs; long strings are cut at 64 characters.
+    inline std::string parameter_literal(const Parameter& parameter) {
+        return std::visit([](const auto& value) -> std::string {
+            using V = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<V, std::monostate>) {
+                return "NULL";
+            } else if constexpr (std::is_same_v<V, std::string>) {
+                constexpr std::size_t max_length = 64;
+                std::string literal = "'";
+                for (char c : std::string_view(value).substr(0, max_length)) {
+                    literal += c;
+                    if (c == '\'') literal += c;
+                }
+                literal += value.size() > max_length ? "...'" : "'";
+                return literal;
+            } else {
+                return std::format("{}", value);
+            }
+        }, parameter);
+    }
+} // namespace detail
+
+template <typename Instrumentation>
+inline BasicStatement<Instrumentation>::BasicStatement(const BasicConnection<Instrumentation>& conn) {
     if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, conn.get(), &m_handle))) {
         throw OdbcSetupError("ODBC: Failed to allocate statement handle.");
     }
 }
 
-inline Statement::~Statement() {
+template <typename Instrumentation>
+inline BasicStatement<Instrumentation>::~BasicStatement() {
+    finish_execution();
     if (m_handle != nullptr) {
         SQLFreeHandle(SQL_HANDLE_STMT, m_handle);
     }
 }
 
-inline Statement::Statement(Statement&& other) noexcept
-    : m_handle(std::exchange(other.m_handle, nullptr)) {}
-
-inline Statement& Statement::operator=(Statement&& other) noexcept {
+template <typename Instrumentation>
+inline BasicStatement<Instrumentation>::BasicStatement(BasicStatement&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr)),
+      m_parameters(std::move(other.m_parameters)),
+      m_indicators(std::move(other.m_indicators)),
+      m_awaiting_first_row(other.m_awaiting_first_row),
+      m_metrics(other.m_metrics),
+      m_execution(std::exchange(other.m_execution, {})) {}
+
+template <typename Instrumentation>
+inline BasicStatement<Instrumentation>& BasicStatement<Instrumentation>::operator=(BasicStatement&& other) noexcept {
     if (this != &other) {
+        finish_execution();
         if (m_handle != nullptr) {
             SQLFreeHandle(SQL_HANDLE_STMT, m_handle);
         }
         m_handle = std::exchange(other.m_handle, nullptr);
+        m_parameters = std::move(other.m_parameters);
+        m_indicators = std::move(other.m_indicators);
+        m_awaiting_first_row = other.m_awaiting_first_row;
+        m_metrics = other.m_metrics;
+        m_execution = std::exchange(other.m_execution, {});
     }
     return *this;
 }
 
-inline SQLHSTMT Statement::get() const { return m_handle; }
+template <typename Instrumentation>
+inline SQLHSTMT BasicStatement<Instrumentation>::get() const { return m_handle; }
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::execute_direct(std::string_view query) {
+    // The previous execution is still charged to the previous query.
+    finish_execution();
+    begin_query(query);
+    start_execution();
+    auto result = run_execute_direct(query);
+    end_execute(result);
+    return result;
+}
 
-inline std::expected<void, OdbcError> Statement::execute_direct(std::string_view query) {
-    std::vector<SQLCHAR> query_buffer(query.begin(), query.end());
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::run_execute_direct(std::string_view query) {
+    typename Instrumentation::Scope trace(TracePhase::execute, m_handle, m_metrics, &m_execution);
+    mark_executed();
+    std::pmr::vector<SQLCHAR> query_buffer(query.begin(), query.end(), &counting_resource());
     if (SQLRETURN ret = SQLExecDirect(m_handle, query_buffer.data(), static_cast<SQLINTEGER>(query_buffer.size())); 
         !SQL_SUCCEEDED(ret)) {
         return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
@@ -280,7 +596,123 @@ inline std::expected<void, OdbcError> Statement::execute_direct(std::string_view
     return {};
 }
 
-inline std::expected<SQLLEN, OdbcError> Statement::row_count() {
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::execute_direct(std::string_view query, std::vector<Parameter> parameters) {
+    // A slow-query record of the previous execution samples the previous parameters.
+    finish_execution();
+    m_parameters = std::move(parameters);
+    if (auto bind_res = bind_parameters(); !bind_res) {
+        return bind_res;
+    }
+    return execute_direct(query);
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::prepare(std::string_view query) {
+    finish_execution();
+    begin_query(query);
+    typename Instrumentation::Scope trace(TracePhase::prepare, m_handle, m_metrics, &m_execution);
+    std::vector<SQLCHAR> query_buffer(query.begin(), query.end());
+    if (SQLRETURN ret = SQLPrepare(m_handle, query_buffer.data(), static_cast<SQLINTEGER>(query_buffer.size()));
+        !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown prepare error"}));
+    }
+    return {};
+}
+
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::bind_parameter(SQLUSMALLINT parameter_index, Parameter value) {
+    if (parameter_index == 0) {
+        return;
+    }
+    finish_execution();   // as in execute_direct(): the open execution keeps its parameters
+    if (m_parameters.size() < parameter_index) {
+        m_parameters.resize(parameter_index);
+    }
+    m_parameters[parameter_index - 1] = std::move(value);
+}
+
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::set_metrics_label(std::string_view statement) {
+    if constexpr (Instrumentation::enabled) {
+        m_metrics = MetricsRegistry::instance().statement_metrics(m_metrics != nullptr ? m_metrics->alias : std::string_view{}, statement);
+    }
+}
+
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::clear_parameters() {
+    finish_execution();
+    m_parameters.clear();
+    SQLFreeStmt(m_handle, SQL_RESET_PARAMS);
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::execute() {
+    start_execution();
+    auto result = run_execute();
+    end_execute(result);
+    return result;
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::run_execute() {
+    typename Instrumentation::Scope trace(TracePhase::execute, m_handle, m_metrics, &m_execution);
+    mark_executed();
+    if (auto bind_res = bind_parameters(); !bind_res) {
+        return bind_res;
+    }
+    if (SQLRETURN ret = SQLExecute(m_handle); !SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown execution error"}));
+    }
+    return {};
+}
+
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::close_cursor() {
+    finish_execution();
+    if (SQLRETURN ret = SQLFreeStmt(m_handle, SQL_CLOSE); !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown error closing cursor"}));
+    }
+    return {};
+}
+
+// Binds every stored parameter by address. The values live in m_parameters and
+// are not touched again until the next bind, so the pointers stay valid for the
+// duration of the execute call.
+template <typename Instrumentation>
+inline std::expected<void, OdbcError> BasicStatement<Instrumentation>::bind_parameters() {
+    m_indicators.assign(m_parameters.size(), 0);
+    for (std::size_t i = 0; i < m_parameters.size(); ++i) {
+        auto index = static_cast<SQLUSMALLINT>(i + 1);
+        SQLLEN& indicator = m_indicators[i];
+        SQLRETURN ret = std::visit([&](auto& value) -> SQLRETURN {
+            using V = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<V, std::monostate>) {
+                indicator = SQL_NULL_DATA;
+                return SQLBindParameter(m_handle, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 1, 0, nullptr, 0, &indicator);
+            } else if constexpr (std::is_same_v<V, long long>) {
+                return SQLBindParameter(m_handle, index, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT, 0, 0, &value, 0, &indicator);
+            } else if constexpr (std::is_same_v<V, double>) {
+                return SQLBindParameter(m_handle, index, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 0, 0, &value, 0, &indicator);
+            } else {
+                indicator = static_cast<SQLLEN>(value.size());
+                return SQLBindParameter(m_handle, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR,
+                                        std::max<SQLULEN>(1, value.size()), 0, value.data(), indicator, &indicator);
+            }
+        }, m_parameters[i]);
+        if (!SQL_SUCCEEDED(ret)) {
+            return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+                .value_or(OdbcError{"HY000", 0, "Unknown parameter binding error"}));
+        }
+    }
+    return {};
+}
+
+template <typename Instrumentation>
+inline std::expected<SQLLEN, OdbcError> BasicStatement<Instrumentation>::row_count() {
     SQLLEN count = 0;
     if (SQLRETURN ret = SQLRowCount(m_handle, &count); !SQL_SUCCEEDED(ret)) {
          return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
@@ -289,8 +721,144 @@ inline std::expected<SQLLEN, OdbcError> Statement::row_count() {
     return count;
 }
 
+template <typename Instrumentation>
+inline std::expected<SQLSMALLINT, OdbcError> BasicStatement<Instrumentation>::num_result_cols() {
+    SQLSMALLINT count = 0;
+    if (SQLRETURN ret = SQLNumResultCols(m_handle, &count); !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown error getting result column count"}));
+    }
+    return count;
+}
+
+template <typename Instrumentation>
+inline std::expected<ColumnDescription, OdbcError> BasicStatement<Instrumentation>::describe_column(SQLUSMALLINT column_index) {
+    std::vector<SQLCHAR> name_buffer(256);
+    SQLSMALLINT name_length = 0;
+    SQLSMALLINT nullable = SQL_NULLABLE;
+    ColumnDescription description;
+
+    if (SQLRETURN ret = SQLDescribeCol(m_handle, column_index, name_buffer.data(), static_cast<SQLSMALLINT>(name_buffer.size()),
+                                       &name_length, &description.data_type, &description.column_size,
+                                       &description.decimal_digits, &nullable);
+        !SQL_SUCCEEDED(ret)) {
+        return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT)
+            .value_or(OdbcError{"HY000", 0, "Unknown error describing column"}));
+    }
+    auto length = std::min<std::size_t>(static_cast<std::size_t>(std::max<SQLSMALLINT>(name_length, 0)), name_buffer.size() - 1);
+    description.name.assign(reinterpret_cast<const char*>(name_buffer.data()), length);
+    description.nullable = (nullable != SQL_NO_NULLS);
+    return description;
+}
+
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::start_execution() noexcept {
+    if constexpr (Instrumentation::query_stats) {
+        finish_execution();
+        m_execution.execute = m_execution.first_row = m_execution.fetch = std::chrono::nanoseconds::zero();
+        m_execution.rows = 0;
+        m_execution.failed = false;
+        m_execution.active = m_execution.query != nullptr;
+        m_execution.column_bytes.clear();
+        m_execution.accounted = m_execution.active && resource_accounting_enabled();
+        if (m_execution.accounted) {
+            const CountingMemoryResource& resource = counting_resource();
+            m_execution.allocations_start = resource.allocations();
+            m_execution.allocated_bytes_start = resource.allocated_bytes();
+            m_execution.cpu_start = thread_cpu_time();
+        }
+        if (detail::RequestCounters* request = detail::active_request) {
+            request->count_execution(m_execution.query);
+        }
+    }
+}
+
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::end_execute(const std::expected<void, OdbcError>& result) noexcept {
+    if constexpr (Instrumentation::query_stats) {
+        if (!m_execution.active) {
+            return;
+        }
+        if (!result) {
+            add_query_stat(&detail::QueryStats::errors, 1);
+            m_execution.failed = true;
+            finish_execution();
+        } else {
+            // Statements without a result set are never fetched, so they end here.
+            SQLSMALLINT columns = 0;
+            if (SQL_SUCCEEDED(SQLNumResultCols(m_handle, &columns)) && columns == 0) {
+                finish_execution();
+            }
+        }
+    }
+}
+
+// Records the resource use of the execution that just ended, and reports it to
+// the slow-query log if it was slow enough.
+template <typename Instrumentation>
+inline void BasicStatement<Instrumentation>::finish_execution() noexcept {
+    if constexpr (Instrumentation::query_stats) {
+        if (!std::exchange(m_execution.active, false)) {
+            return;
+        }
+        const auto total = m_execution.execute + m_execution.first_row + m_execution.fetch;
+        m_execution.query->add_execution(total);
+        ExecutionUsage& usage = m_execution.usage;
+        usage.wall_time = total;
+        usage.rows = m_execution.rows;
+        usage.column_bytes.swap(m_execution.column_bytes);
+        if (m_execution.accounted) {
+            const CountingMemoryResource& resource = counting_resource();
+            usage.cpu_time = thread_cpu_time() - m_execution.cpu_start;
+            usage.allocations = resource.allocations() - m_execution.allocations_start;
+            usage.allocated_bytes = resource.allocated_bytes() - m_execution.allocated_bytes_start;
+            add_query_stat(&detail::QueryStats::cpu_ns, static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, usage.cpu_time.count())));
+            add_query_stat(&detail::QueryStats::allocations, usage.allocations);
+            add_query_stat(&detail::QueryStats::allocated_bytes, usage.allocated_bytes);
+        } else {
+            usage.cpu_time = std::chrono::nanoseconds::zero();
+            usage.allocations = usage.allocated_bytes = 0;
+        }
 
-inline std::expected<bool, OdbcError> Statement::fetch() {
+        if (total.count() < detail::slow_threshold_floor_ns.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto* hook = detail::slow_statement_hook.load(std::memory_order_acquire);
+        if (hook == nullptr) {
+            return;
+        }
+        try {
+            SlowStatement slow{m_metrics != nullptr ? m_metrics->alias : std::string{}, m_execution.query->fingerprint,
+                               m_execution.query->query, m_execution.text, {}, m_execution.rows, m_execution.failed,
+                               m_execution.execute, m_execution.first_row, m_execution.fetch,
+                               usage.cpu_time, usage.allocations, usage.allocated_bytes, usage.column_bytes};
+            for (std::size_t i = 0; i < m_parameters.size() && i < detail::slow_parameter_sample; ++i) {
+                slow.parameters.push_back(detail::parameter_literal(m_parameters[i]));
+            }
+            hook(std::move(slow));
+        } catch (...) {
+            // Losing a slow-query record is preferable to failing the statement.
+        }
+    }
+}
+
+template <typename Instrumentation>
+inline std::expected<bool, OdbcError> BasicStatement<Instrumentation>::fetch() {
+    auto fetched = fetch_row();
+    if constexpr (Instrumentation::query_stats) {
+        if (fetched && *fetched) {
+            count_row();
+        } else {
+            m_execution.failed = m_execution.failed || !fetched;
+            finish_execution();   // the end of the result set ends the execution
+        }
+    }
+    return fetched;
+}
+
+template <typename Instrumentation>
+inline std::expected<bool, OdbcError> BasicStatement<Instrumentation>::fetch_row() {
+    typename Instrumentation::Scope trace(fetch_phase(), m_handle, m_metrics, &m_execution);
     if (SQLRETURN ret = SQLFetch(m_handle); ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
         return true;
     } else if (ret == SQL_NO_DATA) {
@@ -306,21 +874,24 @@ namespace detail {
     // Helper function to encapsulate the complex logic for retrieving string data.
     // This reduces the cognitive complexity of the main get_data function.
     inline std::expected<std::optional<std::string>, OdbcError> get_string_data(SQLHSTMT hstmt, SQLUSMALLINT column_index) {
-        std::vector<char> buffer(1024);
+        std::pmr::vector<char> buffer(1024, &counting_resource());
         SQLLEN indicator = 0;
         
         // First attempt to get the data
         if (SQLRETURN ret = SQLGetData(hstmt, column_index, SQL_C_CHAR, buffer.data(), buffer.size(), &indicator);
             ret == SQL_SUCCESS_WITH_INFO && indicator > static_cast<SQLLEN>(buffer.size() - 1)) 
         {
-            // Buffer was too small, resize and try again.
+            // Buffer was too small: keep what was read (minus the terminator) and fetch the remainder behind it,
+            // since a second SQLGetData call continues where the first one stopped.
+            const size_t head = buffer.size() - 1;
             buffer.resize(static_cast<size_t>(indicator) + 1);
-            if (SQLRETURN ret2 = SQLGetData(hstmt, column_index, SQL_C_CHAR, buffer.data(), buffer.size(), &indicator);
-                !SQL_SUCCEEDED(ret2)) 
+            if (SQLRETURN ret2 = SQLGetData(hstmt, column_index, SQL_C_CHAR, buffer.data() + head, static_cast<SQLLEN>(buffer.size() - head), &indicator);
+                !SQL_SUCCEEDED(ret2))
             {
                 // The second attempt failed.
                 return std::unexpected(get_diagnostic_record(hstmt, SQL_HANDLE_STMT).value_or(OdbcError{"HY000", 0, "Unknown GetData<string> error after resize"}));
             }
+            indicator += static_cast<SQLLEN>(head);
         } 
         else if (!SQL_SUCCEEDED(ret)) 
         {
@@ -343,18 +914,29 @@ namespace detail {
 } // namespace detail
 
 
+template <typename Instrumentation>
 template <typename T>
-inline std::expected<std::optional<T>, OdbcError> Statement::get_data(SQLUSMALLINT column_index) {
+inline std::expected<std::optional<T>, OdbcError> BasicStatement<Instrumentation>::get_data(SQLUSMALLINT column_index) {
+    typename Instrumentation::Scope trace(TracePhase::get_data, m_handle, m_metrics, &m_execution);
     // For strings, delegate to a helper function to reduce cognitive complexity here.
     if constexpr (std::is_same_v<T, std::string>) {
-        return detail::get_string_data(m_handle, column_index);
+        auto result = detail::get_string_data(m_handle, column_index);
+        if (result && result->has_value()) {
+            count_bytes(column_index, (*result)->size());
+        }
+        return result;
     }
     
     // Logic for non-string types.
     T value{};
     SQLLEN indicator = 0;
 
-    if constexpr (std::is_same_v<T, long>) {
+    if constexpr (std::is_same_v<T, long long>) {
+        if (SQLRETURN ret = SQLGetData(m_handle, column_index, SQL_C_SBIGINT, &value, sizeof(value), &indicator); 
+            !SQL_SUCCEEDED(ret)) {
+            return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT).value_or(OdbcError{"HY000", 0, "Unknown GetData<long long> error"}));
+        }
+    } else if constexpr (std::is_same_v<T, long>) {
         if (SQLRETURN ret = SQLGetData(m_handle, column_index, SQL_C_SLONG, &value, sizeof(value), &indicator); 
             !SQL_SUCCEEDED(ret)) {
             return std::unexpected(get_diagnostic_record(m_handle, SQL_HANDLE_STMT).value_or(OdbcError{"HY000", 0, "Unknown GetData<long> error"}));
@@ -370,6 +952,7 @@ inline std::expected<std::optional<T>, OdbcError> Statement::get_data(SQLUSMALLI
         return std::optional<T>(std::nullopt);
     }
 
+    count_bytes(column_index, indicator > 0 ? static_cast<std::uint64_t>(indicator) : sizeof(T));
     return std::optional<T>(value);
 }
 
@@ -0,0 +1,291 @@
+#ifndef MODERN_ODBC_POINT_LOOKUP_BATCHER_H
+#define MODERN_ODBC_POINT_LOOKUP_BATCHER_H
+
+/**
+ * @file point_lookup_batcher.h
+ * @brief Coalesces point lookups from many threads into IN-list queries.
+ *
+ * Callers submit a query template and one key and receive a future. A batcher
+ * thread collects the keys for each template until either the batching window
+ * has elapsed since the first key arrived or max_batch keys are waiting, then
+ * runs a single "WHERE key IN (?, ?, ...)" query and hands every caller the rows
+ * that match its key. Each lookup pays up to one window of extra latency; in
+ * exchange, N lookups cost one round trip instead of N.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "executor.h"
+#include "result_set.h"
+#include "sql_text.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct PointLookupOptions
+ * @brief Configuration for a PointLookupBatcher.
+ */
+struct PointLookupOptions {
+    std::chrono::microseconds window{300};   ///< Maximum time the first key of a batch waits.
+    std::size_t max_batch = 256;             ///< Keys per query; keep below the driver's parameter limit.
+    std::size_t key_column = 0;              ///< Zero-based result column that holds the key.
+    Executor* executor = nullptr;            ///< If set, batches run on this executor instead of the batcher thread.
+};
+
+/**
+ * @class PointLookupBatcher
+ * @brief Turns concurrent single-key lookups into batched IN-list queries for one alias.
+ */
+class PointLookupBatcher {
+public:
+    using Result = std::expected<ResultSet, OdbcError>;
+
+    PointLookupBatcher(std::string alias, std::string connection_string, PointLookupOptions options = {});
+
+    /**
+     * @brief Runs all pending batches and stops the batcher thread.
+     */
+    ~PointLookupBatcher();
+    PointLookupBatcher(const PointLookupBatcher&) = delete;
+    PointLookupBatcher& operator=(const PointLookupBatcher&) = delete;
+
+    /**
+     * @brief Queues a lookup of one key.
+     *
+     * @param query_template A query containing in_list_placeholder, e.g.
+     *        "SELECT id, name FROM customers WHERE id IN ({keys})".
+     * @param key The key value; matched by value and type against the key_column of
+     *        the result rows. A NULL key matches only rows whose key cell is NULL.
+     * @return A future with the rows for this key (possibly none), or the batch's error.
+     */
+    [[nodiscard]] std::future<Result> lookup(std::string query_template, Parameter key);
+
+private:
+    struct PendingLookup {
+        Parameter key;
+        std::promise<Result> promise;
+    };
+
+    struct Batch {
+        std::vector<PendingLookup> lookups;
+        std::chrono::steady_clock::time_point first_arrival;
+    };
+
+    std::string m_alias;
+    std::string m_connection_string;
+    PointLookupOptions m_options;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::map<std::string, Batch, std::less<>> m_batches;
+    bool m_stopping = false;
+    std::size_t m_batches_on_executor = 0;
+    std::condition_variable m_executor_idle;
+    std::jthread m_thread;
+
+    void run();
+    void execute_batch(const std::string& query_template, std::vector<PendingLookup> lookups) const;
+};
+
+
+// --- Implementation ---
+
+inline PointLookupBatcher::PointLookupBatcher(std::string alias, std::string connection_string, PointLookupOptions options)
+    : m_alias(std::move(alias)), m_connection_string(std::move(connection_string)), m_options(options) {
+    if (m_options.max_batch == 0) {
+        m_options.max_batch = 1;
+    }
+    m_thread = std::jthread([this] { run(); });
+}
+
+inline PointLookupBatcher::~PointLookupBatcher() {
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    m_thread.join();
+
+    // Batches handed to an executor still reference this object.
+    std::unique_lock lock(m_mutex);
+    m_executor_idle.wait(lock, [this] { return m_batches_on_executor == 0; });
+}
+
+inline std::future<PointLookupBatcher::Result> PointLookupBatcher::lookup(std::string query_template, Parameter key) {
+    std::promise<Result> promise;
+    auto future = promise.get_future();
+    if (!has_in_list_placeholder(query_template)) {
+        promise.set_value(std::unexpected(OdbcError{"42000", 0, std::format("Query template must contain '{}'.", in_list_placeholder)}));
+        return future;
+    }
+
+    bool wake = false;
+    {
+        std::scoped_lock lock(m_mutex);
+        auto [it, inserted] = m_batches.try_emplace(std::move(query_template));
+        Batch& batch = it->second;
+        if (batch.lookups.empty()) {
+            batch.first_arrival = std::chrono::steady_clock::now();
+            wake = true;   // the batcher needs a new deadline
+        }
+        batch.lookups.push_back(PendingLookup{std::move(key), std::move(promise)});
+        wake = wake || batch.lookups.size() >= m_options.max_batch;
+    }
+    if (wake) {
+        m_wakeup.notify_one();
+    }
+    return future;
+}
+
+inline void PointLookupBatcher::run() {
+    std::unique_lock lock(m_mutex);
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        auto next_deadline = std::chrono::steady_clock::time_point::max();
+        std::vector<std::pair<std::string, std::vector<PendingLookup>>> ready;
+
+        // A template's entry lives only while it has lookups waiting, so templates
+        // seen once do not pile up in m_batches.
+        for (auto it = m_batches.begin(); it != m_batches.end();) {
+            const auto deadline = it->second.first_arrival + m_options.window;
+            if (m_stopping || it->second.lookups.size() >= m_options.max_batch || deadline <= now) {
+                auto node = m_batches.extract(it++);
+                ready.emplace_back(std::move(node.key()), std::move(node.mapped().lookups));
+            } else {
+                next_deadline = std::min(next_deadline, deadline);
+                ++it;
+            }
+        }
+
+        if (!ready.empty()) {
+            lock.unlock();
+            for (auto& [query_template, lookups] : ready) {
+                // Split oversized batches that grew while the previous batch was running.
+                for (std::size_t offset = 0; offset < lookups.size(); offset += m_options.max_batch) {
+                    std::vector<PendingLookup> chunk;
+                    const std::size_t end = std::min(lookups.size(), offset + m_options.max_batch);
+                    for (std::size_t i = offset; i < end; ++i) chunk.push_back(std::move(lookups[i]));
+                    if (m_options.executor != nullptr) {
+                        {
+                            std::scoped_lock count_lock(m_mutex);
+                            ++m_batches_on_executor;
+                        }
+                        (void)m_options.executor->submit([this, query_template, chunk = std::move(chunk)]() mutable {
+                            execute_batch(query_template, std::move(chunk));
+                            std::scoped_lock count_lock(m_mutex);
+                            if (--m_batches_on_executor == 0) m_executor_idle.notify_all();
+                        });
+                    } else {
+                        execute_batch(query_template, std::move(chunk));
+                    }
+                }
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (m_stopping) {
+            return;
+        }
+        if (next_deadline == std::chrono::steady_clock::time_point::max()) {
+            m_wakeup.wait(lock);
+        } else {
+            m_wakeup.wait_until(lock, next_deadline);
+        }
+    }
+}
+
+inline void PointLookupBatcher::execute_batch(const std::string& query_template, std::vector<PendingLookup> lookups) const {
+    // The same key may have been requested by several callers; query it once.
+    // Keys are compared as Parameter values, so NULL, "" and 0 stay distinct.
+    struct KeyMatch {
+        std::vector<std::size_t> waiters;
+        std::vector<std::size_t> rows;
+    };
+    std::map<Parameter, KeyMatch> by_key;
+    std::vector<Parameter> parameters;
+    for (std::size_t i = 0; i < lookups.size(); ++i) {
+        auto [it, inserted] = by_key.try_emplace(lookups[i].key);
+        if (inserted) parameters.push_back(lookups[i].key);
+        it->second.waiters.push_back(i);
+    }
+
+    Result result = [&]() -> Result {
+        try {
+            auto stmt = getThreadLocalStatement(m_alias, m_connection_string);
+            if (auto exec_res = stmt->execute_direct(expand_in_list(query_template, parameters.size()), std::move(parameters)); !exec_res) {
+                return std::unexpected(exec_res.error());
+            }
+            return materialize(*stmt);
+        } catch (const std::exception& e) {
+            return std::unexpected(OdbcError{"08001", 0, e.what()});
+        }
+    }();
+
+    if (!result) {
+        for (auto& lookup : lookups) lookup.promise.set_value(std::unexpected(result.error()));
+        return;
+    }
+
+    // Group row indexes by key: a NULL cell matches the NULL key, any other cell is
+    // read as each non-null key type in the batch and matched by value.
+    if (m_options.key_column < result->column_count()) {
+        std::vector<Parameter> key_types;
+        for (const auto& [key, match] : by_key) {
+            if (key.index() != 0 && (key_types.empty() || key_types.back().index() != key.index())) {
+                key_types.push_back(key);   // the map orders keys by type first
+            }
+        }
+        for (std::size_t row = 0; row < result->row_count(); ++row) {
+            if (result->is_null(row, m_options.key_column)) {
+                if (auto it = by_key.find(Parameter{}); it != by_key.end()) it->second.rows.push_back(row);
+                continue;
+            }
+            for (const Parameter& type : key_types) {
+                auto cell = std::visit([&](const auto& like) -> std::optional<Parameter> {
+                    using K = std::decay_t<decltype(like)>;
+                    if constexpr (std::is_same_v<K, std::monostate>) {
+                        return std::nullopt;
+                    } else if (auto value = result->get<K>(row, m_options.key_column)) {
+                        return Parameter{std::move(*value)};
+                    } else {
+                        return std::nullopt;
+                    }
+                }, type);
+                if (!cell) continue;
+                if (auto it = by_key.find(*cell); it != by_key.end()) it->second.rows.push_back(row);
+            }
+        }
+    }
+    for (auto& [key, match] : by_key) {
+        ResultSetBuilder builder;
+        builder.add_columns_from(*result);
+        for (std::size_t row : match.rows) builder.append_row(*result, row);
+        ResultSet rows = builder.build();
+        for (std::size_t waiter : match.waiters) {
+            lookups[waiter].promise.set_value(rows);
+        }
+    }
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_POINT_LOOKUP_BATCHER_H
@@ -0,0 +1,299 @@
+#ifndef MODERN_ODBC_POOL_TELEMETRY_H
+#define MODERN_ODBC_POOL_TELEMETRY_H
+
+/**
+ * @file pool_telemetry.h
+ * @brief Checkout wait, hold time, connect latency and utilization of the connection pools.
+ *
+ * Both pools report, per alias:
+ *   - checkout wait: the time a caller spends in ShardedConnectionPool::acquire()
+ *     or ThreadLocalConnectionPool::getStatement(), including any connect;
+ *   - hold time: the lifetime of a PooledConnection lease or a PooledStatement;
+ *   - connect latency, split into first attempts and reconnects (attempts that
+ *     follow a failed connect of the same pool and alias);
+ *   - open and active connections; an idle connection is an open one with no
+ *     lease (sharded pool) or no live statement (thread-local pool).
+ *
+ * For the thread-local pool the counts are also broken down by owning thread,
+ * which shows how many connections a ThreadLocalConnectionPool really keeps open
+ * next to how many of them are busy at once: the evidence needed to size it
+ * against a shared ShardedConnectionPool.
+ *
+ * pool_telemetry() takes a snapshot; the distributions and counters are also
+ * rendered by render_prometheus() as the odbc_pool_* families. They are the
+ * only connect metrics: each attempt is timed once, and the per-alias view is
+ * a sum over the pool and attempt labels, e.g.
+ *   sum by (alias, le) (rate(odbc_pool_connect_duration_seconds_bucket[5m]))
+ * Like the other automatic metrics, recording stops while metrics_enabled() is
+ * false; open and active counts are always kept.
+ */
+
+#include "metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct PoolStats
+ * @brief The telemetry of one pool kind ("thread_local" or "sharded") for one alias.
+ */
+struct PoolStats {
+    std::string pool;
+    std::string alias;
+    std::uint64_t checkouts = 0;
+    std::uint64_t checkout_timeouts = 0;
+    std::uint64_t connects = 0;           ///< Successful connects, reconnects included.
+    std::uint64_t connect_failures = 0;
+    std::uint64_t reconnects = 0;         ///< Successful connects that followed a failed one.
+    std::int64_t open = 0;                ///< Connections open in live pools.
+    std::int64_t active = 0;              ///< Open connections currently leased or running a statement.
+    HistogramSnapshot checkout_wait;
+    HistogramSnapshot hold_time;
+    HistogramSnapshot connect_time;       ///< Connect attempts, failed ones included, except reconnects.
+    HistogramSnapshot reconnect_time;
+
+    [[nodiscard]] std::int64_t idle() const noexcept { return open - active; }
+};
+
+/**
+ * @struct ConnectionOwnership
+ * @brief The connections one thread's ThreadLocalConnectionPool holds for an alias.
+ */
+struct ConnectionOwnership {
+    std::string thread;   ///< std::this_thread::get_id() of the owner, as text.
+    std::string alias;
+    std::int64_t open = 0;
+    std::int64_t active = 0;
+};
+
+/**
+ * @struct PoolTelemetrySnapshot
+ * @brief The state of every pool alias seen by the process.
+ */
+struct PoolTelemetrySnapshot {
+    std::vector<PoolStats> pools;               ///< Sorted by pool kind, then alias.
+    std::vector<ConnectionOwnership> threads;   ///< Live thread-local pools only.
+
+    /**
+     * @brief A fixed-width table of the pools with p50/p99 latencies, then the per-thread ownership.
+     */
+    [[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * @brief Snapshots the telemetry of all pools.
+ */
+[[nodiscard]] PoolTelemetrySnapshot pool_telemetry();
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    /**
+     * @struct PoolSeries
+     * @brief The metric handles of one (pool kind, alias); entries are never freed.
+     */
+    struct PoolSeries {
+        std::string pool;
+        std::string alias;
+        Counter checkouts;
+        Counter checkout_timeouts;
+        Counter connects;
+        Counter connect_failures;
+        Counter reconnects;
+        Histogram checkout_wait;
+        Histogram hold_time;
+        Histogram connect_time;
+        Histogram reconnect_time;
+    };
+
+    /**
+     * @struct PoolUsage
+     * @brief Open and active counts of one live pool, or of one alias in one thread's pool.
+     *
+     * Counted with atomics rather than gauges so that a thread-local pool can
+     * still update them while its thread's metric shard is being torn down.
+     */
+    struct PoolUsage {
+        const PoolSeries* series = nullptr;
+        std::string thread;   // empty for shared pools
+        std::atomic<std::int64_t> open{0};
+        std::atomic<std::int64_t> active{0};
+        std::atomic<bool> connect_failed{false};   // the next attempt is a reconnect
+
+        void record_checkout(std::chrono::steady_clock::time_point started) const noexcept {
+            if (metrics_on.load(std::memory_order_relaxed)) {
+                series->checkouts.inc();
+                series->checkout_wait.record(std::chrono::steady_clock::now() - started);
+            }
+        }
+
+        void record_timeout() const noexcept {
+            if (metrics_on.load(std::memory_order_relaxed)) series->checkout_timeouts.inc();
+        }
+
+        void record_hold(std::chrono::steady_clock::time_point checked_out) const noexcept {
+            if (metrics_on.load(std::memory_order_relaxed)) {
+                series->hold_time.record(std::chrono::steady_clock::now() - checked_out);
+            }
+        }
+
+        void record_connect(std::chrono::steady_clock::time_point started, bool succeeded) noexcept {
+            const bool reconnect = connect_failed.exchange(!succeeded, std::memory_order_relaxed);
+            if (succeeded) open.fetch_add(1, std::memory_order_relaxed);
+            if (!metrics_on.load(std::memory_order_relaxed)) return;
+            (reconnect ? series->reconnect_time : series->connect_time).record(std::chrono::steady_clock::now() - started);
+            if (succeeded) {
+                series->connects.inc();
+                if (reconnect) series->reconnects.inc();
+            } else {
+                series->connect_failures.inc();
+            }
+        }
+    };
+
+    /**
+     * @class PoolTelemetryRegistry
+     * @brief The process-wide series and the live pools that report into them.
+     */
+    class PoolTelemetryRegistry {
+    public:
+        [[nodiscard]] static PoolTelemetryRegistry& instance() {
+            static PoolTelemetryRegistry registry;
+            return registry;
+        }
+
+        /**
+         * @brief Registers a pool; it reports until the returned pointer is released.
+         * @param thread The owning thread for thread-local pools, empty for shared ones.
+         */
+        [[nodiscard]] std::shared_ptr<PoolUsage> attach(std::string_view pool, std::string_view alias, std::string thread = {});
+
+        [[nodiscard]] PoolTelemetrySnapshot snapshot();
+
+    private:
+        std::mutex m_mutex;
+        std::map<std::pair<std::string, std::string>, std::unique_ptr<PoolSeries>, std::less<>> m_series;
+        std::vector<std::weak_ptr<PoolUsage>> m_usages;
+
+        PoolTelemetryRegistry() = default;
+    };
+
+    inline std::string current_thread_name() {
+        std::stringstream ss;
+        ss << std::this_thread::get_id();
+        return ss.str();
+    }
+
+    inline std::shared_ptr<PoolUsage> PoolTelemetryRegistry::attach(std::string_view pool, std::string_view alias, std::string thread) {
+        auto usage = std::make_shared<PoolUsage>();
+        usage->thread = std::move(thread);
+
+        std::scoped_lock lock(m_mutex);
+        auto key = std::pair{std::string(pool), std::string(alias)};
+        auto it = m_series.find(key);
+        if (it == m_series.end()) {
+            auto& metrics = MetricsRegistry::instance();
+            const MetricLabels labels{{"pool", key.first}, {"alias", key.second}};
+            const MetricLabels first{{"pool", key.first}, {"alias", key.second}, {"attempt", "first"}};
+            const MetricLabels retry{{"pool", key.first}, {"alias", key.second}, {"attempt", "reconnect"}};
+            auto series = std::make_unique<PoolSeries>(PoolSeries{
+                key.first, key.second,
+                metrics.counter("odbc_pool_checkouts_total", "Connections or statements checked out of a pool.", labels),
+                metrics.counter("odbc_pool_checkout_timeouts_total", "Checkouts that gave up waiting for a connection.", labels),
+                metrics.counter("odbc_pool_connects_total", "Connections opened by a pool.", labels),
+                metrics.counter("odbc_pool_connect_failures_total", "Failed connection attempts of a pool.", labels),
+                metrics.counter("odbc_pool_reconnects_total", "Connections opened after a failed attempt.", labels),
+                metrics.histogram("odbc_pool_checkout_wait_seconds", "Time spent waiting for a pooled connection.", labels),
+                metrics.histogram("odbc_pool_hold_seconds", "Time a pooled connection or statement was held.", labels),
+                metrics.histogram("odbc_pool_connect_duration_seconds", "Connect latency of a pool.", first),
+                metrics.histogram("odbc_pool_connect_duration_seconds", "Connect latency of a pool.", retry)});
+            it = m_series.emplace(std::move(key), std::move(series)).first;
+        }
+        usage->series = it->second.get();
+        std::erase_if(m_usages, [](const std::weak_ptr<PoolUsage>& weak) { return weak.expired(); });
+        m_usages.push_back(usage);
+        return usage;
+    }
+
+    inline PoolTelemetrySnapshot PoolTelemetryRegistry::snapshot() {
+        PoolTelemetrySnapshot snapshot;
+        std::vector<std::shared_ptr<PoolUsage>> usages;
+        std::vector<const PoolSeries*> series;
+        {
+            std::scoped_lock lock(m_mutex);
+            for (const auto& weak : m_usages) {
+                if (auto usage = weak.lock()) usages.push_back(std::move(usage));
+            }
+            for (const auto& [key, entry] : m_series) series.push_back(entry.get());
+        }
+
+        // Histogram snapshots take the metrics registry's lock; read them outside ours.
+        for (const PoolSeries* entry : series) {
+            PoolStats stats{entry->pool, entry->alias,
+                            entry->checkouts.value(), entry->checkout_timeouts.value(), entry->connects.value(),
+                            entry->connect_failures.value(), entry->reconnects.value(), 0, 0,
+                            entry->checkout_wait.snapshot(), entry->hold_time.snapshot(),
+                            entry->connect_time.snapshot(), entry->reconnect_time.snapshot()};
+            for (const auto& usage : usages) {
+                if (usage->series != entry) continue;
+                const auto open = usage->open.load(std::memory_order_relaxed);
+                const auto active = usage->active.load(std::memory_order_relaxed);
+                stats.open += open;
+                stats.active += active;
+                if (!usage->thread.empty()) {
+                    snapshot.threads.push_back(ConnectionOwnership{usage->thread, entry->alias, open, active});
+                }
+            }
+            snapshot.pools.push_back(std::move(stats));
+        }
+        std::ranges::sort(snapshot.threads, [](const ConnectionOwnership& a, const ConnectionOwnership& b) {
+            return std::tie(a.alias, a.thread) < std::tie(b.alias, b.thread);
+        });
+        return snapshot;
+    }
+
+} // namespace detail
+
+inline PoolTelemetrySnapshot pool_telemetry() { return detail::PoolTelemetryRegistry::instance().snapshot(); }
+
+inline std::string PoolTelemetrySnapshot::to_string() const {
+    auto ms = [](const HistogramSnapshot& histogram, double q) {
+        return std::chrono::duration<double, std::milli>(histogram.percentile(q)).count();
+    };
+    std::string out = std::format("{:<12} {:<20} {:>6} {:>6} {:>6} {:>10} {:>10} {:>10} {:>10} {:>10} {:>12} {:>8} {:>8}\n",
+                                  "pool", "alias", "open", "active", "idle", "checkouts", "wait_p50", "wait_p99",
+                                  "hold_p50", "hold_p99", "connect_p50", "failures", "timeouts");
+    for (const auto& p : pools) {
+        out += std::format("{:<12} {:<20} {:>6} {:>6} {:>6} {:>10} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>12.3f} {:>8} {:>8}\n",
+                           p.pool, p.alias, p.open, p.active, p.idle(), p.checkouts, ms(p.checkout_wait, 0.5),
+                           ms(p.checkout_wait, 0.99), ms(p.hold_time, 0.5), ms(p.hold_time, 0.99),
+                           ms(p.connect_time, 0.5), p.connect_failures, p.checkout_timeouts);
+    }
+    if (!threads.empty()) {
+        out += std::format("\n{:<20} {:<20} {:>6} {:>6}\n", "thread", "alias", "open", "active");
+        for (const auto& t : threads) {
+            out += std::format("{:<20} {:<20} {:>6} {:>6}\n", t.thread, t.alias, t.open, t.active);
+        }
+    }
+    return out;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_POOL_TELEMETRY_H
@@ -0,0 +1,461 @@
+#ifndef MODERN_ODBC_QUERY_STATS_H
+#define MODERN_ODBC_QUERY_STATS_H
+
+/**
+ * @file query_stats.h
+ * @brief Client-side statistics per query shape, in the style of pg_stat_statements.
+ *
+ * normalize_sql() reduces a query to its shape: literals become '?', IN-lists
+ * and multi-row VALUES lists collapse to "(...)", comments are dropped, and
+ * keywords and identifiers are lower-cased with canonical spacing. So
+ *   SELECT * FROM t WHERE id IN (1, 2, 3) AND name = 'x'
+ *   select *  from t where id in (4,5) and name='y' -- retry
+ * share one fingerprint, a 64-bit hash of the normalized text.
+ *
+ * With the default instrumentation policy every statement executed through
+ * execute_direct() or prepare()/execute() is attributed to its fingerprint:
+ * calls, total and maximum time (execute plus fetches), rows fetched, bytes
+ * read through get_data(), failed executions, and client CPU time and
+ * allocations (see resource_usage.h). The table is split into
+ * lock-striped shards; each statement caches its entry, so counting a row or
+ * a call is an atomic increment. query_stats() and dump_query_stats() read it
+ * on demand. The per-execution timing kept alongside feeds the slow-query log
+ * (see slow_query_log.h).
+ */
+
+#include "resource_usage.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @brief Reduces a query to its shape (see file comment).
+ */
+[[nodiscard]] std::string normalize_sql(std::string_view query);
+
+/**
+ * @brief The 64-bit FNV-1a hash of normalize_sql(query).
+ */
+[[nodiscard]] std::uint64_t sql_fingerprint(std::string_view query);
+
+/**
+ * @struct QueryStatsEntry
+ * @brief Aggregated statistics of one query shape.
+ */
+struct QueryStatsEntry {
+    std::uint64_t fingerprint = 0;
+    std::string query;                        ///< The normalized text.
+    std::uint64_t calls = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0;
+    std::chrono::nanoseconds total_time{0};
+    std::chrono::nanoseconds max_time{0};     ///< Longest execution: execute, first row and fetches.
+    std::chrono::nanoseconds cpu_time{0};     ///< Client thread CPU time of all executions (see resource_usage.h).
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+};
+
+/**
+ * @struct SlowStatement
+ * @brief One execution whose execute plus fetch time crossed a slow-query threshold (see slow_query_log.h).
+ */
+struct SlowStatement {
+    std::string alias;                       ///< The pool alias of the statement; empty for unpooled statements.
+    std::uint64_t fingerprint = 0;
+    std::string query;                       ///< The normalized text.
+    std::string text;                        ///< The text as executed, with its parameter markers.
+    std::vector<std::string> parameters;     ///< The first bound parameters, rendered as SQL literals.
+    std::uint64_t rows = 0;
+    bool failed = false;
+    std::chrono::nanoseconds execute{0};
+    std::chrono::nanoseconds first_row{0};
+    std::chrono::nanoseconds fetch{0};       ///< All fetches after the first row.
+    std::chrono::nanoseconds cpu_time{0};    ///< Client thread CPU time (see resource_usage.h).
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    std::vector<std::uint64_t> column_bytes;
+
+    [[nodiscard]] std::chrono::nanoseconds total() const noexcept { return execute + first_row + fetch; }
+};
+
+/**
+ * @brief Turns per-fingerprint statistics on or off for statements executed from now on (on by default).
+ */
+void set_query_stats_enabled(bool enabled) noexcept;
+[[nodiscard]] bool query_stats_enabled() noexcept;
+
+/**
+ * @brief All query shapes seen so far, most total time first.
+ */
+[[nodiscard]] std::vector<QueryStatsEntry> query_stats();
+
+/**
+ * @brief A text table of the top query shapes by total time.
+ */
+[[nodiscard]] std::string dump_query_stats(std::size_t limit = 20);
+
+/**
+ * @brief Zeroes every counter; the fingerprints stay registered.
+ */
+void reset_query_stats();
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    /**
+     * @struct QueryStats
+     * @brief The live counters of one fingerprint; entries are never freed.
+     */
+    struct QueryStats {
+        std::uint64_t fingerprint = 0;
+        std::string query;
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::atomic<std::uint64_t> rows{0};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> total_ns{0};
+        std::atomic<std::uint64_t> max_ns{0};
+        std::atomic<std::uint64_t> cpu_ns{0};
+        std::atomic<std::uint64_t> allocations{0};
+        std::atomic<std::uint64_t> allocated_bytes{0};
+
+        // Called per execute or fetch call.
+        void add_time(std::chrono::nanoseconds elapsed) noexcept {
+            total_ns.fetch_add(static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, elapsed.count())),
+                               std::memory_order_relaxed);
+        }
+
+        // Called once per execution, with its whole time.
+        void add_execution(std::chrono::nanoseconds elapsed) noexcept {
+            const auto ns = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, elapsed.count()));
+            for (auto max = max_ns.load(std::memory_order_relaxed);
+                 ns > max && !max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed);) {}
+        }
+    };
+
+    /**
+     * @struct StatementExecution
+     * @brief A statement's current query and the timing and resource use of its running execution.
+     */
+    struct StatementExecution {
+        QueryStats* query = nullptr;   // null while statistics are off
+        std::string text;              // kept only while a slow-query log is installed
+        std::chrono::nanoseconds execute{0};
+        std::chrono::nanoseconds first_row{0};
+        std::chrono::nanoseconds fetch{0};
+        std::uint64_t rows = 0;
+        bool active = false;           // between an execute and the end of its result set
+        bool failed = false;
+        bool accounted = false;        // CPU and allocation baselines were taken at the execute
+        std::chrono::nanoseconds cpu_start{0};
+        std::uint64_t allocations_start = 0;
+        std::uint64_t allocated_bytes_start = 0;
+        std::vector<std::uint64_t> column_bytes;
+        ExecutionUsage usage;          // of the last finished execution
+    };
+
+    alignas(64) inline std::atomic<bool> query_stats_on{true};
+
+    // The lowest threshold any slow-query log watches; executions faster than this are never reported.
+    inline std::atomic<std::int64_t> slow_threshold_floor_ns{std::numeric_limits<std::int64_t>::max()};
+    inline std::atomic<void (*)(SlowStatement&&)> slow_statement_hook{nullptr};
+
+    inline bool slow_log_installed() noexcept {
+        return slow_threshold_floor_ns.load(std::memory_order_relaxed) != std::numeric_limits<std::int64_t>::max();
+    }
+
+    /**
+     * @struct RequestCounters
+     * @brief What a RequestProfile has observed so far (see request_profile.h).
+     */
+    struct RequestCounters {
+        std::atomic<std::uint64_t> statements{0};
+        std::atomic<std::uint64_t> round_trips{0};
+        std::atomic<std::uint64_t> rows{0};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> db_ns{0};
+        std::mutex mutex;
+        std::unordered_map<const QueryStats*, std::uint64_t> executions;   // per fingerprint
+
+        void count_execution(const QueryStats* query) noexcept {
+            statements.fetch_add(1, std::memory_order_relaxed);
+            if (query == nullptr) {
+                return;
+            }
+            try {
+                std::scoped_lock lock(mutex);
+                ++executions[query];
+            } catch (...) {
+                // Only repeat detection loses the execution.
+            }
+        }
+    };
+
+    // The profile collecting this thread's database work, if any.
+    inline thread_local RequestCounters* active_request = nullptr;
+
+    inline bool is_word_char(char c) {
+        const auto u = static_cast<unsigned char>(c);
+        return std::isalnum(u) || c == '_' || c == '@' || c == '#' || c == '$' || c == ':' || c == '?' || u >= 0x80;
+    }
+
+    // Replaces "(?, ?, ...)" with "(...)", then repeated "(...), (...)" with one "(...)".
+    inline std::string collapse_lists(const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        for (std::size_t i = 0; i < text.size();) {
+            if (text.compare(i, 2, "(?") == 0) {
+                std::size_t j = i + 2;
+                while (text.compare(j, 3, ", ?") == 0) j += 3;
+                if (j < text.size() && text[j] == ')') {
+                    if (out.ends_with("(...), ")) {
+                        out.resize(out.size() - 2);   // another row of a multi-row VALUES list
+                    } else {
+                        out += "(...)";
+                    }
+                    i = j + 1;
+                    continue;
+                }
+            }
+            out += text[i++];
+        }
+        return out;
+    }
+
+    /**
+     * @class QueryStatsTable
+     * @brief Fingerprint entries in lock-striped shards.
+     */
+    class QueryStatsTable {
+    public:
+        static constexpr std::size_t shard_count = 16;
+
+        [[nodiscard]] static QueryStatsTable& instance() {
+            static QueryStatsTable table;
+            return table;
+        }
+
+        QueryStats* entry(std::string_view query) {
+            std::string normalized = normalize_sql(query);
+            const std::uint64_t fingerprint = sql_fingerprint_of_normalized(normalized);
+            Shard& shard = m_shards[fingerprint % shard_count];
+            std::scoped_lock lock(shard.mutex);
+            auto& slot = shard.entries[fingerprint];
+            if (!slot) {
+                slot = std::make_unique<QueryStats>();
+                slot->fingerprint = fingerprint;
+                slot->query = std::move(normalized);
+            }
+            return slot.get();
+        }
+
+        template <typename Function>
+        void for_each(Function&& function) {
+            for (auto& shard : m_shards) {
+                std::scoped_lock lock(shard.mutex);
+                for (auto& [fingerprint, stats] : shard.entries) function(*stats);
+            }
+        }
+
+        static std::uint64_t sql_fingerprint_of_normalized(std::string_view normalized) {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (char c : normalized) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+    private:
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::uint64_t, std::unique_ptr<QueryStats>> entries;
+        };
+        std::array<Shard, shard_count> m_shards;
+
+        QueryStatsTable() = default;
+    };
+
+    /**
+     * @brief The stats entry for a query's text, or nullptr while statistics are off.
+     *
+     * A small per-thread cache keyed by the exact text skips normalization for
+     * queries the thread has run before.
+     */
+    inline QueryStats* query_stats_for(std::string_view query) {
+        if (!query_stats_on.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        struct TextHash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view text) const noexcept { return std::hash<std::string_view>{}(text); }
+        };
+        thread_local std::unordered_map<std::string, QueryStats*, TextHash, std::equal_to<>> cache;
+        if (auto it = cache.find(query); it != cache.end()) {
+            return it->second;
+        }
+        if (cache.size() >= 1024) {
+            cache.clear();   // bounded: ad-hoc texts with inlined literals would otherwise accumulate
+        }
+        QueryStats* stats = QueryStatsTable::instance().entry(query);
+        cache.emplace(std::string(query), stats);
+        return stats;
+    }
+
+} // namespace detail
+
+inline std::string normalize_sql(std::string_view query) {
+    std::string out;
+    out.reserve(query.size());
+    // Tokens are separated by one space whatever the original layout was, except
+    // after '(' and '.' and before ')', ',' and '.': "select a.id, count (*) from t".
+    auto emit = [&](std::string_view token) {
+        if (!out.empty() && out.back() != '(' && out.back() != '.' && token.front() != ')' && token.front() != ',' &&
+            token.front() != '.') {
+            out += ' ';
+        }
+        out += token;
+    };
+    auto is_operator_char = [](char c) { return c == '<' || c == '>' || c == '=' || c == '!' || c == '|'; };
+
+    const std::size_t n = query.size();
+    for (std::size_t i = 0; i < n;) {
+        const char c = query[i];
+        const auto u = static_cast<unsigned char>(c);
+        if (std::isspace(u)) {
+            ++i;
+        } else if (c == '-' && i + 1 < n && query[i + 1] == '-') {
+            while (i < n && query[i] != '\n') ++i;
+        } else if (c == '/' && i + 1 < n && query[i + 1] == '*') {
+            const auto end = query.find("*/", i + 2);
+            i = end == std::string_view::npos ? n : end + 2;
+        } else if (c == '\'') {
+            // String literal; '' is an escaped quote.
+            ++i;
+            while (i < n) {
+                if (query[i] == '\'') {
+                    if (i + 1 < n && query[i + 1] == '\'') { i += 2; continue; }
+                    ++i;
+                    break;
+                }
+                ++i;
+            }
+            emit("?");
+        } else if (c == '"' || c == '[' || c == '`') {
+            // Quoted identifier: kept as written.
+            const char close = c == '[' ? ']' : c;
+            const auto end = query.find(close, i + 1);
+            const std::size_t stop = end == std::string_view::npos ? n : end + 1;
+            emit(query.substr(i, stop - i));
+            i = stop;
+        } else if (std::isdigit(u) || (c == '.' && i + 1 < n && std::isdigit(static_cast<unsigned char>(query[i + 1])))) {
+            // Numeric literal, including 1.5e-3 and 0x1F.
+            ++i;
+            while (i < n) {
+                const char d = query[i];
+                if (std::isalnum(static_cast<unsigned char>(d)) || d == '.') {
+                    ++i;
+                } else if ((d == '+' || d == '-') && (query[i - 1] == 'e' || query[i - 1] == 'E') && !query.substr(0, i).ends_with("0x")) {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            emit("?");
+        } else if (detail::is_word_char(c)) {
+            std::string word;
+            while (i < n && detail::is_word_char(query[i])) {
+                word += static_cast<char>(std::tolower(static_cast<unsigned char>(query[i])));
+                ++i;
+            }
+            // N'...', E'...', X'...' and B'...' are prefixed literals.
+            if (word.size() == 1 && i < n && query[i] == '\'' && std::string_view("nexb").find(word[0]) != std::string_view::npos) {
+                continue;   // the literal itself is handled next and emitted as '?'
+            }
+            emit(word);
+        } else if (is_operator_char(c)) {
+            // Multi-character operators (<=, <>, !=, ||) stay one token.
+            const std::size_t start = i;
+            while (i < n && is_operator_char(query[i])) ++i;
+            emit(query.substr(start, i - start));
+        } else {
+            emit(query.substr(i, 1));
+            ++i;
+        }
+    }
+    return detail::collapse_lists(out);
+}
+
+inline std::uint64_t sql_fingerprint(std::string_view query) {
+    return detail::QueryStatsTable::sql_fingerprint_of_normalized(normalize_sql(query));
+}
+
+inline void set_query_stats_enabled(bool enabled) noexcept { detail::query_stats_on.store(enabled, std::memory_order_relaxed); }
+
+inline bool query_stats_enabled() noexcept { return detail::query_stats_on.load(std::memory_order_relaxed); }
+
+inline std::vector<QueryStatsEntry> query_stats() {
+    std::vector<QueryStatsEntry> entries;
+    detail::QueryStatsTable::instance().for_each([&](const detail::QueryStats& stats) {
+        entries.push_back(QueryStatsEntry{stats.fingerprint, stats.query,
+                                          stats.calls.load(std::memory_order_relaxed), stats.errors.load(std::memory_order_relaxed),
+                                          stats.rows.load(std::memory_order_relaxed), stats.bytes.load(std::memory_order_relaxed),
+                                          std::chrono::nanoseconds(stats.total_ns.load(std::memory_order_relaxed)),
+                                          std::chrono::nanoseconds(stats.max_ns.load(std::memory_order_relaxed)),
+                                          std::chrono::nanoseconds(stats.cpu_ns.load(std::memory_order_relaxed)),
+                                          stats.allocations.load(std::memory_order_relaxed),
+                                          stats.allocated_bytes.load(std::memory_order_relaxed)});
+    });
+    std::ranges::sort(entries, std::greater<>{}, &QueryStatsEntry::total_time);
+    return entries;
+}
+
+inline std::string dump_query_stats(std::size_t limit) {
+    std::string out = std::format("{:<16} {:>10} {:>12} {:>10} {:>10} {:>12} {:>12} {:>14} {:>8}  {}\n",
+                                  "fingerprint", "calls", "total_ms", "mean_ms", "max_ms", "cpu_ms", "rows", "bytes", "errors", "query");
+    const auto entries = query_stats();
+    for (std::size_t i = 0; i < entries.size() && i < limit; ++i) {
+        const auto& e = entries[i];
+        const double total_ms = std::chrono::duration<double, std::milli>(e.total_time).count();
+        out += std::format("{:016x} {:>10} {:>12.3f} {:>10.3f} {:>10.3f} {:>12.3f} {:>12} {:>14} {:>8}  {}\n", e.fingerprint, e.calls, total_ms,
+                           e.calls > 0 ? total_ms / static_cast<double>(e.calls) : 0.0,
+                           std::chrono::duration<double, std::milli>(e.max_time).count(),
+                           std::chrono::duration<double, std::milli>(e.cpu_time).count(), e.rows, e.bytes, e.errors, e.query);
+    }
+    return out;
+}
+
+inline void reset_query_stats() {
+    detail::QueryStatsTable::instance().for_each([](detail::QueryStats& stats) {
+        stats.calls.store(0, std::memory_order_relaxed);
+        stats.errors.store(0, std::memory_order_relaxed);
+        stats.rows.store(0, std::memory_order_relaxed);
+        stats.bytes.store(0, std::memory_order_relaxed);
+        stats.total_ns.store(0, std::memory_order_relaxed);
+        stats.max_ns.store(0, std::memory_order_relaxed);
+        stats.cpu_ns.store(0, std::memory_order_relaxed);
+        stats.allocations.store(0, std::memory_order_relaxed);
+        stats.allocated_bytes.store(0, std::memory_order_relaxed);
+    });
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_QUERY_STATS_H
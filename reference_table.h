@@ -0,0 +1,328 @@
+#ifndef MODERN_ODBC_REFERENCE_TABLE_H
+#define MODERN_ODBC_REFERENCE_TABLE_H
+
+/**
+ * @file reference_table.h
+ * @brief In-memory copies of small, rarely changing lookup tables.
+ *
+ * A ReferenceTable loads a whole table (currencies, product codes, permissions)
+ * into a columnar ResultSet and builds hash indexes over chosen columns, so that
+ * lookups are memory probes instead of database round trips.
+ *
+ * Each load produces an immutable Snapshot. A background thread reloads the table
+ * periodically; if a version query is configured (e.g. MAX(rowversion) or a
+ * change counter) the table is only reloaded when that version changes. New
+ * snapshots are published read-copy-update style through an atomic shared_ptr:
+ * readers never block, and a reader holding the previous snapshot keeps a
+ * consistent view until it lets go of it.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "result_set.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct ReferenceTableOptions
+ * @brief Configuration for a ReferenceTable.
+ */
+struct ReferenceTableOptions {
+    std::string load_query;                           ///< Selects every row, e.g. "SELECT code, name, rate FROM currencies".
+    std::vector<std::string> index_columns;           ///< Columns to index; the first one is the primary key.
+    std::string version_query;                        ///< Optional single-value query; the table reloads only when its result changes.
+    std::chrono::milliseconds refresh_interval{60000}; ///< Zero disables the background thread.
+    std::optional<ResultSet> initial_data;            ///< Served until the first refresh, e.g. from a MappedSnapshot.
+    std::string initial_version;                      ///< Version of initial_data; an unchanged version skips the first reload.
+};
+
+/**
+ * @class ReferenceTable
+ * @brief A periodically refreshed, hash-indexed in-memory copy of a lookup table.
+ *
+ * @tparam Row The type returned by lookups, built from one ResultSet row by the row mapper.
+ * @tparam Key The index key type; must be hashable and readable with ResultSet::get<Key>.
+ *         std::string_view keys point into the snapshot and avoid copying text keys.
+ */
+template <typename Row, typename Key>
+class ReferenceTable {
+public:
+    using RowMapper = std::function<Row(const ResultSet&, std::size_t)>;
+
+    /**
+     * @class Snapshot
+     * @brief One immutable version of the table and its indexes.
+     */
+    class Snapshot {
+    public:
+        /**
+         * @brief Looks a key up in the primary (first) index.
+         */
+        [[nodiscard]] std::optional<Row> find(const Key& key) const {
+            const auto rows = row_indexes(0, key);
+            if (rows.empty()) return std::nullopt;
+            return m_mapper(m_data, rows.front());
+        }
+
+        /**
+         * @brief Returns every row whose indexed column equals the key.
+         * @param index Position of the column in ReferenceTableOptions::index_columns.
+         */
+        [[nodiscard]] std::vector<Row> find_all(std::size_t index, const Key& key) const {
+            std::vector<Row> rows;
+            for (std::uint32_t row : row_indexes(index, key)) rows.push_back(m_mapper(m_data, row));
+            return rows;
+        }
+
+        [[nodiscard]] bool contains(const Key& key) const { return !row_indexes(0, key).empty(); }
+        [[nodiscard]] const ResultSet& data() const noexcept { return m_data; }
+        [[nodiscard]] std::size_t row_count() const noexcept { return m_data.row_count(); }
+        [[nodiscard]] const std::string& version() const noexcept { return m_version; }
+        [[nodiscard]] std::chrono::system_clock::time_point loaded_at() const noexcept { return m_loaded_at; }
+
+    private:
+        friend class ReferenceTable;
+
+        ResultSet m_data;
+        std::string m_version;
+        std::chrono::system_clock::time_point m_loaded_at;
+        RowMapper m_mapper;
+        std::vector<std::unordered_map<Key, std::vector<std::uint32_t>>> m_indexes;
+
+        std::span<const std::uint32_t> row_indexes(std::size_t index, const Key& key) const {
+            if (index >= m_indexes.size()) return {};
+            auto it = m_indexes[index].find(key);
+            if (it == m_indexes[index].end()) return {};
+            return it->second;
+        }
+    };
+
+    /**
+     * @brief Creates the table and, if refresh_interval is non-zero, starts the refresh thread.
+     *
+     * The first load happens on the refresh thread; call refresh() to load synchronously.
+     * If options.initial_data is set, it is published first so lookups work immediately.
+     *
+     * @param alias A unique string to identify the connection (e.g., "DB_PRIMARY").
+     * @param connection_string The full ODBC connection string.
+     * @param options The queries, indexed columns and refresh interval.
+     * @param mapper Builds a Row from a row of the loaded ResultSet.
+     */
+    ReferenceTable(std::string alias, std::string connection_string, ReferenceTableOptions options, RowMapper mapper);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    ~ReferenceTable();
+    ReferenceTable(const ReferenceTable&) = delete;
+    ReferenceTable& operator=(const ReferenceTable&) = delete;
+
+    /**
+     * @brief The current snapshot, or nullptr before the first load. Hold it for consistent multi-key reads.
+     */
+    [[nodiscard]] std::shared_ptr<const Snapshot> snapshot() const {
+        return m_snapshot.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Looks a key up in the primary index of the current snapshot.
+     */
+    [[nodiscard]] std::optional<Row> find(const Key& key) const {
+        auto current = snapshot();
+        return current ? current->find(key) : std::nullopt;
+    }
+
+    /**
+     * @brief Returns every row of the current snapshot whose indexed column equals the key.
+     */
+    [[nodiscard]] std::vector<Row> find_all(std::size_t index, const Key& key) const {
+        auto current = snapshot();
+        return current ? current->find_all(index, key) : std::vector<Row>{};
+    }
+
+    /**
+     * @brief Checks the version and reloads the table if it changed (or if there is no version query).
+     * @return true if a new snapshot was published, false if the version was unchanged.
+     */
+    [[nodiscard]] std::expected<bool, OdbcError> refresh();
+
+    /**
+     * @brief Publishes already loaded data, e.g. from a warm-start snapshot file.
+     * @return An error if an index column is missing from the data.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> publish(ResultSet data, std::string version);
+
+    /**
+     * @brief Wakes the refresh thread to refresh now instead of at the next interval.
+     */
+    void request_refresh() {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_refresh_requested = true;
+        }
+        m_wakeup.notify_all();
+    }
+
+    [[nodiscard]] std::uint64_t reload_count() const noexcept { return m_reloads.load(std::memory_order_relaxed); }
+
+private:
+    std::string m_alias;
+    std::string m_connection_string;
+    ReferenceTableOptions m_options;
+    RowMapper m_mapper;
+    std::atomic<std::shared_ptr<const Snapshot>> m_snapshot;
+    std::atomic<std::uint64_t> m_reloads{0};
+
+    std::mutex m_refresh_mutex;   // serializes refresh() calls
+    std::mutex m_mutex;
+    std::condition_variable_any m_wakeup;
+    bool m_refresh_requested = false;
+    std::jthread m_thread;
+
+    void run(std::stop_token stop);
+    std::expected<std::optional<std::string>, OdbcError> query_version();
+};
+
+
+// --- Implementation ---
+
+template <typename Row, typename Key>
+inline ReferenceTable<Row, Key>::ReferenceTable(std::string alias, std::string connection_string,
+                                                ReferenceTableOptions options, RowMapper mapper)
+    : m_alias(std::move(alias)), m_connection_string(std::move(connection_string)),
+      m_options(std::move(options)), m_mapper(std::move(mapper)) {
+    if (m_options.index_columns.empty()) {
+        throw OdbcSetupError("ReferenceTable needs at least one index column.");
+    }
+    if (m_options.initial_data) {
+        // A stale or incompatible warm-start snapshot must not prevent startup.
+        if (auto published = publish(*std::exchange(m_options.initial_data, std::nullopt), m_options.initial_version); !published) {
+            std::cerr << std::format("[ReferenceTable] Ignoring initial data for '{}': {}\n", m_alias, published.error().to_string());
+        }
+    }
+    if (m_options.refresh_interval.count() > 0) {
+        m_thread = std::jthread([this](std::stop_token stop) { run(std::move(stop)); });
+    }
+}
+
+template <typename Row, typename Key>
+inline ReferenceTable<Row, Key>::~ReferenceTable() {
+    if (m_thread.joinable()) {
+        m_thread.request_stop();
+        m_wakeup.notify_all();
+        m_thread.join();
+    }
+}
+
+template <typename Row, typename Key>
+inline std::expected<std::optional<std::string>, OdbcError> ReferenceTable<Row, Key>::query_version() {
+    if (m_options.version_query.empty()) {
+        return std::optional<std::string>{};
+    }
+    auto stmt = getThreadLocalStatement(m_alias, m_connection_string);
+    if (auto exec_res = stmt->execute_direct(m_options.version_query); !exec_res) {
+        return std::unexpected(exec_res.error());
+    }
+    auto result = materialize(*stmt, 1);
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    // An empty table has no version; treat it as the empty string so it can still match.
+    if (result->empty() || result->column_count() == 0) {
+        return std::optional<std::string>{std::string{}};
+    }
+    return std::optional<std::string>{result->get<std::string>(0, 0).value_or(std::string{})};
+}
+
+template <typename Row, typename Key>
+inline std::expected<bool, OdbcError> ReferenceTable<Row, Key>::refresh() {
+    std::scoped_lock lock(m_refresh_mutex);
+    try {
+        auto version = query_version();
+        if (!version) {
+            return std::unexpected(version.error());
+        }
+        auto current = snapshot();
+        if (*version && current && current->version() == **version) {
+            return false;
+        }
+
+        auto stmt = getThreadLocalStatement(m_alias, m_connection_string);
+        if (auto exec_res = stmt->execute_direct(m_options.load_query); !exec_res) {
+            return std::unexpected(exec_res.error());
+        }
+        auto data = materialize(*stmt);
+        if (!data) {
+            return std::unexpected(data.error());
+        }
+        if (auto published = publish(std::move(*data), version->value_or(std::string{})); !published) {
+            return std::unexpected(published.error());
+        }
+        return true;
+    } catch (const std::exception& e) {
+        return std::unexpected(OdbcError{"08001", 0, e.what()});
+    }
+}
+
+template <typename Row, typename Key>
+inline std::expected<void, OdbcError> ReferenceTable<Row, Key>::publish(ResultSet data, std::string version) {
+    auto next = std::make_shared<Snapshot>();
+    next->m_indexes.resize(m_options.index_columns.size());
+    for (std::size_t i = 0; i < m_options.index_columns.size(); ++i) {
+        auto column = data.find_column(m_options.index_columns[i]);
+        if (!column) {
+            return std::unexpected(OdbcError{"42S22", 0, std::format("Index column '{}' is not in the result.", m_options.index_columns[i])});
+        }
+        auto& index = next->m_indexes[i];
+        index.reserve(data.row_count());
+        for (std::size_t row = 0; row < data.row_count(); ++row) {
+            if (auto key = data.get<Key>(row, *column)) {
+                index[*key].push_back(static_cast<std::uint32_t>(row));
+            }
+        }
+    }
+    next->m_data = std::move(data);
+    next->m_version = std::move(version);
+    next->m_loaded_at = std::chrono::system_clock::now();
+    next->m_mapper = m_mapper;
+
+    m_snapshot.store(std::move(next), std::memory_order_release);
+    m_reloads.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+template <typename Row, typename Key>
+inline void ReferenceTable<Row, Key>::run(std::stop_token stop) {
+    while (!stop.stop_requested()) {
+        if (auto refreshed = refresh(); !refreshed) {
+            std::cerr << std::format("[ReferenceTable] Refresh of '{}' failed: {}\n", m_alias, refreshed.error().to_string());
+        }
+        std::unique_lock lock(m_mutex);
+        m_wakeup.wait_for(lock, stop, m_options.refresh_interval, [this] { return m_refresh_requested; });
+        m_refresh_requested = false;
+    }
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_REFERENCE_TABLE_H
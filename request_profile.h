@@ -0,0 +1,186 @@
+#ifndef MODERN_ODBC_REQUEST_PROFILE_H
+#define MODERN_ODBC_REQUEST_PROFILE_H
+
+/**
+ * @file request_profile.h
+ * @brief Per-request database profile with repeated-query (N+1) detection.
+ *
+ * A RequestProfile is an RAII guard: while it is alive, every statement
+ * executed on the creating thread is counted towards it, with round trips
+ * (connect, prepare, execute and each fetch), rows, bytes read through
+ * get_data() and the wall time spent inside ODBC calls.
+ *
+ *   odbc::RequestProfile profile;
+ *   handle_request();
+ *   log << profile.summary().to_string();   // "DB: 14 queries, 38 ms"
+ *
+ * Work that continues on another thread (an Executor job, a coroutine resumed
+ * elsewhere) joins the profile with a RequestProfile::Attach guard.
+ *
+ * A fingerprint executed more than repeat_threshold times in one profile is
+ * the typical shape of an N+1 (one query per row of a previous result); the
+ * summary lists such fingerprints and the destructor warns about them on
+ * std::cerr unless disabled.
+ *
+ * Profiles nest: an inner profile collects on its own until it ends, then the
+ * outer one resumes. Counting needs the default instrumentation policy;
+ * repeat detection also needs query_stats_enabled().
+ */
+
+#include "query_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct RequestProfileOptions
+ * @brief Configuration for a RequestProfile.
+ */
+struct RequestProfileOptions {
+    std::size_t repeat_threshold = 10;   ///< Executions of one fingerprint above which it is flagged.
+    bool warn_on_repeats = true;         ///< Report flagged fingerprints on std::cerr when the profile ends.
+    std::string label;                   ///< Names the request in the warning, e.g. "GET /orders".
+};
+
+/**
+ * @struct RepeatedQuery
+ * @brief A fingerprint executed more often than the repeat threshold.
+ */
+struct RepeatedQuery {
+    std::uint64_t fingerprint = 0;
+    std::string query;   ///< The normalized text.
+    std::uint64_t executions = 0;
+};
+
+/**
+ * @struct RequestProfileSummary
+ * @brief The totals of a RequestProfile.
+ */
+struct RequestProfileSummary {
+    std::uint64_t statements = 0;
+    std::uint64_t round_trips = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0;
+    std::chrono::nanoseconds db_time{0};
+    std::vector<RepeatedQuery> repeated;   ///< Most executions first.
+
+    /**
+     * @brief "DB: 14 queries, 38 ms", followed by the most repeated fingerprint if any.
+     */
+    [[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * @class RequestProfile
+ * @brief Counts the database work of the current thread while alive (see file comment).
+ */
+class RequestProfile {
+public:
+    explicit RequestProfile(RequestProfileOptions options = {});
+    ~RequestProfile();
+    RequestProfile(const RequestProfile&) = delete;
+    RequestProfile& operator=(const RequestProfile&) = delete;
+
+    [[nodiscard]] RequestProfileSummary summary() const;
+
+    /**
+     * @brief The innermost profile active on this thread, or nullptr.
+     */
+    [[nodiscard]] static RequestProfile* current() noexcept { return t_current; }
+
+    /**
+     * @class Attach
+     * @brief Counts the current thread's work towards a profile created elsewhere.
+     * The profile must outlive the guard.
+     */
+    class Attach {
+    public:
+        explicit Attach(RequestProfile& profile) noexcept
+            : m_previous_counters(std::exchange(detail::active_request, &profile.m_counters)),
+              m_previous(std::exchange(t_current, &profile)) {}
+        ~Attach() {
+            detail::active_request = m_previous_counters;
+            t_current = m_previous;
+        }
+        Attach(const Attach&) = delete;
+        Attach& operator=(const Attach&) = delete;
+
+    private:
+        detail::RequestCounters* m_previous_counters;
+        RequestProfile* m_previous;
+    };
+
+private:
+    RequestProfileOptions m_options;
+    mutable detail::RequestCounters m_counters;
+    detail::RequestCounters* m_previous_counters;
+    RequestProfile* m_previous;
+
+    static inline thread_local RequestProfile* t_current = nullptr;
+};
+
+
+// --- Implementation ---
+
+inline std::string RequestProfileSummary::to_string() const {
+    std::string text = std::format("DB: {} {}, {} ms", statements, statements == 1 ? "query" : "queries",
+                                   std::chrono::duration_cast<std::chrono::milliseconds>(db_time).count());
+    if (!repeated.empty()) {
+        text += std::format("; repeated {}x: {}", repeated.front().executions, repeated.front().query);
+    }
+    return text;
+}
+
+inline RequestProfile::RequestProfile(RequestProfileOptions options)
+    : m_options(std::move(options)),
+      m_previous_counters(std::exchange(detail::active_request, &m_counters)),
+      m_previous(std::exchange(t_current, this)) {}
+
+inline RequestProfile::~RequestProfile() {
+    detail::active_request = m_previous_counters;
+    t_current = m_previous;
+    if (!m_options.warn_on_repeats) {
+        return;
+    }
+    try {
+        for (const auto& repeated : summary().repeated) {
+            std::cerr << std::format("[RequestProfile] Possible N+1{}: executed {} times: {}\n",
+                                     m_options.label.empty() ? "" : " in " + m_options.label, repeated.executions, repeated.query);
+        }
+    } catch (...) {
+        // Destructors must not throw; the warning is best effort.
+    }
+}
+
+inline RequestProfileSummary RequestProfile::summary() const {
+    RequestProfileSummary summary{m_counters.statements.load(std::memory_order_relaxed),
+                                  m_counters.round_trips.load(std::memory_order_relaxed),
+                                  m_counters.rows.load(std::memory_order_relaxed),
+                                  m_counters.bytes.load(std::memory_order_relaxed),
+                                  std::chrono::nanoseconds(m_counters.db_ns.load(std::memory_order_relaxed)),
+                                  {}};
+    {
+        std::scoped_lock lock(m_counters.mutex);
+        for (const auto& [query, executions] : m_counters.executions) {
+            if (executions > m_options.repeat_threshold) {
+                summary.repeated.push_back(RepeatedQuery{query->fingerprint, query->query, executions});
+            }
+        }
+    }
+    std::ranges::sort(summary.repeated, std::greater<>{}, &RepeatedQuery::executions);
+    return summary;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_REQUEST_PROFILE_H
@@ -0,0 +1,146 @@
+#ifndef MODERN_ODBC_RESOURCE_USAGE_H
+#define MODERN_ODBC_RESOURCE_USAGE_H
+
+/**
+ * @file resource_usage.h
+ * @brief Client-side cost of statement executions: CPU time, heap use and bytes per column.
+ *
+ * Wall time alone cannot tell waiting for the server from spending client CPU
+ * on converting rows. With the default instrumentation policy every execution
+ * (from execute to the end of its result set) records:
+ *   - the thread CPU time consumed meanwhile (CLOCK_THREAD_CPUTIME_ID deltas,
+ *     GetThreadTimes on Windows), next to the time spent inside execute and
+ *     fetch calls;
+ *   - allocations and heap bytes requested from the thread's counting memory
+ *     resource, which the statement uses for its own buffers and which callers
+ *     can pass to their pmr containers to attribute row processing as well;
+ *   - bytes fetched per column, taken from the length indicators of get_data().
+ *
+ * Statement::last_execution() returns the figures of the last finished
+ * execution; the per-fingerprint query statistics and the slow-query log
+ * carry the totals.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace odbc {
+
+/**
+ * @struct ExecutionUsage
+ * @brief What one statement execution cost on the client.
+ */
+struct ExecutionUsage {
+    std::chrono::nanoseconds wall_time{0};       ///< Time inside execute and fetch calls: mostly waiting for the server.
+    std::chrono::nanoseconds cpu_time{0};        ///< Thread CPU time from execute to the end of the result set.
+    std::uint64_t allocations = 0;               ///< Allocations from counting_resource() meanwhile.
+    std::uint64_t allocated_bytes = 0;
+    std::uint64_t rows = 0;
+    std::vector<std::uint64_t> column_bytes;     ///< Bytes read through get_data(), by column (index 0 is column 1).
+};
+
+/**
+ * @class CountingMemoryResource
+ * @brief A memory resource that counts the allocations it forwards upstream.
+ */
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : m_upstream(upstream) {}
+
+    [[nodiscard]] std::uint64_t allocations() const noexcept { return m_allocations.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t allocated_bytes() const noexcept { return m_allocated_bytes.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::int64_t live_bytes() const noexcept { return m_live_bytes.load(std::memory_order_relaxed); }
+
+private:
+    std::pmr::memory_resource* m_upstream;
+    std::atomic<std::uint64_t> m_allocations{0};
+    std::atomic<std::uint64_t> m_allocated_bytes{0};
+    std::atomic<std::int64_t> m_live_bytes{0};
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = m_upstream->allocate(bytes, alignment);
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_live_bytes.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+        m_live_bytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+/**
+ * @brief The calling thread's counting resource; allocations through it are
+ * attributed to the statement execution running on the thread.
+ */
+[[nodiscard]] CountingMemoryResource& counting_resource() noexcept;
+
+/**
+ * @brief CPU time consumed by the calling thread so far.
+ */
+[[nodiscard]] std::chrono::nanoseconds thread_cpu_time() noexcept;
+
+/**
+ * @brief Turns CPU and allocation accounting on or off (on by default).
+ * Reading the thread CPU clock costs a system call at the start and end of each execution.
+ */
+void set_resource_accounting_enabled(bool enabled) noexcept;
+[[nodiscard]] bool resource_accounting_enabled() noexcept;
+
+
+// --- Implementation ---
+
+namespace detail {
+    alignas(64) inline std::atomic<bool> resource_accounting_on{true};
+} // namespace detail
+
+inline CountingMemoryResource& counting_resource() noexcept {
+    thread_local CountingMemoryResource resource;
+    return resource;
+}
+
+inline std::chrono::nanoseconds thread_cpu_time() noexcept {
+#ifdef _WIN32
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return std::chrono::nanoseconds::zero();
+    }
+    auto ticks = [](const FILETIME& time) { return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+    return std::chrono::nanoseconds((ticks(kernel) + ticks(user)) * 100);   // FILETIME counts 100 ns units
+#else
+    timespec now{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+#endif
+}
+
+inline void set_resource_accounting_enabled(bool enabled) noexcept { detail::resource_accounting_on.store(enabled, std::memory_order_relaxed); }
+
+inline bool resource_accounting_enabled() noexcept { return detail::resource_accounting_on.load(std::memory_order_relaxed); }
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_RESOURCE_USAGE_H
@@ -0,0 +1,630 @@
+#ifndef MODERN_ODBC_RESULT_CACHE_H
+#define MODERN_ODBC_RESULT_CACHE_H
+
+/**
+ * @file result_cache.h
+ * @brief An in-process cache of materialized query results.
+ *
+ * Entries are keyed by alias, normalized SQL text and parameter values, and
+ * hold an immutable ResultSet shared by every reader. The cache supports:
+ *  - a time-to-live per entry, with a shorter one for empty results (negative caching),
+ *  - invalidation by table tag, so write paths can call invalidate("orders"),
+ *  - stale-while-revalidate: for a short window after expiry the old result is
+ *    served while a refresh runs on an Executor,
+ *  - a total byte budget enforced per shard with LRU eviction.
+ *
+ * Concurrent misses for the same key are collapsed through SingleFlight, so a
+ * cold key is loaded once no matter how many threads ask for it.
+ *
+ * In front of the shared shards, every thread keeps a small 2-way set-associative
+ * L1 of shared pointers to recently used entries. An L1 hit takes no lock and
+ * touches no shared entry: it reads the clock for the expiry check, the
+ * thread-local slot (which keeps its own copy of the expiry time) and, with one
+ * relaxed load, the cache's epoch. Every invalidation, erase, clear and
+ * replacement in a cache increments its epoch, and a slot filled under an older
+ * epoch is treated as a miss; the epoch is per cache, so writes to one cache
+ * leave the L1 slots of the others valid.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "executor.h"
+#include "result_set.h"
+#include "single_flight.h"
+#include "snapshot_file.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+namespace detail {
+
+    /**
+     * @brief Source of ResultCache ids, which tag L1 slots; unlike addresses they are never reused.
+     */
+    inline std::atomic<std::uint64_t> result_cache_ids{0};
+
+} // namespace detail
+
+/**
+ * @struct ResultCacheOptions
+ * @brief Configuration for a ResultCache.
+ */
+struct ResultCacheOptions {
+    std::size_t max_bytes = 64 * 1024 * 1024;                 ///< Total budget, split evenly across shards.
+    std::size_t shards = 16;
+    std::chrono::milliseconds default_ttl{5000};
+    std::chrono::milliseconds negative_ttl{1000};             ///< TTL for results with no rows.
+    std::chrono::milliseconds stale_while_revalidate{0};      ///< Window after expiry in which stale results are served.
+    Executor* executor = nullptr;                             ///< Runs background refreshes; without one, stale entries are reloaded inline.
+};
+
+/**
+ * @struct CacheEntryOptions
+ * @brief Per-call caching parameters.
+ */
+struct CacheEntryOptions {
+    std::vector<std::string> tags;                   ///< Tables the result depends on.
+    std::optional<std::chrono::milliseconds> ttl;    ///< Overrides ResultCacheOptions::default_ttl.
+};
+
+/**
+ * @struct ResultCacheStats
+ * @brief Counters describing cache effectiveness.
+ */
+struct ResultCacheStats {
+    std::uint64_t hits = 0;         ///< Other threads' L1 hits are added in batches of 64, or when they switch caches or exit.
+    std::uint64_t stale_hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t invalidations = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+};
+
+/**
+ * @class ResultCache
+ * @brief Thread-safe, byte-bounded, sharded LRU cache of ResultSets.
+ */
+class ResultCache {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Result = std::expected<ResultSet, OdbcError>;
+    using Loader = std::move_only_function<Result()>;
+
+    /**
+     * @struct Entry
+     * @brief A cached result. Entries are immutable once published.
+     */
+    struct Entry {
+        ResultSet result;
+        Clock::time_point expires;
+        Clock::time_point stale_until;
+        std::vector<std::string> tags;
+        std::size_t bytes = 0;
+        bool negative = false;
+        mutable std::atomic<bool> refreshing{false};
+    };
+
+    explicit ResultCache(ResultCacheOptions options = {});
+
+    /**
+     * @brief Waits for background refreshes that still reference the cache.
+     */
+    ~ResultCache();
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * @brief Collapses whitespace outside of quoted literals and trims the text,
+     * so formatting differences do not produce different keys.
+     */
+    [[nodiscard]] static std::string normalize_sql(std::string_view sql);
+
+    /**
+     * @brief Builds a cache key from alias, normalized SQL and parameter values.
+     */
+    [[nodiscard]] static std::string make_key(std::string_view alias, std::string_view sql, const std::vector<Parameter>& parameters) {
+        return make_query_key(alias, normalize_sql(sql), parameters);
+    }
+
+    /**
+     * @brief Returns the entry for a key if it is fresh or within its stale window.
+     */
+    [[nodiscard]] std::shared_ptr<const Entry> lookup(const std::string& key);
+
+    /**
+     * @brief Returns a fresh result for a key, checking the calling thread's L1 first.
+     *
+     * This is the fastest read path: an L1 hit takes no lock and no reference count.
+     * The pointer stays valid until the calling thread's next find() or get_or_load()
+     * on any ResultCache. Stale and missing entries return nullptr; nothing is loaded.
+     */
+    [[nodiscard]] const ResultSet* find(const std::string& key);
+
+    /**
+     * @brief Stores a result, replacing any previous entry for the key.
+     */
+    void insert(const std::string& key, ResultSet result, const CacheEntryOptions& options = {});
+
+    /**
+     * @brief Returns the cached result, or runs loader() on a miss and caches its result.
+     *
+     * Errors are returned but not cached. A stale hit returns the old result and
+     * schedules loader() in the background.
+     */
+    [[nodiscard]] Result get_or_load(const std::string& key, Loader loader, const CacheEntryOptions& options = {});
+
+    /**
+     * @brief Cached execution of a read-only query on the thread-local pool.
+     * @throws ConnectionPoolError if a load needs a connection that cannot be established.
+     */
+    [[nodiscard]] Result query(std::string_view alias, std::string_view connection_string, std::string_view sql,
+                               std::vector<Parameter> parameters = {}, const CacheEntryOptions& options = {});
+
+    /**
+     * @brief Removes every entry tagged with the given table.
+     */
+    void invalidate(std::string_view tag);
+
+    void erase(const std::string& key);
+    void clear();
+
+    /**
+     * @brief Adds every unexpired, non-empty entry to a snapshot file, with its tags as metadata.
+     * @param prefix Prepended to each key, so one file can also hold reference tables or other caches.
+     * @return The number of entries added.
+     */
+    std::size_t export_snapshot(SnapshotWriter& writer, std::string_view prefix = "result_cache/") const;
+
+    /**
+     * @brief Loads entries from a mapped snapshot for a warm start.
+     *
+     * Imported entries are already expired but may be served as stale for serve_for,
+     * so the first read of each one is answered immediately and triggers a refresh
+     * on the executor (without an executor, that read reloads inline instead).
+     *
+     * @param prefix Only entries whose name starts with it are imported; it is stripped from the key.
+     * @return The number of entries imported.
+     */
+    std::size_t import_snapshot(const MappedSnapshot& snapshot, std::chrono::milliseconds serve_for,
+                                std::string_view prefix = "result_cache/");
+
+    [[nodiscard]] ResultCacheStats stats() const;
+
+private:
+    struct Node {
+        std::shared_ptr<const Entry> entry;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    using HitCounter = std::atomic<std::uint64_t>;
+
+    /**
+     * @brief Per-thread L1 shared by all caches; slots are tagged with their owner's id and epoch.
+     */
+    struct L1 {
+        static constexpr std::size_t sets = 64;
+        static constexpr std::size_t ways = 2;
+        static constexpr std::uint32_t hit_flush_interval = 64;
+
+        struct Slot {
+            std::uint64_t owner = 0;   // ResultCache id; 0 is never assigned
+            std::size_t hash = 0;
+            std::uint64_t epoch = 0;
+            Clock::time_point expires;
+            std::string key;
+            std::shared_ptr<const Entry> entry;
+        };
+
+        std::array<std::array<Slot, ways>, sets> slots;
+        std::array<std::uint8_t, sets> most_recent{};
+
+        // L1 hits are added to the owner's counter in batches to keep the hit path thread-local.
+        // Holding the counter keeps it alive for the final flush even if its cache is gone.
+        std::shared_ptr<HitCounter> counted;
+        std::uint32_t pending_hits = 0;
+
+        void flush_hits() noexcept {
+            if (pending_hits != 0) {
+                counted->fetch_add(pending_hits, std::memory_order_relaxed);
+                pending_hits = 0;
+            }
+        }
+
+        ~L1() { flush_hits(); }
+    };
+
+    static L1& local_l1() {
+        thread_local L1 l1;
+        return l1;
+    }
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::list<std::string> lru;   // most recently used first
+        std::unordered_map<std::string, Node> nodes;
+        std::size_t bytes = 0;
+    };
+
+    ResultCacheOptions m_options;
+    std::size_t m_shard_budget;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    SingleFlight m_flights;
+
+    // Incremented by every invalidation; a load that started before one is not cached.
+    std::atomic<std::uint64_t> m_invalidation_generation{0};
+
+    const std::uint64_t m_id = detail::result_cache_ids.fetch_add(1, std::memory_order_relaxed) + 1;
+    // Incremented whenever this cache drops or replaces an entry; invalidates its L1 slots.
+    alignas(64) std::atomic<std::uint64_t> m_epoch{0};
+
+    std::shared_ptr<HitCounter> m_hits = std::make_shared<HitCounter>(0);
+    std::atomic<std::uint64_t> m_stale_hits{0};
+    std::atomic<std::uint64_t> m_misses{0};
+    std::atomic<std::uint64_t> m_evictions{0};
+    std::atomic<std::uint64_t> m_invalidations{0};
+
+    std::mutex m_refresh_mutex;
+    std::condition_variable m_refresh_idle;
+    std::size_t m_refreshes_running = 0;
+
+    Shard& shard_for(const std::string& key) const {
+        return *m_shards[std::hash<std::string>{}(key) % m_shards.size()];
+    }
+
+    void erase_node(Shard& shard, std::unordered_map<std::string, Node>::iterator it) {
+        shard.bytes -= it->second.entry->bytes;
+        shard.lru.erase(it->second.lru_position);
+        shard.nodes.erase(it);
+    }
+
+    const Entry* l1_find(const std::string& key, std::size_t hash, Clock::time_point now);
+    void l1_store(const std::string& key, std::size_t hash, std::uint64_t epoch, std::shared_ptr<const Entry> entry);
+
+    void bump_epoch() {
+        m_epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    void store(const std::string& key, ResultSet result, std::vector<std::string> tags,
+               Clock::time_point expires, Clock::time_point stale_until);
+
+    Result load_and_store(const std::string& key, Loader& loader, const CacheEntryOptions& options);
+    void schedule_refresh(const std::string& key, std::shared_ptr<const Entry> entry, Loader loader, CacheEntryOptions options);
+};
+
+
+// --- Implementation ---
+
+inline ResultCache::ResultCache(ResultCacheOptions options) : m_options(std::move(options)) {
+    const std::size_t shards = std::max<std::size_t>(1, m_options.shards);
+    m_shard_budget = std::max<std::size_t>(1, m_options.max_bytes / shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+inline ResultCache::~ResultCache() {
+    std::unique_lock lock(m_refresh_mutex);
+    m_refresh_idle.wait(lock, [this] { return m_refreshes_running == 0; });
+}
+
+inline std::string ResultCache::normalize_sql(std::string_view sql) {
+    std::string normalized;
+    normalized.reserve(sql.size());
+    char quote = 0;
+    bool pending_space = false;
+    for (char c : sql) {
+        if (quote != 0) {
+            normalized.push_back(c);
+            if (c == quote) quote = 0;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pending_space = !normalized.empty();
+            continue;
+        }
+        if (pending_space) {
+            normalized.push_back(' ');
+            pending_space = false;
+        }
+        if (c == '\'' || c == '"') quote = c;
+        normalized.push_back(c);
+    }
+    return normalized;
+}
+
+inline std::shared_ptr<const ResultCache::Entry> ResultCache::lookup(const std::string& key) {
+    Shard& shard = shard_for(key);
+    std::scoped_lock lock(shard.mutex);
+    auto it = shard.nodes.find(key);
+    if (it == shard.nodes.end()) {
+        return nullptr;
+    }
+    if (Clock::now() >= it->second.entry->stale_until) {
+        erase_node(shard, it);
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_position);
+    return it->second.entry;
+}
+
+inline const ResultCache::Entry* ResultCache::l1_find(const std::string& key, std::size_t hash, Clock::time_point now) {
+    L1& l1 = local_l1();
+    const std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+    const std::size_t set = hash % L1::sets;
+    for (std::size_t way = 0; way < L1::ways; ++way) {
+        const L1::Slot& slot = l1.slots[set][way];
+        if (slot.owner != m_id || slot.hash != hash || slot.epoch != epoch || now >= slot.expires || slot.key != key) {
+            continue;
+        }
+        l1.most_recent[set] = static_cast<std::uint8_t>(way);
+        if (l1.counted != m_hits) {
+            // Hand the hits buffered for the previous cache over before counting for this one.
+            l1.flush_hits();
+            l1.counted = m_hits;
+        }
+        if (++l1.pending_hits == L1::hit_flush_interval) {
+            l1.flush_hits();
+        }
+        return slot.entry.get();
+    }
+    return nullptr;
+}
+
+inline void ResultCache::l1_store(const std::string& key, std::size_t hash, std::uint64_t epoch, std::shared_ptr<const Entry> entry) {
+    L1& l1 = local_l1();
+    const std::size_t set = hash % L1::sets;
+    const std::size_t way = 1 - l1.most_recent[set];
+    L1::Slot& slot = l1.slots[set][way];
+    slot.owner = m_id;
+    slot.hash = hash;
+    slot.epoch = epoch;
+    slot.expires = entry->expires;
+    slot.key = key;
+    slot.entry = std::move(entry);
+    l1.most_recent[set] = static_cast<std::uint8_t>(way);
+}
+
+inline const ResultSet* ResultCache::find(const std::string& key) {
+    const std::size_t hash = std::hash<std::string>{}(key);
+    const auto now = Clock::now();
+    if (const Entry* entry = l1_find(key, hash, now)) {
+        return &entry->result;
+    }
+    // Read the epoch before the shared lookup: a concurrent invalidation then
+    // leaves the slot with an outdated epoch instead of serving the dropped entry.
+    const std::uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+    auto entry = lookup(key);
+    if (!entry || now >= entry->expires) {
+        return nullptr;
+    }
+    m_hits->fetch_add(1, std::memory_order_relaxed);
+    const ResultSet* result = &entry->result;
+    l1_store(key, hash, epoch, std::move(entry));
+    return result;
+}
+
+inline void ResultCache::insert(const std::string& key, ResultSet result, const CacheEntryOptions& options) {
+    const auto expires = Clock::now() + (result.empty() ? m_options.negative_ttl : options.ttl.value_or(m_options.default_ttl));
+    store(key, std::move(result), options.tags, expires, expires + m_options.stale_while_revalidate);
+}
+
+inline void ResultCache::store(const std::string& key, ResultSet result, std::vector<std::string> tags,
+                               Clock::time_point expires, Clock::time_point stale_until) {
+    auto entry = std::make_shared<Entry>();
+    entry->negative = result.empty();
+    entry->expires = expires;
+    entry->stale_until = stale_until;
+    entry->tags = std::move(tags);
+    entry->bytes = result.memory_bytes() + key.size() + sizeof(Entry) + sizeof(Node) + 64;
+    for (const auto& tag : entry->tags) entry->bytes += tag.size();
+    entry->result = std::move(result);
+
+    Shard& shard = shard_for(key);
+    std::unique_lock lock(shard.mutex);
+    bool replaced = false;
+    if (auto it = shard.nodes.find(key); it != shard.nodes.end()) {
+        erase_node(shard, it);
+        replaced = true;
+    }
+    shard.lru.push_front(key);
+    shard.nodes.emplace(key, Node{entry, shard.lru.begin()});
+    shard.bytes += entry->bytes;
+
+    // Evict least recently used entries, but never the one just inserted.
+    while (shard.bytes > m_shard_budget && shard.lru.size() > 1) {
+        erase_node(shard, shard.nodes.find(shard.lru.back()));
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    lock.unlock();
+
+    // Evicted entries may stay in L1 until they expire; a replaced one must not.
+    if (replaced) {
+        bump_epoch();
+    }
+}
+
+inline ResultCache::Result ResultCache::load_and_store(const std::string& key, Loader& loader, const CacheEntryOptions& options) {
+    const std::uint64_t generation = m_invalidation_generation.load(std::memory_order_acquire);
+    Result result = loader();
+    if (result && m_invalidation_generation.load(std::memory_order_acquire) == generation) {
+        insert(key, *result, options);
+    }
+    return result;
+}
+
+inline ResultCache::Result ResultCache::get_or_load(const std::string& key, Loader loader, const CacheEntryOptions& options) {
+    const std::size_t hash = std::hash<std::string>{}(key);
+    const auto now = Clock::now();
+    if (const Entry* entry = l1_find(key, hash, now)) {
+        return entry->result;
+    }
+    const std::uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+    if (auto entry = lookup(key)) {
+        if (now < entry->expires) {
+            m_hits->fetch_add(1, std::memory_order_relaxed);
+            ResultSet result = entry->result;
+            l1_store(key, hash, epoch, std::move(entry));
+            return result;
+        }
+        if (m_options.executor != nullptr) {
+            m_stale_hits.fetch_add(1, std::memory_order_relaxed);
+            schedule_refresh(key, entry, std::move(loader), options);
+            return entry->result;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return m_flights.run(key, [&] { return load_and_store(key, loader, options); });
+}
+
+inline void ResultCache::schedule_refresh(const std::string& key, std::shared_ptr<const Entry> entry, Loader loader, CacheEntryOptions options) {
+    // One refresh per entry, however many readers hit it while stale.
+    if (entry->refreshing.exchange(true)) {
+        return;
+    }
+    {
+        std::scoped_lock lock(m_refresh_mutex);
+        ++m_refreshes_running;
+    }
+    (void)m_options.executor->submit([this, key, loader = std::move(loader), options = std::move(options)]() mutable {
+        try {
+            (void)m_flights.run(key, [&] { return load_and_store(key, loader, options); });
+        } catch (const std::exception& e) {
+            std::cerr << std::format("[ResultCache] Background refresh failed: {}\n", e.what());
+        }
+        std::scoped_lock lock(m_refresh_mutex);
+        if (--m_refreshes_running == 0) m_refresh_idle.notify_all();
+    });
+}
+
+inline ResultCache::Result ResultCache::query(std::string_view alias, std::string_view connection_string, std::string_view sql,
+                                              std::vector<Parameter> parameters, const CacheEntryOptions& options) {
+    std::string key = make_key(alias, sql, parameters);
+    return get_or_load(key, [alias = std::string(alias), connection_string = std::string(connection_string),
+                             sql = std::string(sql), parameters = std::move(parameters)]() -> Result {
+        auto stmt = getThreadLocalStatement(alias, connection_string);
+        if (auto exec_res = stmt->execute_direct(sql, parameters); !exec_res) {
+            return std::unexpected(exec_res.error());
+        }
+        return materialize(*stmt);
+    }, options);
+}
+
+inline void ResultCache::invalidate(std::string_view tag) {
+    m_invalidation_generation.fetch_add(1, std::memory_order_acq_rel);
+    m_invalidations.fetch_add(1, std::memory_order_relaxed);
+    for (auto& shard : m_shards) {
+        std::scoped_lock lock(shard->mutex);
+        for (auto it = shard->nodes.begin(); it != shard->nodes.end();) {
+            const auto& tags = it->second.entry->tags;
+            auto next = std::next(it);
+            if (std::ranges::find(tags, tag) != tags.end()) {
+                erase_node(*shard, it);
+            }
+            it = next;
+        }
+    }
+    bump_epoch();
+}
+
+inline void ResultCache::erase(const std::string& key) {
+    Shard& shard = shard_for(key);
+    std::scoped_lock lock(shard.mutex);
+    if (auto it = shard.nodes.find(key); it != shard.nodes.end()) {
+        erase_node(shard, it);
+    }
+    bump_epoch();
+}
+
+inline void ResultCache::clear() {
+    m_invalidation_generation.fetch_add(1, std::memory_order_acq_rel);
+    for (auto& shard : m_shards) {
+        std::scoped_lock lock(shard->mutex);
+        shard->nodes.clear();
+        shard->lru.clear();
+        shard->bytes = 0;
+    }
+    bump_epoch();
+}
+
+inline std::size_t ResultCache::export_snapshot(SnapshotWriter& writer, std::string_view prefix) const {
+    const auto now = Clock::now();
+    std::size_t exported = 0;
+    for (const auto& shard : m_shards) {
+        std::scoped_lock lock(shard->mutex);
+        for (const auto& [key, node] : shard->nodes) {
+            const Entry& entry = *node.entry;
+            if (entry.negative || now >= entry.expires) continue;
+            std::string tags;
+            for (const auto& tag : entry.tags) {
+                if (!tags.empty()) tags.push_back('\n');
+                tags.append(tag);
+            }
+            writer.add(std::string(prefix) + key, std::move(tags), entry.result);
+            ++exported;
+        }
+    }
+    return exported;
+}
+
+inline std::size_t ResultCache::import_snapshot(const MappedSnapshot& snapshot, std::chrono::milliseconds serve_for,
+                                                std::string_view prefix) {
+    const auto now = Clock::now();
+    std::size_t imported = 0;
+    for (const auto& entry : snapshot.entries()) {
+        if (!entry.name.starts_with(prefix)) continue;
+        std::vector<std::string> tags;
+        for (std::size_t start = 0; start < entry.metadata.size();) {
+            std::size_t end = entry.metadata.find('\n', start);
+            if (end == std::string_view::npos) end = entry.metadata.size();
+            tags.emplace_back(entry.metadata.substr(start, end - start));
+            start = end + 1;
+        }
+        store(std::string(entry.name.substr(prefix.size())), entry.data, std::move(tags), now, now + serve_for);
+        ++imported;
+    }
+    return imported;
+}
+
+inline ResultCacheStats ResultCache::stats() const {
+    ResultCacheStats stats;
+    L1& l1 = local_l1();
+    if (l1.counted == m_hits) {
+        l1.flush_hits();   // the calling thread's own hits are always included
+    }
+    stats.hits = m_hits->load(std::memory_order_relaxed);
+    stats.stale_hits = m_stale_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.evictions = m_evictions.load(std::memory_order_relaxed);
+    stats.invalidations = m_invalidations.load(std::memory_order_relaxed);
+    for (const auto& shard : m_shards) {
+        std::scoped_lock lock(shard->mutex);
+        stats.entries += shard->nodes.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_RESULT_CACHE_H
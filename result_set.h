@@ -0,0 +1,521 @@
+#ifndef MODERN_ODBC_RESULT_SET_H
+#define MODERN_ODBC_RESULT_SET_H
+
+/**
+ * @file result_set.h
+ * @brief An immutable, compact, fully materialized query result.
+ *
+ * A ResultSet stores all rows of a query column by column in a single flat
+ * buffer: integer and floating point columns as native 64-bit arrays, text
+ * columns as one character block plus an offset array, and NULLs as a bitmap.
+ * The buffer contains no pointers, only offsets relative to its start, so it
+ * can be shared between threads, copied byte for byte, or used in place from
+ * another source of memory.
+ *
+ * ResultSet objects are cheap to copy (the buffer is reference counted) and
+ * never change after construction. Use ResultSetBuilder or materialize() to
+ * create one.
+ */
+
+#include "odbc_wrapper.h"
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace odbc {
+
+namespace detail {
+
+    inline constexpr std::uint32_t result_set_magic = 0x5352444Fu; // "ODRS"
+    inline constexpr std::uint32_t result_set_layout_version = 1;
+
+    /**
+     * @struct FlatResultHeader
+     * @brief The first bytes of a ResultSet buffer.
+     */
+    struct FlatResultHeader {
+        std::uint32_t magic;
+        std::uint32_t layout_version;
+        std::uint64_t total_size;
+        std::uint32_t column_count;
+        std::uint32_t reserved;
+        std::uint64_t row_count;
+    };
+
+    /**
+     * @struct FlatColumnHeader
+     * @brief Per-column directory entry; all offsets are relative to the buffer start.
+     */
+    struct FlatColumnHeader {
+        std::uint32_t kind;
+        std::int32_t sql_type;
+        std::uint64_t name_offset;
+        std::uint64_t name_length;
+        std::uint64_t nulls_offset;
+        std::uint64_t values_offset;
+        std::uint64_t chars_offset;
+        std::uint64_t chars_size;
+    };
+
+    constexpr std::uint64_t align8(std::uint64_t value) noexcept {
+        return (value + 7) & ~std::uint64_t{7};
+    }
+
+} // namespace detail
+
+
+/**
+ * @class ResultSet
+ * @brief Immutable, shareable, column-major query result. Rows and columns are zero-based.
+ */
+class ResultSet {
+public:
+    /**
+     * @enum ColumnKind
+     * @brief Physical storage of a column.
+     */
+    enum class ColumnKind : std::uint32_t {
+        integer = 0,   ///< 64-bit signed integers
+        real = 1,      ///< IEEE doubles
+        text = 2       ///< Character data (also used for decimals, dates and other types)
+    };
+
+    /**
+     * @brief An empty result with no columns and no rows.
+     */
+    ResultSet() = default;
+
+    /**
+     * @brief Wraps an existing flat buffer without copying it.
+     *
+     * @param storage Keeps the memory alive for as long as any copy of the ResultSet exists.
+     * @param data The start of the flat buffer, 8-byte aligned.
+     * @param size The number of readable bytes at data.
+     * @return The ResultSet, or std::nullopt if the buffer is not a valid layout.
+     */
+    [[nodiscard]] static std::optional<ResultSet> from_flat(std::shared_ptr<const void> storage, const std::byte* data, std::size_t size);
+
+    [[nodiscard]] std::size_t row_count() const noexcept { return m_data ? static_cast<std::size_t>(header().row_count) : 0; }
+    [[nodiscard]] std::size_t column_count() const noexcept { return m_data ? header().column_count : 0; }
+    [[nodiscard]] bool empty() const noexcept { return row_count() == 0; }
+
+    [[nodiscard]] std::string_view column_name(std::size_t column) const;
+    [[nodiscard]] ColumnKind column_kind(std::size_t column) const { return static_cast<ColumnKind>(column_header(column).kind); }
+    [[nodiscard]] SQLSMALLINT column_sql_type(std::size_t column) const { return static_cast<SQLSMALLINT>(column_header(column).sql_type); }
+
+    /**
+     * @brief Finds a column by exact name.
+     */
+    [[nodiscard]] std::optional<std::size_t> find_column(std::string_view name) const;
+
+    [[nodiscard]] bool is_null(std::size_t row, std::size_t column) const;
+
+    /**
+     * @brief Reads one cell.
+     *
+     * Supported types are long long, long, int, double, std::string_view and std::string.
+     * Numeric columns convert to any of them; text columns convert to numbers by parsing.
+     * A std::string_view points into the shared buffer and stays valid while any copy of
+     * this ResultSet is alive.
+     *
+     * @return The value, or std::nullopt if the cell is NULL or cannot be converted to T.
+     */
+    template <typename T>
+    [[nodiscard]] std::optional<T> get(std::size_t row, std::size_t column) const;
+
+    /**
+     * @brief Size of the flat buffer in bytes.
+     */
+    [[nodiscard]] std::size_t memory_bytes() const noexcept { return m_data ? static_cast<std::size_t>(header().total_size) : 0; }
+
+    /**
+     * @brief The flat buffer, e.g. for writing it to a file.
+     */
+    [[nodiscard]] std::span<const std::byte> flat_bytes() const noexcept { return {m_data, memory_bytes()}; }
+
+private:
+    friend class ResultSetBuilder;
+
+    std::shared_ptr<const void> m_storage;
+    const std::byte* m_data = nullptr;
+
+    ResultSet(std::shared_ptr<const void> storage, const std::byte* data) : m_storage(std::move(storage)), m_data(data) {}
+
+    // The buffer is always created with these structures at 8-byte aligned offsets.
+    const detail::FlatResultHeader& header() const noexcept {
+        return *reinterpret_cast<const detail::FlatResultHeader*>(m_data);
+    }
+    const detail::FlatColumnHeader& column_header(std::size_t column) const {
+        return reinterpret_cast<const detail::FlatColumnHeader*>(m_data + sizeof(detail::FlatResultHeader))[column];
+    }
+    template <typename U>
+    const U* array_at(std::uint64_t offset) const noexcept {
+        return reinterpret_cast<const U*>(m_data + offset);
+    }
+    std::string_view text_at(const detail::FlatColumnHeader& col, std::size_t row) const noexcept {
+        const auto* offsets = array_at<std::uint64_t>(col.values_offset);
+        const char* chars = reinterpret_cast<const char*>(m_data + col.chars_offset);
+        return {chars + offsets[row], static_cast<std::size_t>(offsets[row + 1] - offsets[row])};
+    }
+};
+
+
+/**
+ * @class ResultSetBuilder
+ * @brief Accumulates rows column by column and packs them into a ResultSet.
+ *
+ * Declare every column first, then append one value (or NULL) per column for
+ * each row, in column order.
+ */
+class ResultSetBuilder {
+public:
+    void add_column(std::string name, ResultSet::ColumnKind kind, SQLSMALLINT sql_type = SQL_UNKNOWN_TYPE) {
+        m_columns.push_back(Column{std::move(name), kind, sql_type, {}, {}, {}, {}, {0}});
+    }
+
+    /**
+     * @brief Declares the same columns as an existing result.
+     */
+    void add_columns_from(const ResultSet& source) {
+        for (std::size_t c = 0; c < source.column_count(); ++c) {
+            add_column(std::string(source.column_name(c)), source.column_kind(c), source.column_sql_type(c));
+        }
+    }
+
+    [[nodiscard]] std::size_t column_count() const noexcept { return m_columns.size(); }
+
+    void append_null(std::size_t column) {
+        Column& col = m_columns[column];
+        col.nulls.push_back(1);
+        switch (col.kind) {
+            case ResultSet::ColumnKind::integer: col.integers.push_back(0); break;
+            case ResultSet::ColumnKind::real: col.reals.push_back(0.0); break;
+            case ResultSet::ColumnKind::text: col.offsets.push_back(col.chars.size()); break;
+        }
+    }
+
+    void append(std::size_t column, long long value) {
+        Column& col = m_columns[column];
+        if (col.kind == ResultSet::ColumnKind::text) {
+            append(column, std::string_view(std::to_string(value)));
+            return;
+        }
+        col.nulls.push_back(0);
+        if (col.kind == ResultSet::ColumnKind::integer) col.integers.push_back(value);
+        else col.reals.push_back(static_cast<double>(value));
+    }
+
+    template <std::integral I>
+    void append(std::size_t column, I value) {
+        append(column, static_cast<long long>(value));
+    }
+
+    void append(std::size_t column, double value) {
+        Column& col = m_columns[column];
+        if (col.kind == ResultSet::ColumnKind::text) {
+            append(column, std::string_view(std::format("{}", value)));
+            return;
+        }
+        col.nulls.push_back(0);
+        if (col.kind == ResultSet::ColumnKind::real) col.reals.push_back(value);
+        else col.integers.push_back(static_cast<long long>(value));
+    }
+
+    void append(std::size_t column, std::string_view value) {
+        Column& col = m_columns[column];
+        if (col.kind != ResultSet::ColumnKind::text) {
+            std::optional<double> parsed;
+            if (double d = 0; std::from_chars(value.data(), value.data() + value.size(), d).ec == std::errc{}) parsed = d;
+            if (!parsed) {
+                append_null(column);
+            } else if (col.kind == ResultSet::ColumnKind::integer) {
+                append(column, static_cast<long long>(*parsed));
+            } else {
+                append(column, *parsed);
+            }
+            return;
+        }
+        col.nulls.push_back(0);
+        col.chars.append(value);
+        col.offsets.push_back(col.chars.size());
+    }
+
+    /**
+     * @brief Copies one row of a result with the same column layout.
+     */
+    void append_row(const ResultSet& source, std::size_t row) {
+        for (std::size_t c = 0; c < m_columns.size(); ++c) {
+            if (source.is_null(row, c)) {
+                append_null(c);
+                continue;
+            }
+            switch (source.column_kind(c)) {
+                case ResultSet::ColumnKind::integer: append(c, *source.get<long long>(row, c)); break;
+                case ResultSet::ColumnKind::real: append(c, *source.get<double>(row, c)); break;
+                case ResultSet::ColumnKind::text: append(c, *source.get<std::string_view>(row, c)); break;
+            }
+        }
+    }
+
+    /**
+     * @brief Number of complete rows appended so far.
+     */
+    [[nodiscard]] std::size_t row_count() const noexcept {
+        std::size_t rows = m_columns.empty() ? 0 : m_columns.front().nulls.size();
+        for (const auto& col : m_columns) rows = std::min(rows, col.nulls.size());
+        return rows;
+    }
+
+    /**
+     * @brief Packs the accumulated rows into a single buffer. The builder is left empty.
+     */
+    [[nodiscard]] ResultSet build();
+
+private:
+    struct Column {
+        std::string name;
+        ResultSet::ColumnKind kind;
+        SQLSMALLINT sql_type;
+        std::vector<std::uint8_t> nulls;
+        std::vector<long long> integers;
+        std::vector<double> reals;
+        std::string chars;
+        std::vector<std::uint64_t> offsets;
+    };
+    std::vector<Column> m_columns;
+};
+
+
+// --- Implementation ---
+
+inline std::optional<ResultSet> ResultSet::from_flat(std::shared_ptr<const void> storage, const std::byte* data, std::size_t size) {
+    if (data == nullptr || size < sizeof(detail::FlatResultHeader) || reinterpret_cast<std::uintptr_t>(data) % 8 != 0) {
+        return std::nullopt;
+    }
+    const auto& head = *reinterpret_cast<const detail::FlatResultHeader*>(data);
+    if (head.magic != detail::result_set_magic || head.layout_version != detail::result_set_layout_version
+        || head.total_size > size
+        || sizeof(detail::FlatResultHeader) + std::uint64_t{head.column_count} * sizeof(detail::FlatColumnHeader) > head.total_size) {
+        return std::nullopt;
+    }
+    const auto* columns = reinterpret_cast<const detail::FlatColumnHeader*>(data + sizeof(detail::FlatResultHeader));
+    const std::uint64_t null_words = (head.row_count + 63) / 64;
+    for (std::uint32_t c = 0; c < head.column_count; ++c) {
+        const auto& col = columns[c];
+        const std::uint64_t values = (col.kind == static_cast<std::uint32_t>(ColumnKind::text)) ? head.row_count + 1 : head.row_count;
+        if (col.kind > static_cast<std::uint32_t>(ColumnKind::text)
+            || col.name_offset + col.name_length > head.total_size
+            || col.nulls_offset + null_words * 8 > head.total_size
+            || col.values_offset % 8 != 0 || col.nulls_offset % 8 != 0
+            || col.values_offset + values * 8 > head.total_size
+            || col.chars_offset + col.chars_size > head.total_size) {
+            return std::nullopt;
+        }
+    }
+    return ResultSet(std::move(storage), data);
+}
+
+inline std::string_view ResultSet::column_name(std::size_t column) const {
+    const auto& col = column_header(column);
+    return {reinterpret_cast<const char*>(m_data + col.name_offset), static_cast<std::size_t>(col.name_length)};
+}
+
+inline std::optional<std::size_t> ResultSet::find_column(std::string_view name) const {
+    for (std::size_t c = 0; c < column_count(); ++c) {
+        if (column_name(c) == name) return c;
+    }
+    return std::nullopt;
+}
+
+inline bool ResultSet::is_null(std::size_t row, std::size_t column) const {
+    const auto* words = array_at<std::uint64_t>(column_header(column).nulls_offset);
+    return (words[row / 64] >> (row % 64)) & 1u;
+}
+
+template <typename T>
+inline std::optional<T> ResultSet::get(std::size_t row, std::size_t column) const {
+    if (is_null(row, column)) {
+        return std::nullopt;
+    }
+    const auto& col = column_header(column);
+    const auto kind = static_cast<ColumnKind>(col.kind);
+
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        if (kind != ColumnKind::text) return std::nullopt;
+        return text_at(col, row);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        switch (kind) {
+            case ColumnKind::integer: return std::to_string(array_at<long long>(col.values_offset)[row]);
+            case ColumnKind::real: return std::format("{}", array_at<double>(col.values_offset)[row]);
+            case ColumnKind::text: return std::string(text_at(col, row));
+        }
+        return std::nullopt;
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "ResultSet::get supports arithmetic types, std::string and std::string_view");
+        switch (kind) {
+            case ColumnKind::integer: return static_cast<T>(array_at<long long>(col.values_offset)[row]);
+            case ColumnKind::real: return static_cast<T>(array_at<double>(col.values_offset)[row]);
+            case ColumnKind::text: {
+                std::string_view text = text_at(col, row);
+                T value{};
+                if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) return std::nullopt;
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+inline ResultSet ResultSetBuilder::build() {
+    const std::uint64_t rows = row_count();
+    const std::uint64_t null_words = (rows + 63) / 64;
+
+    // First pass: compute the layout.
+    std::uint64_t size = sizeof(detail::FlatResultHeader) + m_columns.size() * sizeof(detail::FlatColumnHeader);
+    std::vector<detail::FlatColumnHeader> headers(m_columns.size());
+    for (std::size_t c = 0; c < m_columns.size(); ++c) {
+        const Column& col = m_columns[c];
+        auto& h = headers[c];
+        h.kind = static_cast<std::uint32_t>(col.kind);
+        h.sql_type = col.sql_type;
+        h.name_offset = size;
+        h.name_length = col.name.size();
+        size = detail::align8(size + col.name.size());
+        h.nulls_offset = size;
+        size += null_words * 8;
+        h.values_offset = size;
+        if (col.kind == ResultSet::ColumnKind::text) {
+            size += (rows + 1) * 8;
+            h.chars_offset = size;
+            h.chars_size = col.offsets[rows];
+            size = detail::align8(size + h.chars_size);
+        } else {
+            size += rows * 8;
+            h.chars_offset = size;
+            h.chars_size = 0;
+        }
+    }
+
+    // Second pass: copy everything into one 8-byte aligned allocation.
+    std::shared_ptr<std::uint64_t[]> words(new std::uint64_t[size / 8]());
+    auto* data = reinterpret_cast<std::byte*>(words.get());
+
+    detail::FlatResultHeader head{detail::result_set_magic, detail::result_set_layout_version, size,
+                                  static_cast<std::uint32_t>(m_columns.size()), 0, rows};
+    std::memcpy(data, &head, sizeof(head));
+    std::memcpy(data + sizeof(head), headers.data(), headers.size() * sizeof(detail::FlatColumnHeader));
+
+    for (std::size_t c = 0; c < m_columns.size(); ++c) {
+        const Column& col = m_columns[c];
+        const auto& h = headers[c];
+        std::memcpy(data + h.name_offset, col.name.data(), col.name.size());
+        auto* nulls = reinterpret_cast<std::uint64_t*>(data + h.nulls_offset);
+        for (std::uint64_t r = 0; r < rows; ++r) {
+            if (col.nulls[r]) nulls[r / 64] |= std::uint64_t{1} << (r % 64);
+        }
+        switch (col.kind) {
+            case ResultSet::ColumnKind::integer:
+                std::memcpy(data + h.values_offset, col.integers.data(), rows * 8);
+                break;
+            case ResultSet::ColumnKind::real:
+                std::memcpy(data + h.values_offset, col.reals.data(), rows * 8);
+                break;
+            case ResultSet::ColumnKind::text:
+                std::memcpy(data + h.values_offset, col.offsets.data(), (rows + 1) * 8);
+                std::memcpy(data + h.chars_offset, col.chars.data(), h.chars_size);
+                break;
+        }
+    }
+
+    m_columns.clear();
+    return ResultSet(std::shared_ptr<const void>(words, words.get()), data);
+}
+
+
+/**
+ * @brief Maps an ODBC SQL data type to the column storage used by ResultSet.
+ *
+ * Exact numerics with a scale (DECIMAL/NUMERIC) are kept as text so that no
+ * precision is lost.
+ */
+inline ResultSet::ColumnKind column_kind_for(SQLSMALLINT sql_type) {
+    switch (sql_type) {
+        case SQL_BIT: case SQL_TINYINT: case SQL_SMALLINT: case SQL_INTEGER: case SQL_BIGINT:
+            return ResultSet::ColumnKind::integer;
+        case SQL_REAL: case SQL_FLOAT: case SQL_DOUBLE:
+            return ResultSet::ColumnKind::real;
+        default:
+            return ResultSet::ColumnKind::text;
+    }
+}
+
+/**
+ * @brief Fetches the remaining rows of an executed statement into a ResultSet.
+ *
+ * @param stmt A statement on which a query has been executed.
+ * @param max_rows Stop after this many rows (the cursor is left open).
+ * @return The materialized result, or the first ODBC error encountered.
+ */
+inline std::expected<ResultSet, OdbcError> materialize(Statement& stmt, std::size_t max_rows = static_cast<std::size_t>(-1)) {
+    auto column_count = stmt.num_result_cols();
+    if (!column_count) {
+        return std::unexpected(column_count.error());
+    }
+
+    ResultSetBuilder builder;
+    std::vector<ResultSet::ColumnKind> kinds;
+    for (SQLUSMALLINT c = 1; c <= static_cast<SQLUSMALLINT>(*column_count); ++c) {
+        auto description = stmt.describe_column(c);
+        if (!description) {
+            return std::unexpected(description.error());
+        }
+        kinds.push_back(column_kind_for(description->data_type));
+        builder.add_column(std::move(description->name), kinds.back(), description->data_type);
+    }
+
+    for (std::size_t row = 0; row < max_rows && *column_count > 0; ++row) {
+        auto fetch_res = stmt.fetch();
+        if (!fetch_res) {
+            return std::unexpected(fetch_res.error());
+        }
+        if (!*fetch_res) {
+            break;
+        }
+        for (std::size_t c = 0; c < kinds.size(); ++c) {
+            auto column_index = static_cast<SQLUSMALLINT>(c + 1);
+            switch (kinds[c]) {
+                case ResultSet::ColumnKind::integer: {
+                    auto value = stmt.get_data<long long>(column_index);
+                    if (!value) return std::unexpected(value.error());
+                    if (*value) builder.append(c, **value); else builder.append_null(c);
+                    break;
+                }
+                case ResultSet::ColumnKind::real: {
+                    auto value = stmt.get_data<double>(column_index);
+                    if (!value) return std::unexpected(value.error());
+                    if (*value) builder.append(c, **value); else builder.append_null(c);
+                    break;
+                }
+                case ResultSet::ColumnKind::text: {
+                    auto value = stmt.get_data<std::string>(column_index);
+                    if (!value) return std::unexpected(value.error());
+                    if (*value) builder.append(c, std::string_view(**value)); else builder.append_null(c);
+                    break;
+                }
+            }
+        }
+    }
+    return builder.build();
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_RESULT_SET_H
@@ -0,0 +1,424 @@
+#ifndef MODERN_ODBC_SHARDED_CONNECTION_POOL_H
+#define MODERN_ODBC_SHARDED_CONNECTION_POOL_H
+
+/**
+ * @file sharded_connection_pool.h
+ * @brief Provides a shared connection pool partitioned per CPU or per NUMA node.
+ *
+ * Unlike ThreadLocalConnectionPool, connections in this pool can be used by any
+ * thread. The pool is split into shards, one per CPU or one per NUMA node, and a
+ * checkout first looks at the shard of the CPU the caller is running on. Other
+ * shards are only visited when the local shard has no idle connection, so in the
+ * steady state a connection (and the driver buffers behind it) stays on the node
+ * that created it.
+ *
+ * Node-local allocation relies on the operating system's first-touch policy: a
+ * new connection is always created by the checking-out thread, i.e. on the node
+ * of its local shard, and it is always returned to that shard.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+// GetCurrentProcessorNumber() is provided by <Windows.h>, already included by odbc_wrapper.h.
+#else
+#include <sched.h>
+#endif
+
+/**
+ * @enum ShardingMode
+ * @brief Selects how a ShardedConnectionPool partitions its connections.
+ */
+enum class ShardingMode {
+    single,         ///< One shard shared by all CPUs (baseline, no partitioning).
+    per_cpu,        ///< One shard per logical CPU.
+    per_numa_node   ///< One shard per NUMA node.
+};
+
+/**
+ * @struct ShardingOptions
+ * @brief Configuration for a ShardedConnectionPool.
+ */
+struct ShardingOptions {
+    ShardingMode mode = ShardingMode::per_numa_node;
+    std::size_t max_connections_per_shard = 8;
+    std::chrono::milliseconds checkout_timeout{5000};
+};
+
+namespace odbc::detail {
+
+    /**
+     * @brief Parses a Linux cpulist string (e.g. "0-7,16-23") into CPU indexes.
+     */
+    inline std::vector<unsigned> parse_cpu_list(std::string_view list) {
+        std::vector<unsigned> cpus;
+        while (!list.empty()) {
+            auto comma = list.find(',');
+            std::string_view range = list.substr(0, comma);
+            list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+
+            auto to_unsigned = [](std::string_view text) {
+                unsigned value = 0;
+                for (char c : text) {
+                    if (c < '0' || c > '9') break;
+                    value = value * 10 + static_cast<unsigned>(c - '0');
+                }
+                return value;
+            };
+            while (!range.empty() && (range.back() == '\n' || range.back() == ' ')) range.remove_suffix(1);
+            if (range.empty()) continue;
+
+            if (auto dash = range.find('-'); dash != std::string_view::npos) {
+                for (unsigned cpu = to_unsigned(range.substr(0, dash)); cpu <= to_unsigned(range.substr(dash + 1)); ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            } else {
+                cpus.push_back(to_unsigned(range));
+            }
+        }
+        return cpus;
+    }
+
+    /**
+     * @struct CpuTopology
+     * @brief Maps logical CPUs to NUMA nodes.
+     *
+     * On Linux the mapping is read from /sys/devices/system/node. On other
+     * platforms, or when sysfs is unavailable, every CPU is reported on node 0.
+     */
+    struct CpuTopology {
+        std::vector<unsigned> cpu_to_node;
+        unsigned node_count = 1;
+
+        static const CpuTopology& instance() {
+            static const CpuTopology topology = detect();
+            return topology;
+        }
+
+    private:
+        static CpuTopology detect() {
+            CpuTopology topology;
+            topology.cpu_to_node.assign(std::max(1u, std::thread::hardware_concurrency()), 0);
+#ifdef __linux__
+            unsigned nodes_found = 0;
+            for (unsigned node = 0; node < 1024; ++node) {
+                std::ifstream file(std::format("/sys/devices/system/node/node{}/cpulist", node));
+                if (!file) {
+                    if (nodes_found > 0) break;
+                    continue;
+                }
+                std::string line;
+                std::getline(file, line);
+                for (unsigned cpu : parse_cpu_list(line)) {
+                    if (cpu >= topology.cpu_to_node.size()) topology.cpu_to_node.resize(cpu + 1, 0);
+                    topology.cpu_to_node[cpu] = node;
+                }
+                ++nodes_found;
+                topology.node_count = node + 1;
+            }
+#endif
+            return topology;
+        }
+    };
+
+    /**
+     * @brief Returns the logical CPU the calling thread is currently running on.
+     */
+    inline unsigned current_cpu() noexcept {
+#ifdef _WIN32
+        return static_cast<unsigned>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+        int cpu = sched_getcpu();
+        return cpu < 0 ? 0u : static_cast<unsigned>(cpu);
+#else
+        return 0u;
+#endif
+    }
+
+} // namespace odbc::detail
+
+
+class ShardedConnectionPool;
+
+/**
+ * @class PooledConnection
+ * @brief RAII lease on a connection checked out of a ShardedConnectionPool.
+ *
+ * The connection is returned to the shard that owns it when the lease is
+ * destroyed or release() is called.
+ */
+class PooledConnection {
+public:
+    PooledConnection(ShardedConnectionPool& pool, std::size_t shard, odbc::Connection connection)
+        : pool_(&pool), shard_(shard), connection_(std::move(connection)), checked_out_(std::chrono::steady_clock::now()) {}
+    ~PooledConnection();
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+    PooledConnection(PooledConnection&& other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)), shard_(other.shard_), connection_(std::move(other.connection_)),
+          checked_out_(other.checked_out_) {}
+    PooledConnection& operator=(PooledConnection&& other) noexcept;
+
+    [[nodiscard]] odbc::Connection& get() { return connection_; }
+    [[nodiscard]] odbc::Connection& operator*() { return connection_; }
+    [[nodiscard]] odbc::Connection* operator->() { return &connection_; }
+
+    /**
+     * @brief The shard that owns this connection.
+     */
+    [[nodiscard]] std::size_t shard() const { return shard_; }
+
+    /**
+     * @brief Returns the connection to its shard before the lease goes out of scope.
+     */
+    void release();
+
+private:
+    ShardedConnectionPool* pool_;
+    std::size_t shard_;
+    odbc::Connection connection_;
+    std::chrono::steady_clock::time_point checked_out_;
+};
+
+
+/**
+ * @class ShardedConnectionPool
+ * @brief A thread-safe connection pool for one database alias, partitioned per CPU or NUMA node.
+ *
+ * Each shard owns at most max_connections_per_shard connections and has its own
+ * mutex, so threads on different CPUs (or nodes) do not contend on a common lock.
+ * A checkout tries, in order:
+ *  1. an idle connection from the caller's local shard,
+ *  2. an idle connection stolen from a neighbouring shard (shards on the same
+ *     node first, then remote nodes),
+ *  3. a new connection owned by the local shard, if it is below capacity,
+ *  4. waiting for a connection to be returned, up to checkout_timeout.
+ */
+class ShardedConnectionPool {
+private:
+    /**
+     * @struct Shard
+     * @brief One partition of the pool, padded to its own cache line.
+     */
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::condition_variable returned;
+        std::vector<odbc::Connection> idle;
+        std::size_t open = 0;
+        unsigned node = 0;
+        std::vector<std::size_t> steal_order;
+    };
+
+    std::string alias_;
+    std::string connection_string_;
+    ShardingOptions options_;
+    odbc::Environment env_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::size_t> cpu_to_shard_;
+    std::shared_ptr<odbc::detail::PoolUsage> usage_;   // reported to pool_telemetry()
+
+    friend class PooledConnection;
+
+    PooledConnection lease(std::size_t shard_index, odbc::Connection connection, std::chrono::steady_clock::time_point started) {
+        usage_->active.fetch_add(1, std::memory_order_relaxed);
+        usage_->record_checkout(started);
+        return PooledConnection(*this, shard_index, std::move(connection));
+    }
+
+    void checkin(std::size_t shard_index, odbc::Connection connection, std::chrono::steady_clock::time_point checked_out) {
+        usage_->active.fetch_sub(1, std::memory_order_relaxed);
+        usage_->record_hold(checked_out);
+        Shard& shard = *shards_[shard_index];
+        {
+            std::scoped_lock lock(shard.mutex);
+            shard.idle.push_back(std::move(connection));
+        }
+        shard.returned.notify_one();
+    }
+
+    std::optional<odbc::Connection> try_take_idle(std::size_t shard_index) {
+        Shard& shard = *shards_[shard_index];
+        std::scoped_lock lock(shard.mutex);
+        if (shard.idle.empty()) {
+            return std::nullopt;
+        }
+        odbc::Connection connection = std::move(shard.idle.back());
+        shard.idle.pop_back();
+        return connection;
+    }
+
+    bool try_reserve(std::size_t shard_index) {
+        Shard& shard = *shards_[shard_index];
+        std::scoped_lock lock(shard.mutex);
+        if (shard.open >= options_.max_connections_per_shard) {
+            return false;
+        }
+        ++shard.open;
+        return true;
+    }
+
+    odbc::Connection open_connection(std::size_t shard_index) {
+        std::cerr << std::format("[Shard {}] Creating new connection for alias '{}'.\n", shard_index, alias_);
+        try {
+            odbc::Connection connection(env_);
+            const auto connect_started = std::chrono::steady_clock::now();
+            auto connect_res = connection.driver_connect(connection_string_);
+            usage_->record_connect(connect_started, connect_res.has_value());
+            if (!connect_res) {
+                throw ConnectionPoolError(std::format("Failed to establish connection for alias '{}': {}", alias_, connect_res.error().to_string()));
+            }
+            return connection;
+        } catch (...) {
+            Shard& shard = *shards_[shard_index];
+            std::scoped_lock lock(shard.mutex);
+            --shard.open;
+            throw;
+        }
+    }
+
+    void build_shards() {
+        const auto& topology = odbc::detail::CpuTopology::instance();
+        const std::size_t cpu_count = topology.cpu_to_node.size();
+
+        std::size_t shard_count = 1;
+        if (options_.mode == ShardingMode::per_cpu) {
+            shard_count = cpu_count;
+        } else if (options_.mode == ShardingMode::per_numa_node) {
+            shard_count = topology.node_count;
+        }
+
+        cpu_to_shard_.resize(cpu_count, 0);
+        for (std::size_t cpu = 0; cpu < cpu_count; ++cpu) {
+            if (options_.mode == ShardingMode::per_cpu) {
+                cpu_to_shard_[cpu] = cpu;
+            } else if (options_.mode == ShardingMode::per_numa_node) {
+                cpu_to_shard_[cpu] = topology.cpu_to_node[cpu];
+            }
+        }
+
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            auto shard = std::make_unique<Shard>();
+            shard->node = (options_.mode == ShardingMode::per_cpu) ? topology.cpu_to_node[i]
+                        : (options_.mode == ShardingMode::per_numa_node) ? static_cast<unsigned>(i) : 0u;
+            shards_.push_back(std::move(shard));
+        }
+
+        // Steal from shards on the same node first, nearest index first, then from remote nodes.
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            auto& order = shards_[i]->steal_order;
+            for (std::size_t step = 1; step < shard_count; ++step) {
+                order.push_back((i + step) % shard_count);
+            }
+            std::stable_partition(order.begin(), order.end(), [&](std::size_t other) {
+                return shards_[other]->node == shards_[i]->node;
+            });
+        }
+    }
+
+public:
+    /**
+     * @brief Creates an empty pool; connections are opened lazily on checkout.
+     *
+     * @param alias A name identifying the database, used in log and error messages.
+     * @param connection_string The full ODBC connection string for new connections.
+     * @param options Sharding mode, per-shard capacity and checkout timeout.
+     * @throws odbc::OdbcSetupError if the environment handle cannot be allocated.
+     */
+    ShardedConnectionPool(std::string alias, std::string connection_string, ShardingOptions options = {})
+        : alias_(std::move(alias)), connection_string_(std::move(connection_string)), options_(options),
+          usage_(odbc::detail::PoolTelemetryRegistry::instance().attach("sharded", alias_)) {
+        build_shards();
+    }
+
+    ShardedConnectionPool(const ShardedConnectionPool&) = delete;
+    ShardedConnectionPool& operator=(const ShardedConnectionPool&) = delete;
+
+    /**
+     * @brief Checks out a connection, preferring the caller's local shard.
+     *
+     * @return A lease that returns the connection to its shard on destruction.
+     * @throws ConnectionPoolError if a new connection fails to be established,
+     *         or if no connection becomes available within checkout_timeout.
+     */
+    [[nodiscard]] PooledConnection acquire() {
+        const std::size_t home = local_shard();
+        const auto started = std::chrono::steady_clock::now();
+        const auto deadline = started + options_.checkout_timeout;
+
+        for (;;) {
+            if (auto connection = try_take_idle(home)) {
+                return lease(home, std::move(*connection), started);
+            }
+            for (std::size_t neighbour : shards_[home]->steal_order) {
+                if (auto connection = try_take_idle(neighbour)) {
+                    return lease(neighbour, std::move(*connection), started);
+                }
+            }
+            if (try_reserve(home)) {
+                return lease(home, open_connection(home), started);
+            }
+
+            // Everything is checked out. Connections are returned to their owning shard,
+            // so wait on the local one in short slices and rescan the neighbours in between.
+            Shard& shard = *shards_[home];
+            std::unique_lock lock(shard.mutex);
+            auto slice = std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+            shard.returned.wait_until(lock, slice, [&] { return !shard.idle.empty(); });
+            if (shard.idle.empty() && std::chrono::steady_clock::now() >= deadline) {
+                usage_->record_timeout();
+                throw ConnectionPoolError(std::format("Timed out waiting for a connection for alias '{}'.", alias_));
+            }
+        }
+    }
+
+    /**
+     * @brief The shard serving the CPU the calling thread is running on.
+     */
+    [[nodiscard]] std::size_t local_shard() const noexcept {
+        unsigned cpu = odbc::detail::current_cpu();
+        return cpu < cpu_to_shard_.size() ? cpu_to_shard_[cpu] : cpu % shards_.size();
+    }
+
+    [[nodiscard]] std::size_t shard_count() const noexcept { return shards_.size(); }
+    [[nodiscard]] const std::string& alias() const noexcept { return alias_; }
+};
+
+
+inline PooledConnection::~PooledConnection() {
+    release();
+}
+
+inline PooledConnection& PooledConnection::operator=(PooledConnection&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        shard_ = other.shard_;
+        connection_ = std::move(other.connection_);
+        checked_out_ = other.checked_out_;
+    }
+    return *this;
+}
+
+inline void PooledConnection::release() {
+    if (pool_ != nullptr) {
+        std::exchange(pool_, nullptr)->checkin(shard_, std::move(connection_), checked_out_);
+    }
+}
+
+#endif // MODERN_ODBC_SHARDED_CONNECTION_POOL_H
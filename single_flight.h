@@ -0,0 +1,161 @@
+#ifndef MODERN_ODBC_SINGLE_FLIGHT_H
+#define MODERN_ODBC_SINGLE_FLIGHT_H
+
+/**
+ * @file single_flight.h
+ * @brief Collapses identical concurrent read queries into one execution.
+ *
+ * When many threads issue the same read at the same moment (a hot row or a
+ * configuration query during a traffic spike), only the first caller, the
+ * leader, executes it. Every other caller with the same key waits for the
+ * leader and receives the same immutable ResultSet, so the database sees one
+ * query instead of hundreds.
+ *
+ * Deduplication only covers calls that overlap in time; once the leader has
+ * finished, the next call executes again. Only use it for read-only queries
+ * whose result may be shared between callers.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "result_set.h"
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @brief Builds a key that identifies a query by alias, SQL text and parameter values.
+ *
+ * Each parameter is encoded with a type tag, so 1, 1.0 and '1' produce different keys.
+ */
+inline std::string make_query_key(std::string_view alias, std::string_view sql, const std::vector<Parameter>& parameters) {
+    std::string key;
+    key.reserve(alias.size() + sql.size() + 2 + parameters.size() * 10);
+    key.append(alias).push_back('\x1f');
+    key.append(sql).push_back('\x1f');
+    for (const auto& parameter : parameters) {
+        std::visit([&](const auto& value) {
+            using V = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<V, std::monostate>) {
+                key.push_back('N');
+            } else if constexpr (std::is_same_v<V, long long> || std::is_same_v<V, double>) {
+                key.push_back(std::is_same_v<V, long long> ? 'I' : 'R');
+                char bytes[sizeof(V)];
+                std::memcpy(bytes, &value, sizeof(V));
+                key.append(bytes, sizeof(V));
+            } else {
+                key.push_back('S');
+                auto length = static_cast<std::uint32_t>(value.size());
+                char bytes[sizeof(length)];
+                std::memcpy(bytes, &length, sizeof(length));
+                key.append(bytes, sizeof(length)).append(value);
+            }
+        }, parameter);
+    }
+    return key;
+}
+
+/**
+ * @class SingleFlight
+ * @brief Shares one in-flight execution among concurrent callers with the same key.
+ */
+class SingleFlight {
+public:
+    using Result = std::expected<ResultSet, OdbcError>;
+
+    /**
+     * @brief Runs load() unless an identical call is already in flight, then returns its result.
+     *
+     * @param key Identifies the work, e.g. from make_query_key().
+     * @param load Produces the result; only invoked by the leader.
+     * @return The leader's result. If load() throws, every waiting caller rethrows the exception.
+     */
+    template <typename F>
+    [[nodiscard]] Result run(const std::string& key, F&& load);
+
+    /**
+     * @brief Executes a read-only query through the thread-local pool, deduplicating concurrent identical calls.
+     *
+     * @param alias A unique string_view to identify the connection (e.g., "DB_PRIMARY").
+     * @param connection_string The full ODBC connection string.
+     * @param sql The query, optionally with '?' parameter markers.
+     * @param parameters Values for the parameter markers; part of the deduplication key.
+     * @throws ConnectionPoolError if the leader cannot obtain a connection.
+     */
+    [[nodiscard]] Result query(std::string_view alias, std::string_view connection_string,
+                               std::string_view sql, std::vector<Parameter> parameters = {});
+
+    /**
+     * @brief Number of distinct keys currently being executed.
+     */
+    [[nodiscard]] std::size_t in_flight() const {
+        std::scoped_lock lock(m_mutex);
+        return m_flights.size();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_future<Result>> m_flights;
+};
+
+
+// --- Implementation ---
+
+template <typename F>
+inline SingleFlight::Result SingleFlight::run(const std::string& key, F&& load) {
+    std::promise<Result> promise;
+    {
+        std::unique_lock lock(m_mutex);
+        if (auto it = m_flights.find(key); it != m_flights.end()) {
+            // Follower: wait for the leader outside the lock.
+            std::shared_future<Result> flight = it->second;
+            lock.unlock();
+            return flight.get();
+        }
+        m_flights.emplace(key, promise.get_future().share());
+    }
+
+    // Leader: the entry is removed before the result is published, so a caller
+    // arriving after this point starts a new flight instead of reading a stale one.
+    auto finish = [&] {
+        std::scoped_lock lock(m_mutex);
+        m_flights.erase(key);
+    };
+    try {
+        Result result = std::forward<F>(load)();
+        finish();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        finish();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+inline SingleFlight::Result SingleFlight::query(std::string_view alias, std::string_view connection_string,
+                                                std::string_view sql, std::vector<Parameter> parameters) {
+    const std::string key = make_query_key(alias, sql, parameters);
+    return run(key, [&]() -> Result {
+        auto stmt = getThreadLocalStatement(alias, connection_string);
+        if (auto exec_res = stmt->execute_direct(sql, std::move(parameters)); !exec_res) {
+            return std::unexpected(exec_res.error());
+        }
+        return materialize(*stmt);
+    });
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_SINGLE_FLIGHT_H
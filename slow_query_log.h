@@ -0,0 +1,448 @@
+#ifndef MODERN_ODBC_SLOW_QUERY_LOG_H
+#define MODERN_ODBC_SLOW_QUERY_LOG_H
+
+/**
+ * @file slow_query_log.h
+ * @brief Threshold-based slow statement log with sampled execution plan capture.
+ *
+ * A SlowQueryLog watches pool aliases. When a statement of a watched alias
+ * spends longer than the alias's threshold in execute plus fetch (measured
+ * from the execute to the end of its result set, see query_stats.h), one JSON
+ * line goes to an AsyncLogger: the fingerprint, the normalized and the
+ * executed text, a sample of the bound parameters, rows fetched, the
+ * execute / first-row / fetch breakdown and the client-side resource use
+ * (CPU time, allocations, bytes per column; see resource_usage.h).
+ *
+ * Every Nth slow statement of an alias is also queued for plan capture. A
+ * background thread re-runs it with its parameters inlined through the
+ * server's plan facility, on its own side connection, and logs the plan as a
+ * second line with the same fingerprint:
+ *   - SQL Server: SET SHOWPLAN_XML ON, so the query is compiled but not run;
+ *   - SQLite: EXPLAIN QUERY PLAN;
+ *   - PostgreSQL, MySQL and MariaDB: EXPLAIN.
+ * The statement's own thread only builds the record and pushes it into two
+ * bounded queues; when either is full the record is dropped and counted.
+ *
+ * Reporting relies on query statistics, so it needs the default
+ * instrumentation policy with query_stats_enabled(). Only one SlowQueryLog
+ * may exist at a time.
+ */
+
+#include "odbc_wrapper.h"
+#include "async_logger.h"
+#include "query_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct SlowQueryOptions
+ * @brief The slow-query settings of one alias.
+ */
+struct SlowQueryOptions {
+    std::chrono::milliseconds threshold{500};   ///< Execute plus fetch time at or above which a statement is logged.
+    std::string plan_connection_string;         ///< Side connection for plan capture; empty disables capture.
+    std::size_t plan_sample_every = 10;         ///< Capture the plan of every Nth slow statement; 0 disables capture.
+};
+
+/**
+ * @struct SlowQueryLogStats
+ * @brief Counters of a SlowQueryLog.
+ */
+struct SlowQueryLogStats {
+    std::uint64_t logged = 0;            ///< Slow statements handed to the logger.
+    std::uint64_t plans_captured = 0;
+    std::uint64_t plans_failed = 0;      ///< Connect or plan errors, unsupported servers, too many parameters.
+    std::uint64_t plans_dropped = 0;     ///< Plan captures skipped because the capture queue was full.
+};
+
+/**
+ * @class SlowQueryLog
+ * @brief Logs slow statements of watched aliases and samples their plans (see file comment).
+ */
+class SlowQueryLog {
+public:
+    /**
+     * @param logger Receives the JSON lines; must outlive this object.
+     * @param plan_queue_capacity Maximum number of plan captures waiting for the side connection.
+     * @throws std::logic_error if another SlowQueryLog exists.
+     */
+    explicit SlowQueryLog(AsyncLogger& logger, std::size_t plan_queue_capacity = 64);
+    ~SlowQueryLog();
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    /**
+     * @brief Starts (or reconfigures) logging for a pool alias. The empty alias
+     * covers statements that were not checked out of a pool.
+     */
+    void watch(std::string alias, SlowQueryOptions options);
+    void unwatch(const std::string& alias);
+
+    [[nodiscard]] SlowQueryLogStats stats() const noexcept;
+
+    /**
+     * @brief Waits until every plan capture queued so far has been logged or has failed.
+     */
+    void wait_for_plans();
+
+private:
+    struct Watch {
+        SlowQueryOptions options;
+        std::atomic<std::uint64_t> slow_count{0};
+    };
+
+    struct PlanJob {
+        std::string alias;
+        std::string connection_string;
+        std::uint64_t fingerprint = 0;
+        std::string query;   // the executed text with its parameters inlined
+    };
+
+    AsyncLogger& m_logger;
+    std::size_t m_plan_queue_capacity;
+    Environment m_env;
+
+    mutable std::shared_mutex m_watch_mutex;
+    std::map<std::string, std::unique_ptr<Watch>, std::less<>> m_watches;
+
+    std::mutex m_plan_mutex;
+    std::condition_variable m_plan_ready;
+    std::condition_variable m_plan_idle;
+    std::deque<PlanJob> m_plan_jobs;
+    bool m_plan_busy = false;
+    bool m_stopping = false;
+
+    std::atomic<std::uint64_t> m_logged{0};
+    std::atomic<std::uint64_t> m_plans_captured{0};
+    std::atomic<std::uint64_t> m_plans_failed{0};
+    std::atomic<std::uint64_t> m_plans_dropped{0};
+
+    std::thread m_plan_thread;
+
+    static void report(SlowStatement&& statement);
+    void record(SlowStatement&& statement);
+    void update_threshold_floor();
+    void plan_loop();
+    std::expected<std::string, OdbcError> capture_plan(BasicConnection<NullInstrumentation>& connection, const std::string& query);
+};
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    inline std::atomic<SlowQueryLog*> active_slow_query_log{nullptr};
+    inline std::atomic<int> slow_reports_in_flight{0};
+
+    inline std::string json_escape(std::string_view value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            switch (c) {
+                case '"': escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '\n': escaped += "\\n"; break;
+                case '\r': escaped += "\\r"; break;
+                case '\t': escaped += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        escaped += std::format("\\u{:04x}", static_cast<int>(c));
+                    } else {
+                        escaped += c;
+                    }
+            }
+        }
+        return escaped;
+    }
+
+    inline double to_ms(std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // Replaces each '?' marker outside string literals and quoted identifiers with
+    // the next literal. Returns std::nullopt if there are fewer literals than markers.
+    inline std::optional<std::string> inline_parameters(std::string_view text, const std::vector<std::string>& literals) {
+        std::string out;
+        out.reserve(text.size());
+        std::size_t next = 0;
+        char quote = 0;
+        for (char c : text) {
+            if (quote != 0) {
+                if (c == quote) quote = 0;   // a doubled quote re-enters the literal on the next character
+                out += c;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+                out += c;
+            } else if (c == '?') {
+                if (next == literals.size()) return std::nullopt;
+                out += literals[next++];
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+} // namespace detail
+
+inline SlowQueryLog::SlowQueryLog(AsyncLogger& logger, std::size_t plan_queue_capacity)
+    : m_logger(logger), m_plan_queue_capacity(std::max<std::size_t>(1, plan_queue_capacity)) {
+    SlowQueryLog* expected = nullptr;
+    if (!detail::active_slow_query_log.compare_exchange_strong(expected, this)) {
+        throw std::logic_error("SlowQueryLog: another slow-query log is already installed.");
+    }
+    try {
+        m_plan_thread = std::thread([this] { plan_loop(); });
+    } catch (...) {
+        detail::active_slow_query_log.store(nullptr);
+        throw;
+    }
+    detail::slow_statement_hook.store(&SlowQueryLog::report, std::memory_order_release);
+}
+
+inline SlowQueryLog::~SlowQueryLog() {
+    detail::slow_threshold_floor_ns.store(std::numeric_limits<std::int64_t>::max(), std::memory_order_relaxed);
+    detail::slow_statement_hook.store(nullptr, std::memory_order_release);
+    detail::active_slow_query_log.store(nullptr);
+    // Statements that already loaded the pointer finish their report first.
+    while (detail::slow_reports_in_flight.load() != 0) {
+        std::this_thread::yield();
+    }
+    {
+        std::scoped_lock lock(m_plan_mutex);
+        m_stopping = true;
+        m_plan_jobs.clear();
+    }
+    m_plan_ready.notify_all();
+    m_plan_thread.join();
+}
+
+inline void SlowQueryLog::watch(std::string alias, SlowQueryOptions options) {
+    {
+        std::unique_lock lock(m_watch_mutex);
+        auto& watch = m_watches[std::move(alias)];
+        if (!watch) watch = std::make_unique<Watch>();
+        watch->options = std::move(options);
+    }
+    update_threshold_floor();
+}
+
+inline void SlowQueryLog::unwatch(const std::string& alias) {
+    {
+        std::unique_lock lock(m_watch_mutex);
+        m_watches.erase(alias);
+    }
+    update_threshold_floor();
+}
+
+inline void SlowQueryLog::update_threshold_floor() {
+    std::shared_lock lock(m_watch_mutex);
+    std::int64_t floor = std::numeric_limits<std::int64_t>::max();
+    for (const auto& [alias, watch] : m_watches) {
+        floor = std::min<std::int64_t>(floor, std::chrono::nanoseconds(watch->options.threshold).count());
+    }
+    detail::slow_threshold_floor_ns.store(floor, std::memory_order_relaxed);
+}
+
+inline SlowQueryLogStats SlowQueryLog::stats() const noexcept {
+    return SlowQueryLogStats{m_logged.load(std::memory_order_relaxed), m_plans_captured.load(std::memory_order_relaxed),
+                             m_plans_failed.load(std::memory_order_relaxed), m_plans_dropped.load(std::memory_order_relaxed)};
+}
+
+inline void SlowQueryLog::wait_for_plans() {
+    std::unique_lock lock(m_plan_mutex);
+    m_plan_idle.wait(lock, [this] { return m_plan_jobs.empty() && !m_plan_busy; });
+}
+
+inline void SlowQueryLog::report(SlowStatement&& statement) {
+    detail::slow_reports_in_flight.fetch_add(1);
+    if (SlowQueryLog* log = detail::active_slow_query_log.load()) {
+        try {
+            log->record(std::move(statement));
+        } catch (...) {
+            // A lost record must not fail the statement that reported it.
+        }
+    }
+    detail::slow_reports_in_flight.fetch_sub(1);
+}
+
+inline void SlowQueryLog::record(SlowStatement&& statement) {
+    bool capture = false;
+    std::string plan_connection_string;
+    {
+        std::shared_lock lock(m_watch_mutex);
+        auto it = m_watches.find(statement.alias);
+        if (it == m_watches.end() || statement.total() < it->second->options.threshold) {
+            return;
+        }
+        const Watch& watch = *it->second;
+        const std::uint64_t count = it->second->slow_count.fetch_add(1, std::memory_order_relaxed);
+        capture = watch.options.plan_sample_every != 0 && !watch.options.plan_connection_string.empty() &&
+                  !statement.text.empty() && count % watch.options.plan_sample_every == 0;
+        if (capture) plan_connection_string = watch.options.plan_connection_string;
+    }
+
+    std::string parameters;
+    for (const auto& literal : statement.parameters) {
+        parameters += std::format("{}\"{}\"", parameters.empty() ? "" : ",", detail::json_escape(literal));
+    }
+    std::string column_bytes;
+    for (std::uint64_t bytes : statement.column_bytes) {
+        column_bytes += std::format("{}{}", column_bytes.empty() ? "" : ",", bytes);
+    }
+    std::string line = std::format(
+        "{{\"event\":\"slow_query\",\"alias\":\"{}\",\"fingerprint\":\"{:016x}\",\"query\":\"{}\",\"text\":\"{}\",\"parameters\":[{}],"
+        "\"rows\":{},\"failed\":{},\"total_ms\":{:.3f},\"execute_ms\":{:.3f},\"first_row_ms\":{:.3f},\"fetch_ms\":{:.3f},"
+        "\"cpu_ms\":{:.3f},\"allocations\":{},\"allocated_bytes\":{},\"column_bytes\":[{}]}}",
+        detail::json_escape(statement.alias), statement.fingerprint, detail::json_escape(statement.query), detail::json_escape(statement.text),
+        parameters, statement.rows, statement.failed, detail::to_ms(statement.total()), detail::to_ms(statement.execute),
+        detail::to_ms(statement.first_row), detail::to_ms(statement.fetch), detail::to_ms(statement.cpu_time), statement.allocations,
+        statement.allocated_bytes, column_bytes);
+    if (m_logger.log(std::move(line))) {
+        m_logged.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!capture) {
+        return;
+    }
+    auto query = detail::inline_parameters(statement.text, statement.parameters);
+    if (!query) {
+        m_plans_failed.fetch_add(1, std::memory_order_relaxed);   // more markers than sampled parameters
+        return;
+    }
+    {
+        std::scoped_lock lock(m_plan_mutex);
+        if (m_plan_jobs.size() >= m_plan_queue_capacity) {
+            m_plans_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_plan_jobs.push_back(PlanJob{std::move(statement.alias), std::move(plan_connection_string), statement.fingerprint, std::move(*query)});
+    }
+    m_plan_ready.notify_one();
+}
+
+inline void SlowQueryLog::plan_loop() {
+    // Side connections are owned by this thread; NullInstrumentation keeps the
+    // plan queries themselves out of the statistics and this log.
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<BasicConnection<NullInstrumentation>>> connections;
+    for (;;) {
+        PlanJob job;
+        {
+            std::unique_lock lock(m_plan_mutex);
+            m_plan_busy = false;
+            if (m_plan_jobs.empty()) m_plan_idle.notify_all();
+            m_plan_ready.wait(lock, [this] { return m_stopping || !m_plan_jobs.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            job = std::move(m_plan_jobs.front());
+            m_plan_jobs.pop_front();
+            m_plan_busy = true;
+        }
+
+        auto& connection = connections[{job.alias, job.connection_string}];
+        std::expected<std::string, OdbcError> plan;
+        try {
+            if (!connection) {
+                auto opened = std::make_unique<BasicConnection<NullInstrumentation>>(m_env);
+                if (auto connected = opened->driver_connect(job.connection_string); connected) {
+                    connection = std::move(opened);
+                } else {
+                    plan = std::unexpected(connected.error());
+                }
+            }
+            if (connection) {
+                plan = capture_plan(*connection, job.query);
+            }
+        } catch (const std::exception& e) {
+            plan = std::unexpected(OdbcError{"HY000", 0, e.what()});
+        }
+
+        if (plan) {
+            m_plans_captured.fetch_add(1, std::memory_order_relaxed);
+            (void)m_logger.log(std::format("{{\"event\":\"query_plan\",\"alias\":\"{}\",\"fingerprint\":\"{:016x}\",\"plan\":\"{}\"}}",
+                                           detail::json_escape(job.alias), job.fingerprint, detail::json_escape(*plan)));
+        } else {
+            m_plans_failed.fetch_add(1, std::memory_order_relaxed);
+            if (plan.error().sql_state.starts_with("08")) {
+                connection.reset();   // reconnect on the next capture
+            }
+            (void)m_logger.log(std::format("{{\"event\":\"query_plan_error\",\"alias\":\"{}\",\"fingerprint\":\"{:016x}\",\"error\":\"{}\"}}",
+                                           detail::json_escape(job.alias), job.fingerprint, detail::json_escape(plan.error().to_string())));
+        }
+    }
+}
+
+inline std::expected<std::string, OdbcError> SlowQueryLog::capture_plan(BasicConnection<NullInstrumentation>& connection, const std::string& query) {
+    auto dbms = connection.dbms_name();
+    if (!dbms) {
+        return std::unexpected(dbms.error());
+    }
+
+    BasicStatement<NullInstrumentation> stmt(connection);
+    // Plans come back as rows; the last column holds the plan text (the XML
+    // document, or SQLite's and EXPLAIN's detail column).
+    auto read_plan = [&]() -> std::expected<std::string, OdbcError> {
+        auto columns = stmt.num_result_cols();
+        if (!columns) return std::unexpected(columns.error());
+        std::string plan;
+        for (;;) {
+            auto fetched = stmt.fetch();
+            if (!fetched) return std::unexpected(fetched.error());
+            if (!*fetched) break;
+            auto value = stmt.get_data<std::string>(static_cast<SQLUSMALLINT>(*columns));
+            if (!value) return std::unexpected(value.error());
+            if (!plan.empty()) plan += '\n';
+            plan += value->value_or("");
+        }
+        (void)stmt.close_cursor();
+        return plan;
+    };
+
+    if (dbms->find("SQL Server") != std::string::npos) {
+        if (auto on = stmt.execute_direct("SET SHOWPLAN_XML ON"); !on) {
+            return std::unexpected(on.error());
+        }
+        auto executed = stmt.execute_direct(query);
+        auto plan = executed ? read_plan() : std::unexpected(executed.error());
+        (void)stmt.close_cursor();
+        (void)stmt.execute_direct("SET SHOWPLAN_XML OFF");
+        return plan;
+    }
+    std::string prefix;
+    if (dbms->find("SQLite") != std::string::npos) {
+        prefix = "EXPLAIN QUERY PLAN ";
+    } else if (dbms->find("PostgreSQL") != std::string::npos || dbms->find("MySQL") != std::string::npos ||
+               dbms->find("MariaDB") != std::string::npos) {
+        prefix = "EXPLAIN ";
+    } else {
+        return std::unexpected(OdbcError{"HYC00", 0, std::format("No plan facility known for '{}'", *dbms)});
+    }
+    if (auto executed = stmt.execute_direct(prefix + query); !executed) {
+        return std::unexpected(executed.error());
+    }
+    return read_plan();
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_SLOW_QUERY_LOG_H
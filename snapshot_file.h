@@ -0,0 +1,454 @@
+#ifndef MODERN_ODBC_SNAPSHOT_FILE_H
+#define MODERN_ODBC_SNAPSHOT_FILE_H
+
+/**
+ * @file snapshot_file.h
+ * @brief Versioned, checksummed snapshot files of ResultSets that are used in place via mmap.
+ *
+ * A snapshot file stores named ResultSets in their flat in-memory layout, so
+ * loading one is a single mmap: every ResultSet returned by MappedSnapshot points
+ * directly into the mapping and keeps it alive. Reference tables and result
+ * caches write one at shutdown (or periodically) and read it at startup to serve
+ * immediately while they revalidate against the database in the background,
+ * instead of every instance reloading everything at once after a deploy.
+ *
+ * Typical warm start of a reference table:
+ * @code
+ *   odbc::ReferenceTableOptions options{...};
+ *   if (auto file = odbc::MappedSnapshot::open("ref.snap"); file) {
+ *       if (const auto* entry = file->find("currencies")) {
+ *           options.initial_data = entry->data;
+ *           options.initial_version = std::string(entry->metadata);
+ *       }
+ *   }
+ * @endcode
+ *
+ * File layout, all little-endian and 8-byte aligned:
+ *   SnapshotFileHeader
+ *   SnapshotEntryHeader[entry_count]
+ *   names and metadata strings
+ *   one flat ResultSet buffer per entry
+ */
+
+#include "odbc_wrapper.h"
+#include "result_set.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace odbc {
+
+namespace detail {
+
+    inline constexpr std::uint32_t snapshot_magic = 0x4E53444Fu; // "ODSN"
+    inline constexpr std::uint32_t snapshot_format_version = 1;
+
+    /**
+     * @struct SnapshotFileHeader
+     * @brief Start of a snapshot file. The checksum covers every byte after the header.
+     */
+    struct SnapshotFileHeader {
+        std::uint32_t magic;
+        std::uint32_t format_version;
+        std::uint32_t result_layout_version;
+        std::uint32_t reserved;
+        std::uint64_t entry_count;
+        std::uint64_t total_size;
+        std::uint64_t checksum;
+        std::int64_t created_unix_ms;
+    };
+
+    /**
+     * @struct SnapshotEntryHeader
+     * @brief Location of one named ResultSet; offsets are from the start of the file.
+     */
+    struct SnapshotEntryHeader {
+        std::uint64_t name_offset;
+        std::uint64_t name_length;
+        std::uint64_t metadata_offset;
+        std::uint64_t metadata_length;
+        std::uint64_t data_offset;
+        std::uint64_t data_size;
+    };
+
+    /**
+     * @brief FNV-1a over 64-bit words; the checksummed region is always a multiple of 8 bytes.
+     */
+    inline std::uint64_t snapshot_checksum(const std::byte* data, std::size_t size) noexcept {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (std::size_t offset = 0; offset + 8 <= size; offset += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data + offset, 8);
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    inline OdbcError snapshot_error(std::string message) {
+        return OdbcError{"HY000", 0, std::move(message)};
+    }
+
+    inline std::atomic<std::uint64_t> snapshot_temporary_ids{0};
+
+    /**
+     * @brief Writes bytes to a new file beside path, flushes it to disk and renames it over path.
+     */
+    inline std::expected<void, OdbcError> replace_file(const std::filesystem::path& path, std::span<const std::byte> bytes);
+
+} // namespace detail
+
+/**
+ * @class SnapshotWriter
+ * @brief Collects named ResultSets and writes them to a snapshot file.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Adds a result. The ResultSet is shared, not copied, until write().
+     * @param name Identifies the entry, e.g. a reference table name or a cache key.
+     * @param metadata Opaque text stored with the entry, e.g. the table version.
+     */
+    void add(std::string name, std::string metadata, ResultSet data) {
+        m_entries.push_back(Entry{std::move(name), std::move(metadata), std::move(data)});
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_entries.size(); }
+
+    /**
+     * @brief Writes the file atomically: the bytes go to a uniquely named temporary file
+     *        next to path, are flushed to disk and the file is then renamed over path.
+     *
+     * Readers see either the previous file or the complete new one, also after a crash.
+     * Concurrent writers of the same path do not interfere; the last rename wins. The
+     * temporary file is removed on every error.
+     */
+    [[nodiscard]] std::expected<void, OdbcError> write(const std::filesystem::path& path) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string metadata;
+        ResultSet data;
+    };
+    std::vector<Entry> m_entries;
+};
+
+/**
+ * @class MappedSnapshot
+ * @brief A read-only memory mapping of a snapshot file.
+ *
+ * Entries are not parsed or copied; the ResultSets returned by find() reference
+ * the mapping, which stays alive until the last of them and the MappedSnapshot are gone.
+ */
+class MappedSnapshot {
+public:
+    /**
+     * @struct Entry
+     * @brief One named result in the snapshot.
+     */
+    struct Entry {
+        std::string_view name;
+        std::string_view metadata;
+        ResultSet data;
+    };
+
+    /**
+     * @brief Maps a snapshot file and validates its header and entry table.
+     * @param verify_checksum Also checksums the whole file, which reads every page once.
+     */
+    [[nodiscard]] static std::expected<MappedSnapshot, OdbcError> open(const std::filesystem::path& path, bool verify_checksum = true);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_entries.size(); }
+    [[nodiscard]] const std::vector<Entry>& entries() const noexcept { return m_entries; }
+
+    /**
+     * @brief Finds an entry by name.
+     */
+    [[nodiscard]] const Entry* find(std::string_view name) const {
+        for (const auto& entry : m_entries) {
+            if (entry.name == name) return &entry;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] std::chrono::system_clock::time_point created_at() const noexcept { return m_created_at; }
+
+private:
+    struct Mapping;
+
+    std::shared_ptr<const Mapping> m_mapping;
+    std::vector<Entry> m_entries;
+    std::chrono::system_clock::time_point m_created_at;
+};
+
+
+// --- Implementation ---
+
+inline std::expected<void, OdbcError> SnapshotWriter::write(const std::filesystem::path& path) const {
+    using detail::align8;
+
+    // Lay the file out first so every offset is known before writing.
+    std::vector<detail::SnapshotEntryHeader> headers(m_entries.size());
+    std::uint64_t offset = sizeof(detail::SnapshotFileHeader) + headers.size() * sizeof(detail::SnapshotEntryHeader);
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        headers[i].name_offset = offset;
+        headers[i].name_length = m_entries[i].name.size();
+        offset += m_entries[i].name.size();
+        headers[i].metadata_offset = offset;
+        headers[i].metadata_length = m_entries[i].metadata.size();
+        offset += m_entries[i].metadata.size();
+    }
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        offset = align8(offset);
+        headers[i].data_offset = offset;
+        headers[i].data_size = m_entries[i].data.memory_bytes();
+        offset += headers[i].data_size;
+    }
+    const std::uint64_t total_size = align8(offset);
+
+    std::vector<std::byte> file(total_size);
+    auto put = [&](std::uint64_t at, const void* data, std::size_t size) {
+        if (size > 0) std::memcpy(file.data() + at, data, size);
+    };
+    put(sizeof(detail::SnapshotFileHeader), headers.data(), headers.size() * sizeof(detail::SnapshotEntryHeader));
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        put(headers[i].name_offset, m_entries[i].name.data(), m_entries[i].name.size());
+        put(headers[i].metadata_offset, m_entries[i].metadata.data(), m_entries[i].metadata.size());
+        auto bytes = m_entries[i].data.flat_bytes();
+        put(headers[i].data_offset, bytes.data(), bytes.size());
+    }
+
+    detail::SnapshotFileHeader header{};
+    header.magic = detail::snapshot_magic;
+    header.format_version = detail::snapshot_format_version;
+    header.result_layout_version = detail::result_set_layout_version;
+    header.entry_count = m_entries.size();
+    header.total_size = total_size;
+    header.checksum = detail::snapshot_checksum(file.data() + sizeof(header), file.size() - sizeof(header));
+    header.created_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    put(0, &header, sizeof(header));
+
+    return detail::replace_file(path, file);
+}
+
+inline std::expected<void, OdbcError> detail::replace_file(const std::filesystem::path& path, std::span<const std::byte> bytes) {
+    // The process id and a counter make the name unique; creation still refuses to
+    // reuse an existing file, e.g. one left behind by a writer that crashed.
+#ifdef _WIN32
+    const auto process = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+    const auto process = static_cast<long>(::getpid());
+#endif
+    std::filesystem::path temporary;
+    auto next_temporary = [&] {
+        temporary = path;
+        temporary += std::format(".{}.{}.tmp", process, snapshot_temporary_ids.fetch_add(1, std::memory_order_relaxed));
+    };
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 16 && file == INVALID_HANDLE_VALUE; ++attempt) {
+        next_temporary();
+        file = CreateFileW(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS) break;
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::unexpected(snapshot_error(std::format("Cannot create snapshot '{}': error {}", temporary.string(), GetLastError())));
+    }
+    auto fail = [&](std::string_view what, const std::filesystem::path& target) {
+        const DWORD error = GetLastError();
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        DeleteFileW(temporary.c_str());
+        return std::unexpected(snapshot_error(std::format("Failed to {} snapshot '{}': error {}", what, target.string(), error)));
+    };
+    for (std::size_t done = 0; done < bytes.size();) {
+        const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(bytes.size() - done, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(file, bytes.data() + done, chunk, &written, nullptr)) return fail("write", temporary);
+        done += written;
+    }
+    if (!FlushFileBuffers(file)) return fail("flush", temporary);
+    if (!CloseHandle(std::exchange(file, INVALID_HANDLE_VALUE))) return fail("close", temporary);
+    if (!MoveFileExW(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        return fail("replace", path);
+    }
+#else
+    int fd = -1;
+    for (int attempt = 0; attempt < 16 && fd < 0; ++attempt) {
+        next_temporary();
+        fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0 && errno != EEXIST) break;
+    }
+    if (fd < 0) {
+        return std::unexpected(snapshot_error(std::format("Cannot create snapshot '{}': {}", temporary.string(), std::strerror(errno))));
+    }
+    auto fail = [&](std::string_view what, const std::filesystem::path& target) {
+        const int error = errno;
+        if (fd >= 0) ::close(fd);
+        ::unlink(temporary.c_str());
+        return std::unexpected(snapshot_error(std::format("Failed to {} snapshot '{}': {}", what, target.string(), std::strerror(error))));
+    };
+    for (std::size_t done = 0; done < bytes.size();) {
+        const ssize_t written = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return fail("write", temporary);
+        }
+        done += static_cast<std::size_t>(written);
+    }
+    // Without the fsync a crash after the rename can leave path empty.
+    if (::fsync(fd) != 0) return fail("flush", temporary);
+    if (::close(std::exchange(fd, -1)) != 0) return fail("close", temporary);
+    if (::rename(temporary.c_str(), path.c_str()) != 0) return fail("replace", path);
+
+    // Best effort: persist the rename itself.
+    const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    if (const int dir = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); dir >= 0) {
+        (void)::fsync(dir);
+        ::close(dir);
+    }
+#endif
+    return {};
+}
+
+/**
+ * @struct MappedSnapshot::Mapping
+ * @brief Owns the mapped view of the file.
+ */
+struct MappedSnapshot::Mapping {
+    const std::byte* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    Mapping() = default;
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+#ifdef _WIN32
+        if (data != nullptr) UnmapViewOfFile(data);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data != nullptr) munmap(const_cast<std::byte*>(data), size);
+#endif
+    }
+};
+
+inline std::expected<MappedSnapshot, OdbcError> MappedSnapshot::open(const std::filesystem::path& path, bool verify_checksum) {
+    auto mapping = std::make_shared<Mapping>();
+    const std::string name = path.string();
+
+#ifdef _WIN32
+    mapping->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        return std::unexpected(detail::snapshot_error(std::format("Cannot open snapshot '{}'.", name)));
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(mapping->file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(detail::SnapshotFileHeader))) {
+        return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' is truncated.", name)));
+    }
+    mapping->size = static_cast<std::size_t>(file_size.QuadPart);
+    mapping->mapping = CreateFileMappingW(mapping->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping->mapping != nullptr) {
+        mapping->data = static_cast<const std::byte*>(MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (mapping->data == nullptr) {
+        return std::unexpected(detail::snapshot_error(std::format("Cannot map snapshot '{}'.", name)));
+    }
+#else
+    const int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(detail::snapshot_error(std::format("Cannot open snapshot '{}'.", name)));
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(detail::SnapshotFileHeader))) {
+        ::close(fd);
+        return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' is truncated.", name)));
+    }
+    void* view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping stays valid without the descriptor
+    if (view == MAP_FAILED) {
+        return std::unexpected(detail::snapshot_error(std::format("Cannot map snapshot '{}'.", name)));
+    }
+    mapping->data = static_cast<const std::byte*>(view);
+    mapping->size = static_cast<std::size_t>(info.st_size);
+#endif
+
+    const std::byte* data = mapping->data;
+    const auto& header = *reinterpret_cast<const detail::SnapshotFileHeader*>(data);
+    if (header.magic != detail::snapshot_magic || header.format_version != detail::snapshot_format_version
+        || header.result_layout_version != detail::result_set_layout_version) {
+        return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' has an unsupported format.", name)));
+    }
+    if (header.total_size > mapping->size || header.total_size % 8 != 0
+        || header.entry_count > (header.total_size - sizeof(header)) / sizeof(detail::SnapshotEntryHeader)) {
+        return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' is truncated.", name)));
+    }
+    if (verify_checksum && detail::snapshot_checksum(data + sizeof(header), header.total_size - sizeof(header)) != header.checksum) {
+        return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' failed its checksum.", name)));
+    }
+
+    MappedSnapshot snapshot;
+    snapshot.m_created_at = std::chrono::system_clock::time_point(std::chrono::milliseconds(header.created_unix_ms));
+    const auto* entries = reinterpret_cast<const detail::SnapshotEntryHeader*>(data + sizeof(header));
+    for (std::uint64_t i = 0; i < header.entry_count; ++i) {
+        const auto& entry = entries[i];
+        auto fits = [&](std::uint64_t offset, std::uint64_t length) {
+            return offset <= header.total_size && length <= header.total_size - offset;
+        };
+        if (!fits(entry.name_offset, entry.name_length) || !fits(entry.metadata_offset, entry.metadata_length)
+            || !fits(entry.data_offset, entry.data_size)) {
+            return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' has a corrupt entry table.", name)));
+        }
+        ResultSet result;
+        if (entry.data_size > 0) {
+            auto mapped = ResultSet::from_flat(mapping, data + entry.data_offset, static_cast<std::size_t>(entry.data_size));
+            if (!mapped) {
+                return std::unexpected(detail::snapshot_error(std::format("Snapshot '{}' has a corrupt result.", name)));
+            }
+            result = std::move(*mapped);
+        }
+        snapshot.m_entries.push_back(Entry{
+            {reinterpret_cast<const char*>(data + entry.name_offset), static_cast<std::size_t>(entry.name_length)},
+            {reinterpret_cast<const char*>(data + entry.metadata_offset), static_cast<std::size_t>(entry.metadata_length)},
+            std::move(result)});
+    }
+    snapshot.m_mapping = std::move(mapping);
+    return snapshot;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_SNAPSHOT_FILE_H
@@ -0,0 +1,53 @@
+#ifndef MODERN_ODBC_SQL_TEXT_H
+#define MODERN_ODBC_SQL_TEXT_H
+
+/**
+ * @file sql_text.h
+ * @brief Small helpers for generating and inspecting SQL text.
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace odbc {
+
+/**
+ * @brief The token in a query template that is replaced by a list of parameter markers.
+ *
+ * Example: "SELECT id, name FROM customers WHERE id IN ({keys})".
+ */
+inline constexpr std::string_view in_list_placeholder = "{keys}";
+
+/**
+ * @brief Checks whether a query template contains the IN-list placeholder.
+ */
+[[nodiscard]] inline bool has_in_list_placeholder(std::string_view query_template) {
+    return query_template.find(in_list_placeholder) != std::string_view::npos;
+}
+
+/**
+ * @brief Replaces the IN-list placeholder with count parameter markers ("?, ?, ?").
+ *
+ * @param query_template A query containing in_list_placeholder exactly once.
+ * @param count The number of markers; must be at least 1.
+ * @return The expanded query, or the template unchanged if it has no placeholder.
+ */
+[[nodiscard]] inline std::string expand_in_list(std::string_view query_template, std::size_t count) {
+    auto pos = query_template.find(in_list_placeholder);
+    if (pos == std::string_view::npos) {
+        return std::string(query_template);
+    }
+    std::string query;
+    query.reserve(query_template.size() + count * 3);
+    query.append(query_template.substr(0, pos));
+    for (std::size_t i = 0; i < count; ++i) {
+        query.append(i == 0 ? "?" : ", ?");
+    }
+    query.append(query_template.substr(pos + in_list_placeholder.size()));
+    return query;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_SQL_TEXT_H
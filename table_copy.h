@@ -0,0 +1,374 @@
+#ifndef MODERN_ODBC_TABLE_COPY_H
+#define MODERN_ODBC_TABLE_COPY_H
+
+/**
+ * @file table_copy.h
+ * @brief Pipelined copy of a query result into a table on another connection.
+ *
+ * copy_table() runs the source query on a reader thread that block-fetches
+ * (see BlockCursor) into a small ring of parameter buffers, while the calling
+ * thread array-inserts (see execute_array()) the filled buffers into the
+ * destination table. Fetching the next block therefore overlaps with inserting
+ * the previous one, and no row passes through application code one at a time.
+ *
+ * The destination columns are the source result's column names, bound with the
+ * types reported by SQLDescribeCol. Inserts run with autocommit off and are
+ * committed every commit_rows rows, so an interrupted copy keeps what was
+ * committed and a failed one rolls back only its last partial chunk.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "bulk.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @struct TableCopyProgress
+ * @brief How far a copy_table() call has come.
+ */
+struct TableCopyProgress {
+    std::uint64_t rows_copied = 0;      ///< Rows committed to the destination.
+    std::uint64_t blocks = 0;           ///< Blocks inserted.
+    std::uint64_t commits = 0;
+    std::chrono::milliseconds elapsed{0};
+};
+
+/**
+ * @struct TableCopyOptions
+ * @brief Tuning for copy_table().
+ */
+struct TableCopyOptions {
+    std::size_t block_rows = 1000;                 ///< Rows per fetch and per insert round trip.
+    std::size_t ring_blocks = 4;                   ///< Blocks buffered between the reader and the writer.
+    std::size_t max_text_length = 4096;            ///< Longest text value; longer values fail the copy rather than truncate.
+    std::size_t commit_rows = 50000;               ///< Rows per destination transaction; 0 commits once at the end.
+    std::vector<Parameter> source_parameters;      ///< Values for '?' markers in the source query.
+    std::function<void(const TableCopyProgress&)> on_progress;   ///< Called after every commit.
+};
+
+/**
+ * @brief Copies the result of src_query on one connection into dst_table on another.
+ *
+ * The source query runs on a connection of a dedicated reader thread; the inserts
+ * use the calling thread's pooled connection for dst_alias, which must not have an
+ * open transaction of its own. Autocommit is switched back on before returning.
+ *
+ * @param src_alias, src_connection_string The source connection.
+ * @param src_query The query whose result is copied; its column names must exist in dst_table.
+ * @param dst_alias, dst_connection_string The destination connection.
+ * @param dst_table The destination table.
+ * @param options Block size, ring depth, commit interval and progress callback.
+ * @return The final progress, or the first error of either side. Rows of earlier
+ *         commits stay in the destination after an error.
+ */
+[[nodiscard]] std::expected<TableCopyProgress, OdbcError> copy_table(std::string_view src_alias, std::string_view src_connection_string,
+                                                                     std::string_view src_query,
+                                                                     std::string_view dst_alias, std::string_view dst_connection_string,
+                                                                     std::string_view dst_table, const TableCopyOptions& options = {});
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    /**
+     * @class CopyRing
+     * @brief Hands filled parameter buffers from the reader to the writer and empty ones back.
+     */
+    class CopyRing {
+    public:
+        CopyRing(std::size_t blocks, std::size_t columns) {
+            m_buffers.reserve(blocks);
+            for (std::size_t i = 0; i < blocks; ++i) {
+                m_buffers.emplace_back(columns);
+                m_free.push_back(i);
+            }
+        }
+
+        ParameterArray& buffer(std::size_t index) { return m_buffers[index]; }
+
+        // Reader side: an empty buffer, or nullopt once the writer has given up.
+        std::optional<std::size_t> acquire_free() {
+            std::unique_lock lock(m_mutex);
+            m_changed.wait(lock, [&] { return !m_free.empty() || m_cancelled; });
+            if (m_cancelled) return std::nullopt;
+            const std::size_t index = m_free.front();
+            m_free.pop_front();
+            return index;
+        }
+
+        void publish(std::size_t index) {
+            {
+                std::scoped_lock lock(m_mutex);
+                m_full.push_back(index);
+            }
+            m_changed.notify_all();
+        }
+
+        void finish(std::optional<OdbcError> error) {
+            {
+                std::scoped_lock lock(m_mutex);
+                m_finished = true;
+                m_error = std::move(error);
+            }
+            m_changed.notify_all();
+        }
+
+        // Writer side: a filled buffer, or nullopt when the reader is done.
+        std::optional<std::size_t> acquire_full() {
+            std::unique_lock lock(m_mutex);
+            m_changed.wait(lock, [&] { return !m_full.empty() || m_finished; });
+            if (m_full.empty()) return std::nullopt;
+            const std::size_t index = m_full.front();
+            m_full.pop_front();
+            return index;
+        }
+
+        void release(std::size_t index) {
+            {
+                std::scoped_lock lock(m_mutex);
+                m_free.push_back(index);
+            }
+            m_changed.notify_all();
+        }
+
+        void cancel() {
+            {
+                std::scoped_lock lock(m_mutex);
+                m_cancelled = true;
+            }
+            m_changed.notify_all();
+        }
+
+        std::optional<OdbcError> reader_error() {
+            std::scoped_lock lock(m_mutex);
+            return m_error;
+        }
+
+    private:
+        std::vector<ParameterArray> m_buffers;
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::deque<std::size_t> m_free;
+        std::deque<std::size_t> m_full;
+        bool m_finished = false;
+        bool m_cancelled = false;
+        std::optional<OdbcError> m_error;
+    };
+
+    struct CopySource {
+        std::vector<std::string> column_names;
+        std::vector<ResultSet::ColumnKind> column_kinds;
+    };
+
+} // namespace detail
+
+inline std::expected<TableCopyProgress, OdbcError> copy_table(std::string_view src_alias, std::string_view src_connection_string,
+                                                              std::string_view src_query,
+                                                              std::string_view dst_alias, std::string_view dst_connection_string,
+                                                              std::string_view dst_table, const TableCopyOptions& options) {
+    const auto started = std::chrono::steady_clock::now();
+    const std::size_t block_rows = std::max<std::size_t>(1, options.block_rows);
+
+    // The reader describes the result first; the writer needs the columns to prepare its INSERT.
+    std::mutex describe_mutex;
+    std::condition_variable described;
+    std::optional<std::expected<detail::CopySource, OdbcError>> source;
+    std::unique_ptr<detail::CopyRing> ring;
+
+    std::jthread reader([&] {
+        auto fail = [&](OdbcError error) {
+            std::scoped_lock lock(describe_mutex);
+            if (!source) {
+                source = std::unexpected(std::move(error));
+                described.notify_all();
+            } else {
+                ring->finish(std::move(error));
+            }
+        };
+        try {
+            auto stmt = getThreadLocalStatement(src_alias, src_connection_string);
+            auto exec_res = options.source_parameters.empty()
+                ? stmt->execute_direct(src_query)
+                : stmt->execute_direct(src_query, options.source_parameters);
+            if (!exec_res) {
+                fail(exec_res.error());
+                return;
+            }
+            auto cursor = BlockCursor::open(*stmt, block_rows, options.max_text_length);
+            if (!cursor) {
+                fail(cursor.error());
+                return;
+            }
+
+            detail::CopySource description;
+            for (std::size_t c = 0; c < cursor->column_count(); ++c) {
+                description.column_names.emplace_back(cursor->column_name(c));
+                description.column_kinds.push_back(cursor->column_kind(c));
+            }
+            {
+                std::scoped_lock lock(describe_mutex);
+                ring = std::make_unique<detail::CopyRing>(std::max<std::size_t>(2, options.ring_blocks), cursor->column_count());
+                source = std::move(description);
+            }
+            described.notify_all();
+
+            std::vector<Parameter> row(cursor->column_count());
+            for (;;) {
+                auto index = ring->acquire_free();
+                if (!index) {
+                    break;   // the writer failed
+                }
+                auto rows = cursor->fetch_block();
+                if (!rows) {
+                    ring->release(*index);
+                    ring->finish(rows.error());
+                    return;
+                }
+                if (*rows == 0) {
+                    ring->release(*index);
+                    break;
+                }
+
+                ParameterArray& buffer = ring->buffer(*index);
+                buffer.clear();
+                for (std::size_t r = 0; r < *rows; ++r) {
+                    for (std::size_t c = 0; c < row.size(); ++c) {
+                        if (cursor->is_truncated(r, c)) {
+                            ring->release(*index);
+                            ring->finish(OdbcError{"01004", 0, std::format("Value of column '{}' is longer than max_text_length ({}).",
+                                                                          cursor->column_name(c), options.max_text_length)});
+                            return;
+                        }
+                        switch (cursor->column_kind(c)) {
+                            case ResultSet::ColumnKind::integer: row[c] = cursor->get<long long>(r, c).transform([](long long v) { return Parameter{v}; }).value_or(Parameter{}); break;
+                            case ResultSet::ColumnKind::real: row[c] = cursor->get<double>(r, c).transform([](double v) { return Parameter{v}; }).value_or(Parameter{}); break;
+                            case ResultSet::ColumnKind::text: row[c] = cursor->get<std::string>(r, c).transform([](std::string v) { return Parameter{std::move(v)}; }).value_or(Parameter{}); break;
+                        }
+                    }
+                    buffer.add_row(row);
+                }
+                ring->publish(*index);
+            }
+            (void)stmt->close_cursor();
+            ring->finish(std::nullopt);
+        } catch (const ConnectionPoolError& e) {
+            fail(OdbcError{"08001", 0, e.what()});
+        } catch (const std::exception& e) {
+            fail(OdbcError{"HY000", 0, e.what()});
+        }
+    });
+
+    {
+        std::unique_lock lock(describe_mutex);
+        described.wait(lock, [&] { return source.has_value(); });
+    }
+    if (!*source) {
+        return std::unexpected(source->error());
+    }
+    const detail::CopySource& description = **source;
+
+    std::string names;
+    std::string markers;
+    for (const auto& name : description.column_names) {
+        names += std::format("{}{}", names.empty() ? "" : ", ", name);
+        markers += markers.empty() ? "?" : ", ?";
+    }
+    const std::string insert = std::format("INSERT INTO {} ({}) VALUES ({})", dst_table, names, markers);
+
+    TableCopyProgress progress;
+    std::uint64_t uncommitted = 0;
+    std::optional<OdbcError> error;
+    Connection* connection = nullptr;
+    try {
+        connection = &getThreadLocalConnection(dst_alias, dst_connection_string);
+        Statement stmt(*connection);
+        if (auto off = connection->set_autocommit(false); !off) {
+            connection = nullptr;
+            error = off.error();
+        } else if (auto prepared = stmt.prepare(insert); !prepared) {
+            error = prepared.error();
+        }
+
+        auto commit = [&]() -> bool {
+            if (auto committed = connection->commit(); !committed) {
+                error = committed.error();
+                return false;
+            }
+            progress.rows_copied += std::exchange(uncommitted, 0);
+            ++progress.commits;
+            progress.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            if (options.on_progress) {
+                options.on_progress(progress);
+            }
+            return true;
+        };
+
+        while (!error) {
+            auto index = ring->acquire_full();
+            if (!index) {
+                error = ring->reader_error();
+                if (!error && uncommitted > 0) {
+                    (void)commit();
+                }
+                break;
+            }
+            ParameterArray& buffer = ring->buffer(*index);
+            for (std::size_t c = 0; c < description.column_kinds.size(); ++c) {
+                buffer.set_column_kind(c, description.column_kinds[c]);
+            }
+            auto inserted = execute_array(stmt, buffer, block_rows);
+            const std::size_t rows = buffer.rows();
+            ring->release(*index);
+            if (!inserted) {
+                error = inserted.error();
+                break;
+            }
+            ++progress.blocks;
+            uncommitted += rows;
+            if (options.commit_rows > 0 && uncommitted >= options.commit_rows && !commit()) {
+                break;
+            }
+        }
+    } catch (const ConnectionPoolError& e) {
+        error = OdbcError{"08001", 0, e.what()};
+    } catch (const std::exception& e) {
+        error = OdbcError{"HY000", 0, e.what()};
+    }
+
+    ring->cancel();
+    reader.join();
+    if (connection != nullptr) {
+        if (error) {
+            (void)connection->rollback();
+        }
+        (void)connection->set_autocommit(true);
+    }
+    if (error) {
+        return std::unexpected(*error);
+    }
+    progress.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return progress;
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_TABLE_COPY_H
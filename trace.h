@@ -0,0 +1,310 @@
+#ifndef MODERN_ODBC_TRACE_H
+#define MODERN_ODBC_TRACE_H
+
+/**
+ * @file trace.h
+ * @brief Per-thread phase tracing of ODBC calls with Chrome trace export.
+ *
+ * When tracing is enabled, Connection::driver_connect() and the Statement calls
+ * (prepare, execute, the first fetch after an execute, further fetches and
+ * get_data) each record a span: start and end time-stamp counter ticks, the
+ * phase and the handle it ran on. Spans go into a fixed-size ring owned by the
+ * recording thread, so recording takes no lock and allocates nothing; the oldest
+ * spans are overwritten when a ring is full.
+ *
+ * export_chrome_trace() converts every thread's ring into Chrome trace-event
+ * JSON, which chrome://tracing and Perfetto display as a timeline.
+ *
+ * While tracing is disabled a TraceScope costs one relaxed load and a branch;
+ * code built with NullInstrumentation (see instrumentation.h) has no scopes at all.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MODERN_ODBC_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define MODERN_ODBC_HAS_RDTSC 1
+#endif
+
+namespace odbc {
+
+/**
+ * @enum TracePhase
+ * @brief The part of a database call a span covers.
+ */
+enum class TracePhase : std::uint8_t {
+    connect,
+    prepare,
+    execute,
+    first_row,   ///< The first fetch after an execute: the server's time to the first row.
+    fetch,
+    get_data     ///< Reading and converting one column value.
+};
+
+[[nodiscard]] constexpr std::string_view trace_phase_name(TracePhase phase) noexcept {
+    switch (phase) {
+        case TracePhase::connect: return "connect";
+        case TracePhase::prepare: return "prepare";
+        case TracePhase::execute: return "execute";
+        case TracePhase::first_row: return "first_row";
+        case TracePhase::fetch: return "fetch";
+        case TracePhase::get_data: return "get_data";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Turns span recording on or off for all threads.
+ */
+void set_tracing(bool enabled) noexcept;
+[[nodiscard]] bool tracing_enabled() noexcept;
+
+/**
+ * @brief Discards the spans recorded so far.
+ */
+void clear_traces();
+
+/**
+ * @brief Renders all recorded spans as Chrome trace-event JSON ({"traceEvents": [...]}).
+ */
+[[nodiscard]] std::string export_chrome_trace();
+
+/**
+ * @brief Writes export_chrome_trace() to a file.
+ * @return false if the file could not be written.
+ */
+bool write_chrome_trace(const std::filesystem::path& path);
+
+
+// --- Implementation ---
+
+namespace detail {
+
+    alignas(64) inline std::atomic<bool> tracing_on{false};
+
+    inline std::uint64_t trace_ticks() noexcept {
+#ifdef MODERN_ODBC_HAS_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /**
+     * @class TraceRing
+     * @brief A single-writer ring of spans; readers copy it while the owner keeps writing.
+     */
+    class TraceRing {
+    public:
+        static constexpr std::size_t capacity = 8192;   // power of two
+
+        struct Span {
+            std::uint64_t start = 0;
+            std::uint64_t end = 0;
+            std::uint64_t object = 0;
+            TracePhase phase = TracePhase::execute;
+        };
+
+        explicit TraceRing(std::uint32_t thread_index) : m_thread_index(thread_index) {}
+
+        void record(TracePhase phase, std::uint64_t start, std::uint64_t end, const void* object) noexcept {
+            const std::uint64_t index = m_head.load(std::memory_order_relaxed);
+            Slot& slot = m_slots[index & (capacity - 1)];
+            slot.start.store(start, std::memory_order_relaxed);
+            slot.end.store(end, std::memory_order_relaxed);
+            slot.object.store(reinterpret_cast<std::uintptr_t>(object), std::memory_order_relaxed);
+            slot.phase.store(static_cast<std::uint8_t>(phase), std::memory_order_relaxed);
+            m_head.store(index + 1, std::memory_order_release);
+        }
+
+        // Copies the spans still in the ring, oldest first. Slots the writer may have
+        // overwritten during the copy are dropped.
+        [[nodiscard]] std::vector<Span> snapshot() const {
+            const std::uint64_t head = m_head.load(std::memory_order_acquire);
+            const std::uint64_t first = std::max(m_cleared.load(std::memory_order_relaxed), head > capacity ? head - capacity : 0);
+            std::vector<Span> spans;
+            spans.reserve(static_cast<std::size_t>(head - first));
+            for (std::uint64_t i = first; i < head; ++i) {
+                const Slot& slot = m_slots[i & (capacity - 1)];
+                spans.push_back(Span{slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed),
+                                     slot.object.load(std::memory_order_relaxed),
+                                     static_cast<TracePhase>(slot.phase.load(std::memory_order_relaxed))});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // The slot at the new head may be half written, hence the + 1.
+            const std::uint64_t overwritten = m_head.load(std::memory_order_relaxed) + 1;
+            if (overwritten > first + capacity) {
+                const auto stale = static_cast<std::size_t>(std::min<std::uint64_t>(spans.size(), overwritten - first - capacity));
+                spans.erase(spans.begin(), spans.begin() + static_cast<std::ptrdiff_t>(stale));
+            }
+            return spans;
+        }
+
+        void clear() noexcept { m_cleared.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed); }
+
+        [[nodiscard]] std::uint32_t thread_index() const noexcept { return m_thread_index; }
+
+        // Set when the owning thread exits; the spans stay exportable until pruned.
+        std::atomic<bool> retired{false};
+
+    private:
+        struct Slot {
+            std::atomic<std::uint64_t> start{0};
+            std::atomic<std::uint64_t> end{0};
+            std::atomic<std::uint64_t> object{0};
+            std::atomic<std::uint8_t> phase{0};
+        };
+
+        std::uint32_t m_thread_index;
+        alignas(64) std::atomic<std::uint64_t> m_head{0};
+        std::atomic<std::uint64_t> m_cleared{0};
+        std::array<Slot, capacity> m_slots{};
+    };
+
+    /**
+     * @struct TraceRegistry
+     * @brief Every thread's ring, kept after the thread exits so its spans can still be exported.
+     */
+    struct TraceRegistry {
+        static constexpr std::size_t max_retired_rings = 64;
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<TraceRing>> rings;
+        // Reference point for converting ticks to wall-clock microseconds.
+        std::uint64_t origin_ticks = trace_ticks();
+        std::chrono::steady_clock::time_point origin_time = std::chrono::steady_clock::now();
+    };
+
+    inline TraceRegistry& trace_registry() {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    inline TraceRing& local_trace_ring() {
+        struct Owner {
+            std::shared_ptr<TraceRing> ring;
+            ~Owner() { ring->retired.store(true, std::memory_order_relaxed); }
+        };
+        thread_local Owner owner{[] {
+            auto& registry = trace_registry();
+            std::scoped_lock lock(registry.mutex);
+            // Short-lived threads would otherwise accumulate rings; keep only the newest retired ones.
+            auto excess = std::ranges::count_if(registry.rings, [](const auto& r) { return r->retired.load(std::memory_order_relaxed); })
+                - static_cast<std::ptrdiff_t>(TraceRegistry::max_retired_rings);
+            std::erase_if(registry.rings, [&](const auto& r) {
+                if (excess <= 0 || !r->retired.load(std::memory_order_relaxed)) return false;
+                --excess;
+                return true;
+            });
+            static std::uint32_t next_thread_index = 1;
+            auto created = std::make_shared<TraceRing>(next_thread_index++);
+            registry.rings.push_back(created);
+            return created;
+        }()};
+        return *owner.ring;
+    }
+
+} // namespace detail
+
+/**
+ * @class TraceScope
+ * @brief Records one span from construction to destruction if tracing is enabled.
+ */
+class TraceScope {
+public:
+    TraceScope(TracePhase phase, const void* object) noexcept {
+        if (detail::tracing_on.load(std::memory_order_relaxed)) [[unlikely]] {
+            m_object = object;
+            m_phase = phase;
+            m_start = detail::trace_ticks();
+            m_active = true;
+        }
+    }
+
+    ~TraceScope() {
+        if (m_active) [[unlikely]] {
+            detail::local_trace_ring().record(m_phase, m_start, detail::trace_ticks(), m_object);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const void* m_object = nullptr;
+    std::uint64_t m_start = 0;
+    TracePhase m_phase = TracePhase::execute;
+    bool m_active = false;
+};
+
+inline void set_tracing(bool enabled) noexcept {
+    (void)detail::trace_registry();   // fix the tick origin before the first span
+    detail::tracing_on.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool tracing_enabled() noexcept { return detail::tracing_on.load(std::memory_order_relaxed); }
+
+inline void clear_traces() {
+    auto& registry = detail::trace_registry();
+    std::scoped_lock lock(registry.mutex);
+    std::erase_if(registry.rings, [](const auto& ring) { return ring->retired.load(std::memory_order_relaxed); });
+    for (const auto& ring : registry.rings) {
+        ring->clear();
+    }
+}
+
+inline std::string export_chrome_trace() {
+    auto& registry = detail::trace_registry();
+    std::vector<std::shared_ptr<detail::TraceRing>> rings;
+    {
+        std::scoped_lock lock(registry.mutex);
+        rings = registry.rings;
+    }
+
+    // Calibrate ticks against the steady clock over the whole recording period.
+    const std::uint64_t now_ticks = detail::trace_ticks();
+    const auto now_time = std::chrono::steady_clock::now();
+    const double elapsed_us = std::chrono::duration<double, std::micro>(now_time - registry.origin_time).count();
+    const double ticks = static_cast<double>(now_ticks - registry.origin_ticks);
+    const double us_per_tick = ticks > 0 ? elapsed_us / ticks : 0.0;
+    auto to_us = [&](std::uint64_t tick) { return static_cast<double>(static_cast<std::int64_t>(tick - registry.origin_ticks)) * us_per_tick; };
+
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& ring : rings) {
+        for (const auto& span : ring->snapshot()) {
+            json += std::format("{}{{\"name\":\"{}\",\"cat\":\"odbc\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{},\"args\":{{\"handle\":\"{:#x}\"}}}}",
+                                first ? "" : ",", trace_phase_name(span.phase), to_us(span.start),
+                                static_cast<double>(span.end - span.start) * us_per_tick, ring->thread_index(), span.object);
+            first = false;
+        }
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
+inline bool write_chrome_trace(const std::filesystem::path& path) {
+    std::ofstream out(path, std::ios::trunc);
+    out << export_chrome_trace();
+    return static_cast<bool>(out.flush());
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_TRACE_H
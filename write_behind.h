@@ -0,0 +1,506 @@
+#ifndef MODERN_ODBC_WRITE_BEHIND_H
+#define MODERN_ODBC_WRITE_BEHIND_H
+
+/**
+ * @file write_behind.h
+ * @brief Asynchronous, batched inserts for rows that need not block the request.
+ *
+ * Request threads push typed rows into a bounded lock-free queue and return
+ * immediately. A flusher thread drains the queue into multi-row array inserts
+ * (see execute_array()) on its own connection, either every flush_interval or
+ * as soon as a full batch is waiting.
+ *
+ * When the queue is full the overflow policy decides: drop the row, block the
+ * caller until there is room, or spill the row to a local file that the
+ * flusher replays once the database keeps up again. Batches that fail to
+ * insert are spilled as well when a spill file is configured. The destructor
+ * flushes everything that was queued.
+ */
+
+#include "odbc_wrapper.h"
+#include "connection_pool.h"
+#include "bulk.h"
+#include "mpmc_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace odbc {
+
+/**
+ * @enum OverflowPolicy
+ * @brief What push() does when the queue is full.
+ */
+enum class OverflowPolicy {
+    drop,    ///< Discard the row and count it.
+    block,   ///< Wait until the flusher has made room.
+    spill    ///< Append the row to WriteBehindOptions::spill_file.
+};
+
+/**
+ * @struct WriteBehindOptions
+ * @brief Configuration for a WriteBehindQueue.
+ */
+struct WriteBehindOptions {
+    std::size_t capacity = 8192;                   ///< Queued rows, rounded up to a power of two.
+    std::size_t batch_rows = 500;                  ///< Rows per INSERT round trip.
+    std::chrono::milliseconds flush_interval{200}; ///< Longest time a row waits in a partial batch.
+    OverflowPolicy overflow = OverflowPolicy::drop;
+    std::filesystem::path spill_file;              ///< Required for OverflowPolicy::spill; also receives failed batches.
+};
+
+/**
+ * @struct WriteBehindStats
+ * @brief Counters and flush latencies of a WriteBehindQueue.
+ */
+struct WriteBehindStats {
+    std::size_t queue_depth = 0;
+    std::uint64_t enqueued = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t spilled = 0;
+    std::uint64_t flushed_rows = 0;
+    std::uint64_t failed_rows = 0;                 ///< Rows lost because a batch failed and nothing could be spilled.
+    std::uint64_t flushes = 0;                     ///< Batches inserted.
+    std::chrono::microseconds last_flush_latency{0};
+    std::chrono::microseconds max_flush_latency{0};
+    std::chrono::microseconds total_flush_latency{0};
+};
+
+namespace detail {
+
+    template <typename T>
+    Parameter to_parameter(T&& value) {
+        using V = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<V, Parameter> || std::is_same_v<V, std::monostate>) {
+            return Parameter{std::forward<T>(value)};
+        } else if constexpr (std::is_same_v<V, bool> || std::is_integral_v<V>) {
+            return Parameter{static_cast<long long>(value)};
+        } else if constexpr (std::is_floating_point_v<V>) {
+            return Parameter{static_cast<double>(value)};
+        } else if constexpr (requires { value.has_value(); *value; }) {
+            return value ? to_parameter(*std::forward<T>(value)) : Parameter{};
+        } else {
+            static_assert(std::is_convertible_v<T, std::string>, "Write-behind columns must be numbers, strings, std::optional or odbc::Parameter");
+            return Parameter{std::string(std::forward<T>(value))};
+        }
+    }
+
+    // Spill file record: a 4-byte length, then per value a type tag ('N', 'I', 'R', 'S')
+    // followed by 8 bytes for numbers or a 4-byte length and the bytes for text.
+    inline std::string encode_spill_row(const std::vector<Parameter>& row) {
+        std::string payload;
+        for (const auto& value : row) {
+            std::visit([&](const auto& v) {
+                using V = std::decay_t<decltype(v)>;
+                if constexpr (std::is_same_v<V, std::monostate>) {
+                    payload.push_back('N');
+                } else if constexpr (std::is_same_v<V, long long> || std::is_same_v<V, double>) {
+                    payload.push_back(std::is_same_v<V, long long> ? 'I' : 'R');
+                    payload.append(reinterpret_cast<const char*>(&v), sizeof(v));
+                } else {
+                    payload.push_back('S');
+                    const auto length = static_cast<std::uint32_t>(v.size());
+                    payload.append(reinterpret_cast<const char*>(&length), sizeof(length)).append(v);
+                }
+            }, value);
+        }
+        const auto length = static_cast<std::uint32_t>(payload.size());
+        return std::string(reinterpret_cast<const char*>(&length), sizeof(length)) + payload;
+    }
+
+    inline std::optional<std::vector<Parameter>> decode_spill_row(std::istream& in) {
+        std::uint32_t length = 0;
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) return std::nullopt;
+        std::string payload(length, '\0');
+        if (!in.read(payload.data(), length)) return std::nullopt;
+
+        std::vector<Parameter> row;
+        std::size_t pos = 0;
+        auto read = [&](void* out, std::size_t size) {
+            if (payload.size() - pos < size) return false;
+            std::memcpy(out, payload.data() + pos, size);
+            pos += size;
+            return true;
+        };
+        while (pos < payload.size()) {
+            const char tag = payload[pos++];
+            if (tag == 'N') {
+                row.emplace_back();
+            } else if (tag == 'I') {
+                long long value = 0;
+                if (!read(&value, sizeof(value))) return std::nullopt;
+                row.emplace_back(value);
+            } else if (tag == 'R') {
+                double value = 0;
+                if (!read(&value, sizeof(value))) return std::nullopt;
+                row.emplace_back(value);
+            } else if (tag == 'S') {
+                std::uint32_t size = 0;
+                if (!read(&size, sizeof(size)) || payload.size() - pos < size) return std::nullopt;
+                row.emplace_back(payload.substr(pos, size));
+                pos += size;
+            } else {
+                return std::nullopt;
+            }
+        }
+        return row;
+    }
+
+} // namespace detail
+
+/**
+ * @class WriteBehindQueue
+ * @brief Queues typed rows for one table and inserts them in batches on a background thread.
+ * @tparam Columns The column types of a row: integers, floating point, strings, std::optional of those, or Parameter.
+ */
+template <typename... Columns>
+class WriteBehindQueue {
+public:
+    using Row = std::tuple<Columns...>;
+
+    /**
+     * @param alias A unique string to identify the connection (e.g., "DB_AUDIT").
+     * @param connection_string The full ODBC connection string.
+     * @param table The target table.
+     * @param columns The target column names, one per element of Columns.
+     * @param options Capacity, batching and overflow policy.
+     * @throws OdbcSetupError if the column count does not match or spilling lacks a file.
+     */
+    WriteBehindQueue(std::string alias, std::string connection_string, std::string table,
+                     std::vector<std::string> columns, WriteBehindOptions options = {});
+
+    /**
+     * @brief Flushes every queued and spilled row, then stops the flusher.
+     */
+    ~WriteBehindQueue();
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    /**
+     * @brief Queues a row without waiting for the database.
+     * @return false if the row was dropped because the queue was full.
+     */
+    bool push(Columns... values);
+
+    /**
+     * @brief Waits until every row pushed before this call has been flushed (or has failed).
+     */
+    void flush();
+
+    [[nodiscard]] WriteBehindStats stats() const;
+
+    /**
+     * @brief The generated INSERT statement.
+     */
+    [[nodiscard]] const std::string& insert_query() const noexcept { return m_insert_query; }
+
+private:
+    std::string m_alias;
+    std::string m_connection_string;
+    std::string m_insert_query;
+    WriteBehindOptions m_options;
+    MpmcQueue<Row> m_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_flushed;
+    bool m_stopping = false;
+    std::uint64_t m_flush_requests = 0;
+    std::uint64_t m_flush_cycles = 0;
+
+    std::mutex m_spill_mutex;
+
+    std::atomic<std::uint64_t> m_enqueued{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<std::uint64_t> m_spilled{0};
+    std::atomic<std::uint64_t> m_flushed_rows{0};
+    std::atomic<std::uint64_t> m_failed_rows{0};
+    std::atomic<std::uint64_t> m_flushes{0};
+    std::atomic<std::int64_t> m_last_latency_us{0};
+    std::atomic<std::int64_t> m_max_latency_us{0};
+    std::atomic<std::int64_t> m_total_latency_us{0};
+
+    std::thread m_thread;
+
+    static std::vector<Parameter> to_parameters(Row& row) {
+        return std::apply([](auto&... values) { return std::vector<Parameter>{detail::to_parameter(std::move(values))...}; }, row);
+    }
+
+    void run();
+    bool drain(std::optional<PooledStatement>& stmt);
+    void replay_spill(std::optional<PooledStatement>& stmt);
+    bool insert_batch(std::optional<PooledStatement>& stmt, const ParameterArray& batch, bool replaying = false);
+    void spill(const std::vector<std::vector<Parameter>>& rows, bool replaying = false);
+};
+
+
+// --- Implementation ---
+
+template <typename... Columns>
+inline WriteBehindQueue<Columns...>::WriteBehindQueue(std::string alias, std::string connection_string, std::string table,
+                                                      std::vector<std::string> columns, WriteBehindOptions options)
+    : m_alias(std::move(alias)), m_connection_string(std::move(connection_string)),
+      m_options(std::move(options)), m_queue(m_options.capacity) {
+    if (columns.size() != sizeof...(Columns)) {
+        throw OdbcSetupError(std::format("WriteBehindQueue for '{}' has {} column names for {} column types.", table, columns.size(), sizeof...(Columns)));
+    }
+    if (m_options.overflow == OverflowPolicy::spill && m_options.spill_file.empty()) {
+        throw OdbcSetupError("OverflowPolicy::spill requires a spill_file.");
+    }
+    m_options.batch_rows = std::max<std::size_t>(1, m_options.batch_rows);
+
+    std::string names;
+    std::string markers;
+    for (const auto& column : columns) {
+        names += std::format("{}{}", names.empty() ? "" : ", ", column);
+        markers += markers.empty() ? "?" : ", ?";
+    }
+    m_insert_query = std::format("INSERT INTO {} ({}) VALUES ({})", table, names, markers);
+    m_thread = std::thread([this] { run(); });
+}
+
+template <typename... Columns>
+inline WriteBehindQueue<Columns...>::~WriteBehindQueue() {
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    m_thread.join();
+}
+
+template <typename... Columns>
+inline bool WriteBehindQueue<Columns...>::push(Columns... values) {
+    Row row(std::move(values)...);
+    if (!m_queue.try_push(row)) {
+        switch (m_options.overflow) {
+            case OverflowPolicy::drop:
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::spill:
+                spill({to_parameters(row)});
+                return true;
+            case OverflowPolicy::block: {
+                m_wakeup.notify_one();
+                auto backoff = std::chrono::microseconds(1);
+                while (!m_queue.try_push(row)) {
+                    std::this_thread::sleep_for(backoff);
+                    backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+                }
+                break;
+            }
+        }
+    }
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    // Only wake the flusher for a full batch; partial batches wait for the interval.
+    if (m_queue.size_approx() >= m_options.batch_rows) {
+        m_wakeup.notify_one();
+    }
+    return true;
+}
+
+template <typename... Columns>
+inline void WriteBehindQueue<Columns...>::flush() {
+    std::unique_lock lock(m_mutex);
+    // Wait for a complete cycle that starts after this request.
+    const std::uint64_t target = m_flush_cycles + 2;
+    ++m_flush_requests;
+    m_wakeup.notify_all();
+    m_flushed.wait(lock, [&] { return m_flush_cycles >= target || m_stopping; });
+}
+
+template <typename... Columns>
+inline WriteBehindStats WriteBehindQueue<Columns...>::stats() const {
+    WriteBehindStats stats;
+    stats.queue_depth = m_queue.size_approx();
+    stats.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.spilled = m_spilled.load(std::memory_order_relaxed);
+    stats.flushed_rows = m_flushed_rows.load(std::memory_order_relaxed);
+    stats.failed_rows = m_failed_rows.load(std::memory_order_relaxed);
+    stats.flushes = m_flushes.load(std::memory_order_relaxed);
+    stats.last_flush_latency = std::chrono::microseconds(m_last_latency_us.load(std::memory_order_relaxed));
+    stats.max_flush_latency = std::chrono::microseconds(m_max_latency_us.load(std::memory_order_relaxed));
+    stats.total_flush_latency = std::chrono::microseconds(m_total_latency_us.load(std::memory_order_relaxed));
+    return stats;
+}
+
+template <typename... Columns>
+inline void WriteBehindQueue<Columns...>::run() {
+    std::optional<PooledStatement> stmt;   // prepared once on this thread's connection
+    std::uint64_t handled_requests = 0;
+    for (;;) {
+        bool stopping = false;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wakeup.wait_for(lock, m_options.flush_interval, [&] {
+                return m_stopping || m_flush_requests != handled_requests || m_queue.size_approx() >= m_options.batch_rows;
+            });
+            stopping = m_stopping;
+            handled_requests = m_flush_requests;
+        }
+
+        const bool healthy = drain(stmt);
+        if (healthy && !m_options.spill_file.empty()) {
+            replay_spill(stmt);
+        }
+
+        {
+            std::scoped_lock lock(m_mutex);
+            ++m_flush_cycles;
+        }
+        m_flushed.notify_all();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+// Inserts everything currently queued; returns false if a batch failed.
+template <typename... Columns>
+inline bool WriteBehindQueue<Columns...>::drain(std::optional<PooledStatement>& stmt) {
+    bool healthy = true;
+    ParameterArray batch(sizeof...(Columns));
+    batch.reserve(m_options.batch_rows);
+    for (;;) {
+        batch.clear();
+        while (batch.rows() < m_options.batch_rows) {
+            auto row = m_queue.try_pop();
+            if (!row) break;
+            batch.add_row(to_parameters(*row));
+        }
+        if (batch.empty()) {
+            return healthy;
+        }
+        healthy = insert_batch(stmt, batch) && healthy;
+    }
+}
+
+template <typename... Columns>
+inline bool WriteBehindQueue<Columns...>::insert_batch(std::optional<PooledStatement>& stmt, const ParameterArray& batch, bool replaying) {
+    const auto started = std::chrono::steady_clock::now();
+    std::optional<OdbcError> error;
+    try {
+        if (!stmt) {
+            stmt.emplace(getThreadLocalStatement(m_alias, m_connection_string));
+            if (auto prepared = (*stmt)->prepare(m_insert_query); !prepared) {
+                error = prepared.error();
+            }
+        }
+        if (!error) {
+            if (auto inserted = execute_array(stmt->get(), batch, m_options.batch_rows); !inserted) {
+                error = inserted.error();
+            }
+        }
+    } catch (const std::exception& e) {
+        error = OdbcError{"08001", 0, e.what()};
+    }
+
+    if (error) {
+        stmt.reset();   // re-prepare, possibly on a new connection, next time
+        std::cerr << std::format("[WriteBehindQueue] Insert of {} rows failed: {}\n", batch.rows(), error->to_string());
+        if (m_options.spill_file.empty()) {
+            m_failed_rows.fetch_add(batch.rows(), std::memory_order_relaxed);
+        } else {
+            std::vector<std::vector<Parameter>> rows;
+            for (std::size_t r = 0; r < batch.rows(); ++r) {
+                std::vector<Parameter> row;
+                for (std::size_t c = 0; c < batch.columns(); ++c) row.push_back(batch.at(r, c));
+                rows.push_back(std::move(row));
+            }
+            spill(rows, replaying);
+        }
+        return false;
+    }
+
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+    m_last_latency_us.store(latency, std::memory_order_relaxed);
+    m_total_latency_us.fetch_add(latency, std::memory_order_relaxed);
+    for (auto max = m_max_latency_us.load(std::memory_order_relaxed);
+         latency > max && !m_max_latency_us.compare_exchange_weak(max, latency, std::memory_order_relaxed);) {}
+    m_flushes.fetch_add(1, std::memory_order_relaxed);
+    m_flushed_rows.fetch_add(batch.rows(), std::memory_order_relaxed);
+    return true;
+}
+
+template <typename... Columns>
+inline void WriteBehindQueue<Columns...>::spill(const std::vector<std::vector<Parameter>>& rows, bool replaying) {
+    std::scoped_lock lock(m_spill_mutex);
+    std::ofstream out(m_options.spill_file, std::ios::binary | std::ios::app);
+    for (const auto& row : rows) {
+        out << detail::encode_spill_row(row);
+    }
+    if (!out.flush()) {
+        std::cerr << std::format("[WriteBehindQueue] Cannot write spill file '{}'; {} rows lost.\n", m_options.spill_file.string(), rows.size());
+        m_failed_rows.fetch_add(rows.size(), std::memory_order_relaxed);
+        return;
+    }
+    if (!replaying) {
+        m_spilled.fetch_add(rows.size(), std::memory_order_relaxed);
+    }
+}
+
+template <typename... Columns>
+inline void WriteBehindQueue<Columns...>::replay_spill(std::optional<PooledStatement>& stmt) {
+    std::filesystem::path replay = m_options.spill_file;
+    replay += ".replay";
+    {
+        // Take the current spill file; rows spilled from now on go to a new one.
+        std::scoped_lock lock(m_spill_mutex);
+        std::error_code ec;
+        if (!std::filesystem::exists(replay, ec)) {
+            if (!std::filesystem::exists(m_options.spill_file, ec)) return;
+            std::filesystem::rename(m_options.spill_file, replay, ec);
+            if (ec) return;
+        }
+    }
+
+    std::ifstream in(replay, std::ios::binary);
+    ParameterArray batch(sizeof...(Columns));
+    bool done = false;
+    while (!done) {
+        batch.clear();
+        while (batch.rows() < m_options.batch_rows) {
+            auto row = detail::decode_spill_row(in);
+            if (!row) {
+                done = true;
+                break;
+            }
+            batch.add_row(*row);
+        }
+        // insert_batch() spills a failed batch again; the unread rest follows it and waits for the next cycle.
+        if (!batch.empty() && !insert_batch(stmt, batch, true)) {
+            std::vector<std::vector<Parameter>> rest;
+            while (auto row = detail::decode_spill_row(in)) rest.push_back(std::move(*row));
+            spill(rest, true);
+            break;
+        }
+    }
+    in.close();
+    std::error_code ec;
+    std::filesystem::remove(replay, ec);
+}
+
+} // namespace odbc
+
+#endif // MODERN_ODBC_WRITE_BEHIND_H